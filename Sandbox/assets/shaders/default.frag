@@ -1,62 +1,24 @@
 #version 430 core
 
-struct Material 
+// parameters of material are uploaded once per change, not on every draw
+layout(std140) uniform MaterialParameters
 {
     vec3 Ambient;
     vec3 Specular;
     vec3 Diffuse;
     float ReflectionFactor;
     float Shininess;
-};
+} u_Material;
 
 in flat uint TextureId;
 in vec2 TextureCoords;
 in vec3 FragPosWS;
 in vec3 Normal;
 
-uniform Material u_Material;
 uniform vec3 u_CameraLocation;
 uniform samplerCube u_SkyboxTexture; 
 
-struct Light 
-{
-    vec3 Position;
-    vec3 Direction;
-    vec3 Color;
-    float DirectionLength;
-    int Type;
-    float cutoff;
-    float Intensity;
-    float OuterCutOff;
-};
-
-layout(std140, binding=0) uniform Lights 
-{
-    Light u_Lights[32];
-};
-
-const int LightTypeDirectional = 0;
-const int LightTypePoint = 1;
-const int LightTypeSpot = 2;
-
-uniform int u_NumLights;
-
-float CalculateAttentuation(vec3 lightPosition, float lightLength)
-{
-    float dist = distance(lightPosition, FragPosWS);
-    float attenuation = 0.0f;
-
-    if (dist <= 0.01f) 
-    {
-        attenuation = 1;
-    } 
-    else if (dist > 0.01f && dist < lightLength)
-    {
-        attenuation = (lightLength - dist) / (lightLength - 0.01f);
-    }
-
-    return attenuation;
-}
+#include "lights.glsl"
 
 vec3 CalculateSpecular(vec3 lightDir, vec3 viewDir, vec3 norm, Light light)
 {
@@ -0,0 +1,40 @@
+// Lights of scene, included by fragment shaders that are lit. Expects FragPosWS input
+struct Light 
+{
+    vec3 Position;
+    vec3 Direction;
+    vec3 Color;
+    float DirectionLength;
+    int Type;
+    float cutoff;
+    float Intensity;
+    float OuterCutOff;
+};
+
+layout(std140, binding=0) uniform Lights 
+{
+    Light u_Lights[32];
+};
+
+const int LightTypeDirectional = 0;
+const int LightTypePoint = 1;
+const int LightTypeSpot = 2;
+
+uniform int u_NumLights;
+
+float CalculateAttentuation(vec3 lightPosition, float lightLength)
+{
+    float dist = distance(lightPosition, FragPosWS);
+    float attenuation = 0.0f;
+
+    if (dist <= 0.01f) 
+    {
+        attenuation = 1;
+    } 
+    else if (dist > 0.01f && dist < lightLength)
+    {
+        attenuation = (lightLength - dist) / (lightLength - 0.01f);
+    }
+
+    return attenuation;
+}
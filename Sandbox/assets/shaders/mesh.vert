@@ -0,0 +1,114 @@
+#version 430 core
+
+// Vertex shader of static and skeletal meshes. Keywords:
+// SKINNED - vertices are transformed by bones
+// INSTANCED - transforms of instances come from buffer indexed by gl_InstanceID
+// TEXTURE_ARRAY - passes layer of texture array to fragment shader, instanced static meshes read it per instance,
+// others per vertex from a_TextureId
+
+layout (location = 0) in vec3 a_Position;
+layout (location = 1) in vec3 a_Normal;
+layout (location = 2) in vec2 a_TextureCoords;
+
+#ifdef SKINNED
+layout (location = 3) in ivec4 a_BoneIds;
+layout (location = 4) in vec4 a_BoneWeights;
+layout (location = 5) in uint a_TextureId;
+#else
+layout (location = 3) in uint a_TextureId;
+#endif
+
+uniform mat4 u_ProjectionView;
+uniform mat4 u_Transform;
+
+#if defined(SKINNED) && defined(INSTANCED)
+struct SkeletalInstance
+{
+    mat4 Transform;
+    ivec4 PaletteOffset;
+};
+
+// bone transforms of all instances, each instance occupies NumBones consecutive matrices
+layout(std430, binding = 1) readonly buffer BonePalette
+{
+    mat4 u_BonePalette[];
+};
+
+layout(std430, binding = 2) readonly buffer SkeletalInstances
+{
+    SkeletalInstance u_Instances[];
+};
+#elif defined(SKINNED)
+uniform mat4 u_BoneTransforms[200];
+#elif defined(INSTANCED)
+layout(std140, binding=0) uniform Transforms 
+{
+    mat4 u_Transforms[800];
+
+    // texture array layer of each instance, 4 instances share element
+    ivec4 u_TextureLayers[200];
+};
+#else
+uniform mat3 u_NormalTransform;
+#endif
+
+out vec2 TextureCoords;
+out vec3 FragPosWS;
+out vec3 Normal;
+out flat uint TextureId;
+
+#ifdef TEXTURE_ARRAY
+out flat int TextureLayer;
+#endif
+
+#ifdef SKINNED
+mat4 GetBoneTransform(int boneId)
+{
+#ifdef INSTANCED
+    return u_BonePalette[u_Instances[gl_InstanceID].PaletteOffset.x + boneId];
+#else
+    return u_BoneTransforms[boneId];
+#endif
+}
+#endif
+
+void main() 
+{
+#if defined(SKINNED) && defined(INSTANCED)
+    mat4 transform = u_Transform * u_Instances[gl_InstanceID].Transform;
+#elif defined(INSTANCED)
+    mat4 transform = u_Transform * u_Transforms[gl_InstanceID];
+#else
+    mat4 transform = u_Transform;
+#endif
+
+#ifdef SKINNED
+    vec4 weights = normalize(a_BoneWeights);
+
+    mat4 transformFromBones = GetBoneTransform(a_BoneIds.x) * weights.x;
+    transformFromBones  +=    GetBoneTransform(a_BoneIds.y) * weights.y;
+    transformFromBones  +=    GetBoneTransform(a_BoneIds.z) * weights.z;
+    transformFromBones  +=    GetBoneTransform(a_BoneIds.w) * weights.w;
+
+    vec4 pos = transformFromBones * vec4(a_Position, 1.0);
+    FragPosWS = vec3(transform * pos);
+    Normal = normalize(mat3(transpose(inverse(transform * transformFromBones))) * a_Normal);
+#else
+    FragPosWS = vec3(transform * vec4(a_Position, 1));
+#ifdef INSTANCED
+    Normal = normalize(mat3(transpose(inverse(transform))) * a_Normal);
+#else
+    Normal = u_NormalTransform * a_Normal;
+#endif
+#endif
+
+    gl_Position = u_ProjectionView * vec4(FragPosWS, 1);
+    TextureCoords = a_TextureCoords;
+    TextureId = a_TextureId;
+
+#if defined(TEXTURE_ARRAY) && defined(INSTANCED) && !defined(SKINNED)
+    TextureLayer = u_TextureLayers[gl_InstanceID / 4][gl_InstanceID % 4];
+#elif defined(TEXTURE_ARRAY)
+    TextureLayer = int(a_TextureId);
+#endif
+}
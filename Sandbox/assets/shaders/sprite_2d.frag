@@ -2,6 +2,9 @@
 
 uniform sampler2D u_Textures[32];
 
+// the same as SdfTextureFlag in SpriteBatch.hpp
+const int SdfTextureFlag = 256;
+
 in vec4 Tint;
 in vec2 TextureCoords;
 flat in int TextureId;
@@ -10,5 +13,14 @@ out vec4 FragColor;
 
 void main() 
 {
-	FragColor = Tint * texture(u_Textures[TextureId], TextureCoords);
+	vec4 color = texture(u_Textures[TextureId & (SdfTextureFlag - 1)], TextureCoords);
+
+	// glyph stores distance to its edge in alpha, edge is smoothed over one pixel on screen at any scale
+	if ((TextureId & SdfTextureFlag) != 0)
+	{
+		float width = fwidth(color.a);
+		color = vec4(color.rgb, smoothstep(0.5 - width, 0.5 + width, color.a));
+	}
+
+	FragColor = Tint * color;
 }
\ No newline at end of file
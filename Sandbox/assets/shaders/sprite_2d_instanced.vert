@@ -0,0 +1,34 @@
+#version 430 core
+
+// one record per sprite, quad corners are selected by gl_VertexID of static quad indices
+layout(location = 0) in vec2 a_Position;
+layout(location = 1) in vec2 a_Size;
+layout(location = 2) in vec2 a_Origin;
+layout(location = 3) in float a_Rotation;
+layout(location = 4) in vec4 a_UvRect;
+layout(location = 5) in int a_TextureId;
+layout(location = 6) in uint a_RgbaColor;
+
+out vec4 Tint;
+out vec2 TextureCoords;
+flat out int TextureId;
+
+uniform mat4 u_Projection;
+
+const vec2 QuadCorners[4] = vec2[](vec2(0, 0), vec2(1, 0), vec2(1, 1), vec2(0, 1));
+
+void main() 
+{
+	vec2 corner = QuadCorners[gl_VertexID];
+
+	// the same as Transform2D::GetTransformMatrix, sprite is rotated around origin
+	float angle = radians(a_Rotation);
+	mat2 rotation = mat2(cos(angle), sin(angle), -sin(angle), cos(angle));
+	vec2 position = a_Position + a_Origin + rotation * (corner * a_Size - a_Origin);
+
+	gl_Position = u_Projection * vec4(position, 0.1, 1);
+	TextureCoords = mix(a_UvRect.xy, a_UvRect.zw, corner);
+	TextureId = a_TextureId;
+	Tint = vec4((a_RgbaColor & 0xff) / 255.0f, ((a_RgbaColor >> 8) & 0xff) / 255.0f, 
+		((a_RgbaColor >> 16) & 0xff) / 255.0f,  ((a_RgbaColor >> 24) & 0xff) / 255.0f);
+}
@@ -1,14 +1,30 @@
 #version 430 core
 
+// Keywords:
+// TEXTURE_ARRAY - diffuse texture is layer of texture array, so meshes with different textures share material
+
 struct Material 
 {
+#ifdef TEXTURE_ARRAY
+    sampler2DArray Diffuse;
+#else
     sampler2D Diffuse1;
     sampler2D Diffuse2;
+#endif
+};
+
+// scalar parameters of material are uploaded once per change, not on every draw
+layout(std140) uniform MaterialParameters
+{
     float ReflectionFactor;
     float Shininess;
-};
+} u_MaterialParams;
 
 in flat uint TextureId;
+
+#ifdef TEXTURE_ARRAY
+in flat int TextureLayer;
+#endif
 in vec2 TextureCoords;
 in vec3 FragPosWS;
 in vec3 Normal;
@@ -17,45 +33,7 @@ uniform Material u_Material;
 uniform vec3 u_CameraLocation;
 uniform samplerCube u_SkyboxTexture; 
 
-struct Light 
-{
-    vec3 Position;
-    vec3 Direction;
-    vec3 Color;
-    float DirectionLength;
-    int Type;
-    float cutoff;
-    float Intensity;
-    float OuterCutOff;
-};
-
-layout(std140, binding=0) uniform Lights 
-{
-    Light u_Lights[32];
-};
-
-const int LightTypeDirectional = 0;
-const int LightTypePoint = 1;
-const int LightTypeSpot = 2;
-
-uniform int u_NumLights;
-
-float CalculateAttentuation(vec3 lightPosition, float lightLength)
-{
-    float dist = distance(lightPosition, FragPosWS);
-    float attenuation = 0.0f;
-
-    if (dist <= 0.01f) 
-    {
-        attenuation = 1;
-    } 
-    else if (dist > 0.01f && dist < lightLength)
-    {
-        attenuation = (lightLength - dist) / (lightLength - 0.01f);
-    }
-
-    return attenuation;
-}
+#include "lights.glsl"
 
 vec3 CalculateSpecular(vec3 lightDir, vec3 viewDir, vec3 norm, Light light)
 {
@@ -67,7 +45,7 @@ vec3 CalculateSpecular(vec3 lightDir, vec3 viewDir, vec3 norm, Light light)
         vec3 refl = reflect(-lightDir, norm);
         float fi = dot(viewDir, refl);
         
-        specular = light.Intensity * light.Color * pow(max(0.0, fi), u_Material.Shininess);
+        specular = light.Intensity * light.Color * pow(max(0.0, fi), u_MaterialParams.Shininess);
     }
 
     return specular;
@@ -125,6 +103,9 @@ out vec4 FragColor;
 
 void main() 
 {
+#ifdef TEXTURE_ARRAY
+    vec4 texel = texture(u_Material.Diffuse, vec3(TextureCoords, float(TextureLayer)));
+#else
     vec4 texel = vec4(0, 0, 0, 1);
 
     if (TextureId == 0u) 
@@ -135,6 +116,7 @@ void main()
     {
         texel = texture(u_Material.Diffuse2, TextureCoords);
     }
+#endif
     
     vec3 norm = normalize(Normal);
     vec3 viewDir = normalize(u_CameraLocation - FragPosWS);
@@ -149,7 +131,7 @@ void main()
         color += CalculateLight(u_Lights[i], norm, viewDir, texel);
     }
     
-    color += vec3(u_Material.ReflectionFactor * texture(u_SkyboxTexture, reflectDir));
+    color += vec3(u_MaterialParams.ReflectionFactor * texture(u_SkyboxTexture, reflectDir));
 
     FragColor = vec4(color, 1.0);
 }
\ No newline at end of file
@@ -8,6 +8,11 @@
 
 #include <glm/gtx/matrix_decompose.hpp>
 #include <random>
+#include <chrono>
+
+// unreferenced assets are evicted above these, sandbox alone stays far below them
+static constexpr size_t SandboxGpuMemoryBudget = 1024ull * 1024 * 1024;
+static constexpr size_t SandboxCpuMemoryBudget = 512ull * 1024 * 1024;
 
 static void SetupDefaultProperties(const std::shared_ptr<Material>& material)
 {
@@ -109,6 +114,13 @@ SandboxGameLayer::SandboxGameLayer(std::shared_ptr<Game> game) :
     m_GuiDisplayVisitor(std::make_unique<MaterialGuiDisplay>())
 {
     m_Level = game->GetCurrentLevel();
+    ResourceManager::SetMemoryBudget(SandboxGpuMemoryBudget, SandboxCpuMemoryBudget);
+    ResourceManager::WatchAssetDirectory("assets");
+
+    // textures start decoding on loading threads while meshes below are loaded, skybox faces are already decoding.
+    // Sprite stays uncompressed, because block compression would blur its pixel art
+    ResourceManager::GetTexture2DAsync("assets/T_Metal_Steel_D.TGA", TextureCompression::Auto);
+    ResourceManager::GetTexture2DAsync("assets/fireworks.png");
 
     auto defaultShader = ResourceManager::GetShader("assets/shaders/default.shd");
     auto debugShader = ResourceManager::GetShader("assets/shaders/unshaded.shd");
@@ -161,9 +173,8 @@ void SandboxGameLayer::Render()
     std::optional<Actor> characterActor = m_Level->TryFindActor("SkeletalMesh0");
     if (characterActor.has_value())
     {
-        Transform transform = characterActor->GetTransform().GetAsTransform();
-        transform.Scale = {1, 1, 1};
-        Debug::DrawDebugBox(m_TestSkeletalMesh->GetBoundingBox(), transform);
+        const SkeletalMeshComponent& skeletalMesh = characterActor->GetComponent<SkeletalMeshComponent>();
+        Debug::DrawDebugBox(skeletalMesh.GetAnimationBounds(), characterActor->GetTransform().GetAsTransform());
     }
 
     // draw directional light gizmo
@@ -232,8 +243,25 @@ void SandboxGameLayer::OnImguiFrame()
         ImGui::Text("NumVerticesMemoryAllocated: %s", text.c_str());
         text = FormatSize(UniformBuffer::s_NumBytesAllocated);
         ImGui::Text("NumBytesUniformBuffer: %s", text.c_str());
+        text = FormatSize(ShaderStorageBuffer::s_NumBytesAllocated);
+        ImGui::Text("NumBytesShaderStorageBuffer: %s", text.c_str());
         text = FormatSize(Texture2D::s_NumTextureVramUsed);
         ImGui::Text("NumTextureMemoryUsage: %s", text.c_str());
+
+        ResourceResidencyStats residency = ResourceManager::GetResidencyStats();
+        ImGui::Text("Gpu memory: %s / %s", FormatSize(residency.NumGpuBytesUsed).c_str(), FormatSize(residency.GpuBudget).c_str());
+        ImGui::Text("Cpu memory: %s / %s", FormatSize(residency.NumCpuBytesUsed).c_str(), FormatSize(residency.CpuBudget).c_str());
+        ImGui::Text("Resident assets: %i, referenced: %i, evicted: %i", residency.NumResidentAssets,
+            residency.NumReferencedAssets, residency.NumEvictedAssets);
+        ImGui::Checkbox("Use animation kernels", &SkeletalMesh::s_bUseAnimationKernels);
+
+        const AnimationPoseCache& poseCache = m_Level->GetAnimationPoseCache();
+        ImGui::Text("Pose cache hits: %i, misses: %i", poseCache.GetNumHits(), poseCache.GetNumMisses());
+
+        for (int lod = 0; lod < m_TestSkeletalMesh->GetNumLods(); ++lod)
+        {
+            ImGui::Text("Skeletal mesh lod %i joints: %i", lod, m_TestSkeletalMesh->GetNumJoints(lod));
+        }
         ImGui::End();
     }
 
@@ -321,6 +349,10 @@ bool SandboxGameLayer::OnKeyDown(KeyCode::Index keyCode)
     {
         m_Game.lock()->SetMouseVisible(!m_Game.lock()->IsMouseVisible());
     }
+    else if (keyCode == KeyCode::B)
+    {
+        RunAnimationBenchmark();
+    }
 
     return true;
 }
@@ -371,15 +403,19 @@ void SandboxGameLayer::InitializeSkeletalMesh()
     m_TestSkeletalMesh = ResourceManager::GetSkeletalMesh("assets/test_character.fbx");
     m_TestSkeletalMesh->MainMaterial = ResourceManager::CreateMaterial("assets/shaders/skeletal_default.shd", "skeletal1");
 
-    for (int i = 0; i < m_TestSkeletalMesh->TextureNames.size(); ++i)
-    {
-        std::string property_name = std::string{"Diffuse"} + std::to_string(i + 1);
-        m_TestSkeletalMesh->MainMaterial->SetTextureProperty(property_name.c_str(), ResourceManager::GetTexture2D(m_TestSkeletalMesh->TextureNames[i]));
-    }
+    // all characters sharing this mesh are drawn in one instanced drawcall
+    m_TestSkeletalMesh->InstancedMaterial = ResourceManager::CreateMaterial("assets/shaders/skeletal_instanced.shd", "skeletal_instanced1");
 
-    std::shared_ptr<Material> material = m_TestSkeletalMesh->MainMaterial;
+    for (const std::shared_ptr<Material>& material : {m_TestSkeletalMesh->MainMaterial, m_TestSkeletalMesh->InstancedMaterial})
+    {
+        for (int i = 0; i < m_TestSkeletalMesh->TextureNames.size(); ++i)
+        {
+            std::string property_name = std::string{"Diffuse"} + std::to_string(i + 1);
+            material->SetTextureProperty(property_name.c_str(), ResourceManager::GetTexture2D(m_TestSkeletalMesh->TextureNames[i]));
+        }
 
-    material->SetFloatProperty("Shininess", 32.0f);
+        material->SetFloatProperty("Shininess", 32.0f);
+    }
 }
 
 void SandboxGameLayer::CreateSkeletalActors()
@@ -393,6 +429,81 @@ void SandboxGameLayer::CreateSkeletalActors()
     }
 }
 
+void SandboxGameLayer::RunAnimationBenchmark()
+{
+    constexpr int NumIterations = 1000;
+    constexpr int NumSkeletonsInBatch = 64;
+    constexpr float TimeStep = 1.0f / 60.0f;
+
+    std::shared_ptr<SkeletalMesh> mesh = ResourceManager::GetSkeletalMesh("assets/ThirdPersonWalk.FBX");
+    std::vector<std::string> animationNames = mesh->GetAnimationNames();
+    auto animationIt = std::find_if(animationNames.begin(), animationNames.end(), [](const std::string& name)
+    {
+        return name != DefaultAnimationName;
+    });
+
+    std::string animationName = animationIt != animationNames.end() ? *animationIt : DefaultAnimationName;
+    std::vector<glm::mat4> referenceTransforms(mesh->GetNumBones(), glm::identity<glm::mat4>());
+    std::vector<glm::mat4> kernelTransforms(mesh->GetNumBones(), glm::identity<glm::mat4>());
+
+    auto measure = [](auto&& function)
+    {
+        auto start = std::chrono::steady_clock::now();
+
+        for (int i = 0; i < NumIterations; ++i)
+        {
+            function(i * TimeStep);
+        }
+
+        return std::chrono::duration<float, std::micro>(std::chrono::steady_clock::now() - start).count() / NumIterations;
+    };
+
+    bool bUseAnimationKernels = SkeletalMesh::s_bUseAnimationKernels;
+
+    SkeletalMesh::s_bUseAnimationKernels = false;
+    float glmTime = measure([&](float time)
+    {
+        mesh->GetAnimationFrames(AnimationUpdateArgs{time, animationName, referenceTransforms});
+    });
+
+    SkeletalMesh::s_bUseAnimationKernels = true;
+    float kernelTime = measure([&](float time)
+    {
+        mesh->GetAnimationFrames(AnimationUpdateArgs{time, animationName, kernelTransforms});
+    });
+
+    SkeletalMesh::s_bUseAnimationKernels = bUseAnimationKernels;
+
+    // whole crowd evaluated with single batch
+    SkeletonPoseEvaluator evaluator;
+    std::vector<std::vector<glm::mat4>> batchTransforms(NumSkeletonsInBatch, kernelTransforms);
+    std::vector<PoseEvaluationJob> jobs(NumSkeletonsInBatch);
+
+    float batchTime = measure([&](float time)
+    {
+        for (int i = 0; i < NumSkeletonsInBatch; ++i)
+        {
+            jobs[i] = mesh->CreatePoseEvaluationJob(AnimationUpdateArgs{time + i * TimeStep, animationName, batchTransforms[i]});
+        }
+
+        evaluator.EvaluateBatch(jobs);
+    }) / NumSkeletonsInBatch;
+
+    float maxError = 0.0f;
+
+    for (size_t i = 0; i < referenceTransforms.size(); ++i)
+    {
+        for (int column = 0; column < 4; ++column)
+        {
+            glm::vec4 difference = glm::abs(referenceTransforms[i][column] - kernelTransforms[i][column]);
+            maxError = std::max({maxError, difference.x, difference.y, difference.z, difference.w});
+        }
+    }
+
+    ENG_LOG_INFO("Animation benchmark [{}, {} bones, SSE: {}]", animationName, mesh->GetNumBones(), ANIMATION_KERNELS_SSE);
+    ENG_LOG_INFO("glm: {:.2f} us, kernels: {:.2f} us, batched kernels: {:.2f} us per skeleton, max error: {}", glmTime, kernelTime, batchTime, maxError);
+}
+
 Actor SandboxGameLayer::CreateInstancedMeshActor(const std::string& filePath, const std::shared_ptr<Material>& material)
 {
     Actor instanceMesh = m_Level->CreateActor("InstancedMesh");
@@ -55,6 +55,9 @@ private:
 
     void CreateSkeletalActors();
 
+    // Compares glm and SIMD kernel pose evaluation, results are written to log
+    void RunAnimationBenchmark();
+
     Actor CreateInstancedMeshActor(const std::string& filePath, const std::shared_ptr<Material>& material);
     void PlaceLightsAndPlayer();
 };
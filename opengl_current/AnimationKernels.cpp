@@ -0,0 +1,404 @@
+#include "AnimationKernels.hpp"
+#include "ErrorMacros.hpp"
+
+#include <algorithm>
+
+#if ANIMATION_KERNELS_SSE
+#include <emmintrin.h>
+#endif
+
+Affine3x4 Affine3x4::FromMat4(const glm::mat4& matrix)
+{
+    Affine3x4 affine;
+
+    for (int row = 0; row < 3; ++row)
+    {
+        affine.Rows[row] = glm::vec4{matrix[0][row], matrix[1][row], matrix[2][row], matrix[3][row]};
+    }
+
+    return affine;
+}
+
+glm::mat4 Affine3x4::ToMat4() const
+{
+    glm::mat4 matrix{1.0f};
+
+    for (int column = 0; column < 4; ++column)
+    {
+        matrix[column] = glm::vec4{Rows[0][column], Rows[1][column], Rows[2][column], column == 3 ? 1.0f : 0.0f};
+    }
+
+    return matrix;
+}
+
+static void ResizeFilled(std::vector<float>& values, int numJoints, float fillValue)
+{
+    values.resize(GetPaddedNumJoints(numJoints), fillValue);
+}
+
+void JointPoseSoA::Resize(int numJoints)
+{
+    ResizeFilled(TranslationX, numJoints, 0.0f);
+    ResizeFilled(TranslationY, numJoints, 0.0f);
+    ResizeFilled(TranslationZ, numJoints, 0.0f);
+
+    ResizeFilled(RotationX, numJoints, 0.0f);
+    ResizeFilled(RotationY, numJoints, 0.0f);
+    ResizeFilled(RotationZ, numJoints, 0.0f);
+    ResizeFilled(RotationW, numJoints, 1.0f);
+}
+
+void JointKeyframesSoA::Resize(int numJoints)
+{
+    From.Resize(numJoints);
+    To.Resize(numJoints);
+    ResizeFilled(PositionFactors, numJoints, 0.0f);
+    ResizeFilled(RotationFactors, numJoints, 0.0f);
+}
+
+static FORCE_INLINE void StorePose(JointPoseSoA& pose, int index, const glm::vec3& translation, const glm::quat& rotation)
+{
+    pose.TranslationX[index] = translation.x;
+    pose.TranslationY[index] = translation.y;
+    pose.TranslationZ[index] = translation.z;
+
+    pose.RotationX[index] = rotation.x;
+    pose.RotationY[index] = rotation.y;
+    pose.RotationZ[index] = rotation.z;
+    pose.RotationW[index] = rotation.w;
+}
+
+void GatherJointKeyframes(std::span<const BoneAnimationTrack> jointTracks, float animationTime, JointKeyframesSoA& outKeys, int firstJoint,
+    std::span<const int> trackIndices)
+{
+    int numJoints = trackIndices.empty() ? GetContainerSizeInt(jointTracks) : GetContainerSizeInt(trackIndices);
+    ASSERT(firstJoint + numJoints <= outKeys.PositionFactors.size());
+
+    for (int i = 0; i < numJoints; ++i)
+    {
+        const BoneAnimationTrack& track = trackIndices.empty() ? jointTracks[i] : jointTracks[trackIndices[i]];
+        int index = firstJoint + i;
+
+        glm::vec3 positionFrom{0, 0, 0};
+        glm::vec3 positionTo{0, 0, 0};
+        glm::quat rotationFrom{glm::vec3{0, 0, 0}};
+        glm::quat rotationTo{glm::vec3{0, 0, 0}};
+        float positionFactor = 0.0f;
+        float rotationFactor = 0.0f;
+
+        track.FindPositionKeyframes(animationTime, positionFrom, positionTo, positionFactor);
+        track.FindRotationKeyframes(animationTime, rotationFrom, rotationTo, rotationFactor);
+
+        StorePose(outKeys.From, index, positionFrom, rotationFrom);
+        StorePose(outKeys.To, index, positionTo, rotationTo);
+        outKeys.PositionFactors[index] = positionFactor;
+        outKeys.RotationFactors[index] = rotationFactor;
+    }
+}
+
+#if ANIMATION_KERNELS_SSE
+
+void InterpolateJointPoses(const JointKeyframesSoA& keys, int numJoints, JointPoseSoA& outPose)
+{
+    ASSERT(numJoints % 4 == 0);
+
+    const JointPoseSoA& from = keys.From;
+    const JointPoseSoA& to = keys.To;
+    const __m128 signBit = _mm_set1_ps(-0.0f);
+    const __m128 one = _mm_set1_ps(1.0f);
+
+    for (int i = 0; i < numJoints; i += 4)
+    {
+        __m128 factor = _mm_loadu_ps(&keys.PositionFactors[i]);
+
+        auto lerp = [factor](const float* a, const float* b)
+        {
+            __m128 va = _mm_loadu_ps(a);
+            return _mm_add_ps(va, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(b), va), factor));
+        };
+
+        _mm_storeu_ps(&outPose.TranslationX[i], lerp(&from.TranslationX[i], &to.TranslationX[i]));
+        _mm_storeu_ps(&outPose.TranslationY[i], lerp(&from.TranslationY[i], &to.TranslationY[i]));
+        _mm_storeu_ps(&outPose.TranslationZ[i], lerp(&from.TranslationZ[i], &to.TranslationZ[i]));
+
+        // nlerp along shortest path. Keys are sampled densely, so it's close enough to slerp
+        __m128 ax = _mm_loadu_ps(&from.RotationX[i]);
+        __m128 ay = _mm_loadu_ps(&from.RotationY[i]);
+        __m128 az = _mm_loadu_ps(&from.RotationZ[i]);
+        __m128 aw = _mm_loadu_ps(&from.RotationW[i]);
+        __m128 bx = _mm_loadu_ps(&to.RotationX[i]);
+        __m128 by = _mm_loadu_ps(&to.RotationY[i]);
+        __m128 bz = _mm_loadu_ps(&to.RotationZ[i]);
+        __m128 bw = _mm_loadu_ps(&to.RotationW[i]);
+
+        __m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_add_ps(_mm_mul_ps(az, bz), _mm_mul_ps(aw, bw)));
+        __m128 rotationFactor = _mm_loadu_ps(&keys.RotationFactors[i]);
+        __m128 weightA = _mm_sub_ps(one, rotationFactor);
+        __m128 weightB = _mm_xor_ps(rotationFactor, _mm_and_ps(dot, signBit));
+
+        __m128 x = _mm_add_ps(_mm_mul_ps(ax, weightA), _mm_mul_ps(bx, weightB));
+        __m128 y = _mm_add_ps(_mm_mul_ps(ay, weightA), _mm_mul_ps(by, weightB));
+        __m128 z = _mm_add_ps(_mm_mul_ps(az, weightA), _mm_mul_ps(bz, weightB));
+        __m128 w = _mm_add_ps(_mm_mul_ps(aw, weightA), _mm_mul_ps(bw, weightB));
+
+        __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_add_ps(_mm_mul_ps(z, z), _mm_mul_ps(w, w))));
+        __m128 invLength = _mm_div_ps(one, length);
+
+        _mm_storeu_ps(&outPose.RotationX[i], _mm_mul_ps(x, invLength));
+        _mm_storeu_ps(&outPose.RotationY[i], _mm_mul_ps(y, invLength));
+        _mm_storeu_ps(&outPose.RotationZ[i], _mm_mul_ps(z, invLength));
+        _mm_storeu_ps(&outPose.RotationW[i], _mm_mul_ps(w, invLength));
+    }
+}
+
+void ComposeLocalTransforms(const JointPoseSoA& pose, int firstJoint, int numJoints, std::span<Affine3x4> outLocalTransforms)
+{
+    ASSERT(firstJoint % 4 == 0 && numJoints % 4 == 0);
+    ASSERT(numJoints <= outLocalTransforms.size());
+
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 two = _mm_set1_ps(2.0f);
+
+    for (int i = 0; i < numJoints; i += 4)
+    {
+        int joint = firstJoint + i;
+
+        __m128 x = _mm_loadu_ps(&pose.RotationX[joint]);
+        __m128 y = _mm_loadu_ps(&pose.RotationY[joint]);
+        __m128 z = _mm_loadu_ps(&pose.RotationZ[joint]);
+        __m128 w = _mm_loadu_ps(&pose.RotationW[joint]);
+
+        __m128 xx = _mm_mul_ps(x, x);
+        __m128 yy = _mm_mul_ps(y, y);
+        __m128 zz = _mm_mul_ps(z, z);
+        __m128 xy = _mm_mul_ps(x, y);
+        __m128 xz = _mm_mul_ps(x, z);
+        __m128 yz = _mm_mul_ps(y, z);
+        __m128 wx = _mm_mul_ps(w, x);
+        __m128 wy = _mm_mul_ps(w, y);
+        __m128 wz = _mm_mul_ps(w, z);
+
+        // each register holds one matrix element of 4 joints. Transposing turns them into rows of 4 joints
+        __m128 row0[4] = {
+            _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))),
+            _mm_mul_ps(two, _mm_sub_ps(xy, wz)),
+            _mm_mul_ps(two, _mm_add_ps(xz, wy)),
+            _mm_loadu_ps(&pose.TranslationX[joint])
+        };
+
+        __m128 row1[4] = {
+            _mm_mul_ps(two, _mm_add_ps(xy, wz)),
+            _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))),
+            _mm_mul_ps(two, _mm_sub_ps(yz, wx)),
+            _mm_loadu_ps(&pose.TranslationY[joint])
+        };
+
+        __m128 row2[4] = {
+            _mm_mul_ps(two, _mm_sub_ps(xz, wy)),
+            _mm_mul_ps(two, _mm_add_ps(yz, wx)),
+            _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))),
+            _mm_loadu_ps(&pose.TranslationZ[joint])
+        };
+
+        _MM_TRANSPOSE4_PS(row0[0], row0[1], row0[2], row0[3]);
+        _MM_TRANSPOSE4_PS(row1[0], row1[1], row1[2], row1[3]);
+        _MM_TRANSPOSE4_PS(row2[0], row2[1], row2[2], row2[3]);
+
+        for (int lane = 0; lane < 4; ++lane)
+        {
+            Affine3x4& local = outLocalTransforms[i + lane];
+            _mm_store_ps(&local.Rows[0].x, row0[lane]);
+            _mm_store_ps(&local.Rows[1].x, row1[lane]);
+            _mm_store_ps(&local.Rows[2].x, row2[lane]);
+        }
+    }
+}
+
+static FORCE_INLINE void MultiplyAffine(const Affine3x4& a, const Affine3x4& b, Affine3x4& out)
+{
+    __m128 b0 = _mm_load_ps(&b.Rows[0].x);
+    __m128 b1 = _mm_load_ps(&b.Rows[1].x);
+    __m128 b2 = _mm_load_ps(&b.Rows[2].x);
+    const __m128 b3 = _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f);
+
+    for (int row = 0; row < 3; ++row)
+    {
+        __m128 r = _mm_load_ps(&a.Rows[row].x);
+
+        __m128 result = _mm_mul_ps(_mm_shuffle_ps(r, r, _MM_SHUFFLE(0, 0, 0, 0)), b0);
+        result = _mm_add_ps(result, _mm_mul_ps(_mm_shuffle_ps(r, r, _MM_SHUFFLE(1, 1, 1, 1)), b1));
+        result = _mm_add_ps(result, _mm_mul_ps(_mm_shuffle_ps(r, r, _MM_SHUFFLE(2, 2, 2, 2)), b2));
+        result = _mm_add_ps(result, _mm_mul_ps(_mm_shuffle_ps(r, r, _MM_SHUFFLE(3, 3, 3, 3)), b3));
+
+        _mm_store_ps(&out.Rows[row].x, result);
+    }
+}
+
+static FORCE_INLINE void StoreAsMat4(const Affine3x4& affine, glm::mat4& outMatrix)
+{
+    __m128 r0 = _mm_load_ps(&affine.Rows[0].x);
+    __m128 r1 = _mm_load_ps(&affine.Rows[1].x);
+    __m128 r2 = _mm_load_ps(&affine.Rows[2].x);
+    __m128 r3 = _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f);
+
+    // glm is column major, so transposed rows are columns
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+    _mm_storeu_ps(&outMatrix[0].x, r0);
+    _mm_storeu_ps(&outMatrix[1].x, r1);
+    _mm_storeu_ps(&outMatrix[2].x, r2);
+    _mm_storeu_ps(&outMatrix[3].x, r3);
+}
+
+#else
+
+void InterpolateJointPoses(const JointKeyframesSoA& keys, int numJoints, JointPoseSoA& outPose)
+{
+    const JointPoseSoA& from = keys.From;
+    const JointPoseSoA& to = keys.To;
+
+    for (int i = 0; i < numJoints; ++i)
+    {
+        float factor = keys.PositionFactors[i];
+        outPose.TranslationX[i] = glm::mix(from.TranslationX[i], to.TranslationX[i], factor);
+        outPose.TranslationY[i] = glm::mix(from.TranslationY[i], to.TranslationY[i], factor);
+        outPose.TranslationZ[i] = glm::mix(from.TranslationZ[i], to.TranslationZ[i], factor);
+
+        glm::quat a{from.RotationW[i], from.RotationX[i], from.RotationY[i], from.RotationZ[i]};
+        glm::quat b{to.RotationW[i], to.RotationX[i], to.RotationY[i], to.RotationZ[i]};
+
+        float rotationFactor = keys.RotationFactors[i];
+        float weightB = glm::dot(a, b) < 0.0f ? -rotationFactor : rotationFactor;
+        glm::quat rotation = glm::normalize(a * (1.0f - rotationFactor) + b * weightB);
+
+        outPose.RotationX[i] = rotation.x;
+        outPose.RotationY[i] = rotation.y;
+        outPose.RotationZ[i] = rotation.z;
+        outPose.RotationW[i] = rotation.w;
+    }
+}
+
+void ComposeLocalTransforms(const JointPoseSoA& pose, int firstJoint, int numJoints, std::span<Affine3x4> outLocalTransforms)
+{
+    ASSERT(numJoints <= outLocalTransforms.size());
+
+    for (int i = 0; i < numJoints; ++i)
+    {
+        int joint = firstJoint + i;
+        glm::quat rotation{pose.RotationW[joint], pose.RotationX[joint], pose.RotationY[joint], pose.RotationZ[joint]};
+        glm::mat3 rotationMatrix = glm::mat3_cast(rotation);
+
+        Affine3x4& local = outLocalTransforms[i];
+        local.Rows[0] = glm::vec4{rotationMatrix[0][0], rotationMatrix[1][0], rotationMatrix[2][0], pose.TranslationX[joint]};
+        local.Rows[1] = glm::vec4{rotationMatrix[0][1], rotationMatrix[1][1], rotationMatrix[2][1], pose.TranslationY[joint]};
+        local.Rows[2] = glm::vec4{rotationMatrix[0][2], rotationMatrix[1][2], rotationMatrix[2][2], pose.TranslationZ[joint]};
+    }
+}
+
+static FORCE_INLINE void MultiplyAffine(const Affine3x4& a, const Affine3x4& b, Affine3x4& out)
+{
+    Affine3x4 result;
+
+    for (int row = 0; row < 3; ++row)
+    {
+        const glm::vec4& r = a.Rows[row];
+        result.Rows[row] = r.x * b.Rows[0] + r.y * b.Rows[1] + r.z * b.Rows[2] + glm::vec4{0, 0, 0, r.w};
+    }
+
+    out = result;
+}
+
+static FORCE_INLINE void StoreAsMat4(const Affine3x4& affine, glm::mat4& outMatrix)
+{
+    outMatrix = affine.ToMat4();
+}
+
+#endif
+
+void ComposeModelTransforms(std::span<const int> parentIndices, std::span<const Affine3x4> localTransforms, std::span<Affine3x4> outModelTransforms)
+{
+    ASSERT(localTransforms.size() >= parentIndices.size() && outModelTransforms.size() >= parentIndices.size());
+
+    for (int i = 0; i < GetContainerSizeInt(parentIndices); ++i)
+    {
+        int parent = parentIndices[i];
+
+        if (parent < 0)
+        {
+            outModelTransforms[i] = localTransforms[i];
+            continue;
+        }
+
+        ASSERT(parent < i);
+        MultiplyAffine(outModelTransforms[parent], localTransforms[i], outModelTransforms[i]);
+    }
+}
+
+void ComposeSkinningTransforms(std::span<const Affine3x4> modelTransforms, std::span<const Affine3x4> boneOffsets,
+    std::span<const int> boneTransformIndices, std::span<glm::mat4> outBoneTransforms)
+{
+    for (int i = 0; i < GetContainerSizeInt(boneTransformIndices); ++i)
+    {
+        int index = boneTransformIndices[i];
+        ASSERT(index >= 0 && index < GetContainerSizeInt(outBoneTransforms));
+
+        Affine3x4 skinTransform;
+        MultiplyAffine(modelTransforms[i], boneOffsets[i], skinTransform);
+        StoreAsMat4(skinTransform, outBoneTransforms[index]);
+    }
+}
+
+void SkeletonPoseEvaluator::Evaluate(const PoseEvaluationJob& job)
+{
+    EvaluateBatch(std::span<const PoseEvaluationJob>{&job, 1});
+}
+
+void SkeletonPoseEvaluator::EvaluateBatch(std::span<const PoseEvaluationJob> jobs)
+{
+    // each skeleton starts at lane boundary, so local stage can process them in one go
+    m_JobFirstJoints.clear();
+    int totalNumJoints = 0;
+    int maxNumJoints = 0;
+
+    for (const PoseEvaluationJob& job : jobs)
+    {
+        m_JobFirstJoints.emplace_back(totalNumJoints);
+        int numJoints = job.Skeleton->GetNumJoints();
+        totalNumJoints += GetPaddedNumJoints(numJoints);
+        maxNumJoints = std::max(maxNumJoints, numJoints);
+    }
+
+    m_Keyframes.Resize(totalNumJoints);
+    m_Pose.Resize(totalNumJoints);
+    m_LocalTransforms.resize(totalNumJoints);
+    m_ModelTransforms.resize(maxNumJoints);
+
+    for (size_t i = 0; i < jobs.size(); ++i)
+    {
+        const PoseEvaluationJob& job = jobs[i];
+        ASSERT((job.TrackIndices.empty() ? job.JointTracks.size() : job.TrackIndices.size()) == job.Skeleton->GetNumJoints());
+        GatherJointKeyframes(job.JointTracks, job.AnimationTime, m_Keyframes, m_JobFirstJoints[i], job.TrackIndices);
+    }
+
+    InterpolateJointPoses(m_Keyframes, totalNumJoints, m_Pose);
+    ComposeLocalTransforms(m_Pose, 0, totalNumJoints, m_LocalTransforms);
+
+    for (size_t i = 0; i < jobs.size(); ++i)
+    {
+        const PoseEvaluationJob& job = jobs[i];
+        const FlatSkeleton& skeleton = *job.Skeleton;
+        std::span<Affine3x4> localTransforms{m_LocalTransforms.data() + m_JobFirstJoints[i], static_cast<size_t>(skeleton.GetNumJoints())};
+
+        // joints that aren't animated keep their relative transform
+        for (int joint = 0; joint < skeleton.GetNumJoints(); ++joint)
+        {
+            if (job.GetJointTrack(joint).IsEmpty())
+            {
+                localTransforms[joint] = skeleton.RestLocalTransforms[joint];
+            }
+        }
+
+        ComposeModelTransforms(skeleton.ParentIndices, localTransforms, m_ModelTransforms);
+        ComposeSkinningTransforms(m_ModelTransforms, job.Binding->BoneOffsets, job.Binding->BoneTransformIndices, job.OutBoneTransforms);
+    }
+}
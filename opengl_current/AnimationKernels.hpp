@@ -0,0 +1,148 @@
+#pragma once
+
+#include "Core.hpp"
+#include "AnimationTrack.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <span>
+#include <string>
+#include <vector>
+
+// SSE2 is baseline on x64, so kernels use it unless compiled for architecture without it
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ANIMATION_KERNELS_SSE 1
+#else
+#define ANIMATION_KERNELS_SSE 0
+#endif
+
+// Affine transform stored as 3 rows of 4 floats. Last row is implicitly (0, 0, 0, 1), so
+// composing two of them takes 36 multiplies instead of 64 for full glm::mat4
+struct alignas(16) Affine3x4
+{
+    glm::vec4 Rows[3]{glm::vec4{1, 0, 0, 0}, glm::vec4{0, 1, 0, 0}, glm::vec4{0, 0, 1, 0}};
+
+    static Affine3x4 FromMat4(const glm::mat4& matrix);
+    glm::mat4 ToMat4() const;
+};
+
+// Skeleton flattened to arrays in parent before child order, so model space pass is single forward loop
+struct FlatSkeleton
+{
+    std::vector<std::string> JointNames;
+
+    // index of parent joint, -1 for root
+    std::vector<int> ParentIndices;
+
+    // relative transform used by joints that don't have animation track
+    std::vector<Affine3x4> RestLocalTransforms;
+
+    int GetNumJoints() const
+    {
+        return GetContainerSizeInt(ParentIndices);
+    }
+};
+
+// Binds joints of skeleton to bones of single mesh. Meshes sharing skeleton may order bones differently
+struct SkinBinding
+{
+    // index in bone transforms array that is uploaded to shader
+    std::vector<int> BoneTransformIndices;
+
+    /* Matrices that convert vertex to bone space */
+    std::vector<Affine3x4> BoneOffsets;
+};
+
+// Joint local poses in SoA layout. Arrays are padded to multiple of 4, so
+// kernels process 4 joints at once without tail handling
+struct JointPoseSoA
+{
+    std::vector<float> TranslationX;
+    std::vector<float> TranslationY;
+    std::vector<float> TranslationZ;
+
+    std::vector<float> RotationX;
+    std::vector<float> RotationY;
+    std::vector<float> RotationZ;
+    std::vector<float> RotationW;
+
+    // resizes all arrays, new joints get identity pose
+    void Resize(int numJoints);
+};
+
+// Pair of keyframes surrounding sampled time for each joint
+struct JointKeyframesSoA
+{
+    JointPoseSoA From;
+    JointPoseSoA To;
+    std::vector<float> PositionFactors;
+    std::vector<float> RotationFactors;
+
+    void Resize(int numJoints);
+};
+
+// Rounds number of joints up so that SoA arrays can be processed in lanes of 4
+inline int GetPaddedNumJoints(int numJoints)
+{
+    return (numJoints + 3) & ~3;
+}
+
+// Interpolate stage (part 1): finds keyframes of every joint track. Joints with empty track get identity keys.
+// Key search is scalar, but writes results starting at firstJoint, so several skeletons can share one SoA.
+// When trackIndices isn't empty, joint i samples jointTracks[trackIndices[i]] (used by reduced skeletons of lods)
+void GatherJointKeyframes(std::span<const BoneAnimationTrack> jointTracks, float animationTime, JointKeyframesSoA& outKeys, int firstJoint = 0,
+    std::span<const int> trackIndices = {});
+
+// Interpolate stage (part 2): lerps translations and nlerps rotations of numJoints (must be padded)
+void InterpolateJointPoses(const JointKeyframesSoA& keys, int numJoints, JointPoseSoA& outPose);
+
+// Local stage: converts translation + rotation pose to affine matrices
+void ComposeLocalTransforms(const JointPoseSoA& pose, int firstJoint, int numJoints, std::span<Affine3x4> outLocalTransforms);
+
+// Model stage: concatenates local transforms with parents. Parent must be placed before child
+void ComposeModelTransforms(std::span<const int> parentIndices, std::span<const Affine3x4> localTransforms, std::span<Affine3x4> outModelTransforms);
+
+// Skin stage: multiplies model transforms by bone offsets and scatters them into shader bone transforms
+void ComposeSkinningTransforms(std::span<const Affine3x4> modelTransforms, std::span<const Affine3x4> boneOffsets,
+    std::span<const int> boneTransformIndices, std::span<glm::mat4> outBoneTransforms);
+
+struct PoseEvaluationJob
+{
+    const FlatSkeleton* Skeleton{nullptr};
+    const SkinBinding* Binding{nullptr};
+
+    // tracks bound to joints of skeleton
+    std::span<const BoneAnimationTrack> JointTracks;
+
+    // index of track of each joint. Empty when skeleton has joint for every track
+    std::span<const int> TrackIndices;
+
+    // time in ticks
+    float AnimationTime{0.0f};
+
+    std::span<glm::mat4> OutBoneTransforms;
+
+    const BoneAnimationTrack& GetJointTrack(int joint) const
+    {
+        return TrackIndices.empty() ? JointTracks[joint] : JointTracks[TrackIndices[joint]];
+    }
+};
+
+// Runs interpolate -> local -> model -> skin stages. Keeps scratch buffers between calls,
+// so one evaluator should be used per thread
+class SkeletonPoseEvaluator
+{
+public:
+    void Evaluate(const PoseEvaluationJob& job);
+
+    // Evaluates several skeletons at once. Interpolate and local stages run over joints of all skeletons together
+    void EvaluateBatch(std::span<const PoseEvaluationJob> jobs);
+
+private:
+    JointKeyframesSoA m_Keyframes;
+    JointPoseSoA m_Pose;
+    std::vector<Affine3x4> m_LocalTransforms;
+    std::vector<Affine3x4> m_ModelTransforms;
+    std::vector<int> m_JobFirstJoints;
+};
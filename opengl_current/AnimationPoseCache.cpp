@@ -0,0 +1,124 @@
+#include "AnimationPoseCache.hpp"
+
+#include <cmath>
+#include <bit>
+#include <algorithm>
+
+AnimationPoseCache::AnimationPoseCache() :
+    m_LodSettings{
+        AnimationLodSettings{0.0f, 1.0f / 60.0f},
+        AnimationLodSettings{20.0f, 1.0f / 30.0f},
+        AnimationLodSettings{50.0f, 1.0f / 15.0f}
+    }
+{
+}
+
+void AnimationPoseCache::BeginFrame()
+{
+    for (auto& [key, pose] : m_Poses)
+    {
+        m_RetiredPoses.emplace_back(std::move(pose));
+    }
+
+    m_Poses.clear();
+
+    // move poses released by components to free list, so allocation doesn't have to scan poses that are held
+    auto it = std::partition(m_RetiredPoses.begin(), m_RetiredPoses.end(), [](const std::shared_ptr<std::vector<glm::mat4>>& pose)
+    {
+        return pose.use_count() > 1;
+    });
+
+    for (auto freeIt = it; freeIt != m_RetiredPoses.end(); ++freeIt)
+    {
+        m_FreePoses[GetContainerSizeInt(**freeIt)].emplace_back(std::move(*freeIt));
+    }
+
+    m_RetiredPoses.erase(it, m_RetiredPoses.end());
+    m_NumHits = 0;
+    m_NumMisses = 0;
+}
+
+SharedPose AnimationPoseCache::FindOrEvaluatePose(const SkeletalMesh& mesh, const std::string& animationName, float animationTime, int lod)
+{
+    ASSERT(lod >= 0 && lod < GetContainerSizeInt(m_LodSettings));
+
+    // wrap time first, so components that are whole loops apart still share pose
+    float duration = mesh.GetAnimationDuration(animationName);
+    float wrappedTime = duration > 0.0f ? std::fmod(animationTime, duration) : animationTime;
+    float step = m_LodSettings[lod].QuantizationStep;
+
+    // animation lod also selects mesh lod, when mesh has that many
+    int meshLod = std::min(lod, mesh.GetNumLods() - 1);
+
+    AnimationPoseKey key;
+    key.Mesh = &mesh;
+    key.AnimationName = animationName;
+    key.MeshLod = meshLod;
+    float quantizedTime = wrappedTime;
+
+    if (step > 0.0f)
+    {
+        key.QuantizationStep = step;
+        key.QuantizedTime = static_cast<int64_t>(std::floor(wrappedTime / step));
+        quantizedTime = key.QuantizedTime * step;
+    }
+    else
+    {
+        // without quantization only exactly the same times are shared
+        key.QuantizedTime = std::bit_cast<int32_t>(wrappedTime);
+        key.bRawTime = true;
+    }
+
+    auto it = m_Poses.find(key);
+
+    if (it != m_Poses.end())
+    {
+        m_NumHits++;
+        return it->second;
+    }
+
+    m_NumMisses++;
+
+    std::shared_ptr<std::vector<glm::mat4>> pose = AllocatePose(mesh.GetNumBones());
+    mesh.GetAnimationFrames(AnimationUpdateArgs{quantizedTime, animationName, *pose, meshLod});
+    m_Poses.try_emplace(std::move(key), pose);
+
+    return pose;
+}
+
+int AnimationPoseCache::GetLodForDistance(float distance) const
+{
+    int lod = 0;
+
+    for (int i = 1; i < GetContainerSizeInt(m_LodSettings); ++i)
+    {
+        if (distance >= m_LodSettings[i].MinDistance)
+        {
+            lod = i;
+        }
+    }
+
+    return lod;
+}
+
+void AnimationPoseCache::SetLodSettings(std::span<const AnimationLodSettings> lodSettings)
+{
+    ASSERT(!lodSettings.empty());
+    m_LodSettings.assign(lodSettings.begin(), lodSettings.end());
+}
+
+std::shared_ptr<std::vector<glm::mat4>> AnimationPoseCache::AllocatePose(int numBones)
+{
+    auto it = m_FreePoses.find(numBones);
+
+    if (it == m_FreePoses.end() || it->second.empty())
+    {
+        return std::make_shared<std::vector<glm::mat4>>(numBones, glm::identity<glm::mat4>());
+    }
+
+    // pose is evaluated over again, free list of the same bone count doesn't need resize
+    std::shared_ptr<std::vector<glm::mat4>> pose = std::move(it->second.back());
+    it->second.pop_back();
+
+    return pose;
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "SkeletalMesh.hpp"
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+using SharedPose = std::shared_ptr<const std::vector<glm::mat4>>;
+
+struct AnimationPoseKey
+{
+    const SkeletalMesh* Mesh{nullptr};
+    std::string AnimationName;
+
+    // lod of mesh, poses of lower lods don't have transforms of collapsed bones
+    int MeshLod{0};
+
+    // step of animation lod, the same index is different time with different step
+    float QuantizationStep{0.0f};
+
+    // index of quantization step within animation, or bits of unquantized time when bRawTime is set
+    int64_t QuantizedTime{0};
+    bool bRawTime{false};
+
+    bool operator==(const AnimationPoseKey& other) const
+    {
+        return other.Mesh == Mesh && other.QuantizedTime == QuantizedTime && other.bRawTime == bRawTime &&
+            other.QuantizationStep == QuantizationStep && other.MeshLod == MeshLod && other.AnimationName == AnimationName;
+    }
+};
+
+namespace std
+{
+    template<>
+    struct hash<::AnimationPoseKey>
+    {
+        size_t operator()(const AnimationPoseKey& key) const
+        {
+            size_t seed = hash<const SkeletalMesh*>{}(key.Mesh);
+            seed ^= hash<std::string>{}(key.AnimationName) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+            seed ^= hash<int64_t>{}(key.QuantizedTime) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+            seed ^= hash<int>{}(key.MeshLod) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+            seed ^= hash<float>{}(key.QuantizationStep) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+            seed ^= hash<bool>{}(key.bRawTime) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+            return seed;
+        }
+    };
+}
+
+struct AnimationLodSettings
+{
+    // lod is used when camera is at least that far from component
+    float MinDistance{0.0f};
+
+    // animation time is rounded down to multiple of this step (in seconds).
+    // Bigger step means more components sharing the same pose
+    float QuantizationStep{0.0f};
+};
+
+// Per frame cache of evaluated poses. Components playing same animation of same mesh
+// at the same quantized time share one read-only bone transforms array instead of evaluating it again
+class AnimationPoseCache
+{
+public:
+    AnimationPoseCache();
+
+    // Called before animations are updated. Poses of previous frame are recycled once no component uses them
+    void BeginFrame();
+
+    SharedPose FindOrEvaluatePose(const SkeletalMesh& mesh, const std::string& animationName, float animationTime, int lod);
+
+    int GetLodForDistance(float distance) const;
+
+    // Lods must be sorted by MinDistance
+    void SetLodSettings(std::span<const AnimationLodSettings> lodSettings);
+
+    const std::vector<AnimationLodSettings>& GetLodSettings() const
+    {
+        return m_LodSettings;
+    }
+
+    int GetNumHits() const
+    {
+        return m_NumHits;
+    }
+
+    int GetNumMisses() const
+    {
+        return m_NumMisses;
+    }
+
+private:
+    std::unordered_map<AnimationPoseKey, std::shared_ptr<std::vector<glm::mat4>>> m_Poses;
+
+    // poses from previous frames, that are still used by components
+    std::vector<std::shared_ptr<std::vector<glm::mat4>>> m_RetiredPoses;
+
+    // poses held only by cache, keyed by number of bones so reuse doesn't resize
+    std::unordered_map<int, std::vector<std::shared_ptr<std::vector<glm::mat4>>>> m_FreePoses;
+
+    std::vector<AnimationLodSettings> m_LodSettings;
+    int m_NumHits{0};
+    int m_NumMisses{0};
+
+private:
+    std::shared_ptr<std::vector<glm::mat4>> AllocatePose(int numBones);
+};
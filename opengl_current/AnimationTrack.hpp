@@ -0,0 +1,223 @@
+#pragma once
+
+#include "ErrorMacros.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <span>
+#include <vector>
+
+template <typename T>
+struct KeyProperty
+{
+    T Property;
+    float Timestamp;
+};
+
+using VectorProperty = KeyProperty<glm::vec3>;
+using QuatProperty = KeyProperty<glm::quat>;
+
+class BoneAnimationTrack
+{
+public:
+    void AddNewPositionTimestamp(glm::vec3 position, float timestamp);
+    void AddNewRotationTimestamp(glm::quat rotation, float timestamp);
+
+    template <typename T>
+    T Interpolate(float animationTime) const;
+
+    template<>
+    glm::vec3 Interpolate<glm::vec3>(float animationTime) const;
+
+    template<>
+    glm::quat Interpolate<glm::quat>(float animationTime) const;
+
+    // Finds keys surrounding animationTime with factor between them. Used by animation kernels
+    // to interpolate many tracks at once
+    void FindPositionKeyframes(float animationTime, glm::vec3& outFrom, glm::vec3& outTo, float& outFactor) const;
+    void FindRotationKeyframes(float animationTime, glm::quat& outFrom, glm::quat& outTo, float& outFactor) const;
+
+    std::span<const VectorProperty> GetPositionKeys() const
+    {
+        return m_PositionKeys;
+    }
+
+    std::span<const QuatProperty> GetRotationKeys() const
+    {
+        return m_RotationKeys;
+    }
+
+    // Replaces all keys at once, used when track is read from cooked file
+    void SetKeys(std::span<const VectorProperty> positionKeys, std::span<const QuatProperty> rotationKeys)
+    {
+        m_PositionKeys.assign(positionKeys.begin(), positionKeys.end());
+        m_RotationKeys.assign(rotationKeys.begin(), rotationKeys.end());
+    }
+
+    // Track without any keys, joint keeps it's relative transform
+    bool IsEmpty() const
+    {
+        return m_PositionKeys.empty() && m_RotationKeys.empty();
+    }
+
+private:
+    std::vector<VectorProperty> m_PositionKeys;
+    std::vector<QuatProperty> m_RotationKeys;
+
+    template <typename T>
+    size_t GetIndex(float animationTime, const std::vector<KeyProperty<T>>& timestamps) const;
+
+    template <typename T>
+    void FindKeyframes(float animationTime, const std::vector<KeyProperty<T>>& keys, T& outFrom, T& outTo, float& outFactor) const;
+};
+
+struct SkeletalAnimation
+{
+    // Duration in ticks
+    float Duration{0.0f};
+    float TicksPerSecond{0.0f};
+
+    // tracks indexed by joint of skeleton owning this animation. Empty track means joint isn't animated
+    std::vector<BoneAnimationTrack> JointTracks;
+
+    glm::mat4 GetJointTransformOrRelative(int jointIndex, const glm::mat4& relativeTransform, float animationTime) const;
+};
+
+template<>
+inline glm::vec3 BoneAnimationTrack::Interpolate(float animationTime) const
+{
+    if (m_PositionKeys.size() == 1)
+    {
+        return m_PositionKeys[0].Property;
+    }
+    else if (!m_PositionKeys.empty())
+    {
+        size_t positionIndex = GetIndex(animationTime, m_PositionKeys);
+        size_t nextPositionIndex = positionIndex + 1;
+
+        float deltaTime = m_PositionKeys[nextPositionIndex].Timestamp - m_PositionKeys[positionIndex].Timestamp;
+        float factor = (animationTime - m_PositionKeys[positionIndex].Timestamp) / deltaTime;
+        ASSERT(factor >= 0 && factor <= 1);
+
+        return glm::mix(m_PositionKeys[positionIndex].Property, m_PositionKeys[nextPositionIndex].Property, factor);
+    }
+    else
+    {
+        return glm::vec3{0, 0, 0};
+    }
+}
+
+template<>
+inline glm::quat BoneAnimationTrack::Interpolate(float animationTime) const
+{
+    if (m_RotationKeys.size() == 1)
+    {
+        // not enough keys, use first key as base
+        return m_RotationKeys[0].Property;
+    }
+    else if (!m_RotationKeys.empty())
+    {
+        // find time range based on animationTime
+        size_t rotationIndex = GetIndex(animationTime, m_RotationKeys);
+        size_t nextRotationIndex = rotationIndex + 1;
+
+        float deltaTime = m_RotationKeys[nextRotationIndex].Timestamp - m_RotationKeys[rotationIndex].Timestamp;
+        float factor = (animationTime - m_RotationKeys[rotationIndex].Timestamp) / deltaTime;
+        ASSERT(factor >= 0 && factor <= 1);
+        return glm::mix(m_RotationKeys[rotationIndex].Property, m_RotationKeys[nextRotationIndex].Property, factor);
+    }
+
+    return glm::quat{glm::vec3{0, 0, 0}};
+}
+
+
+template <typename T>
+inline size_t BoneAnimationTrack::GetIndex(float animationTime, const std::vector<KeyProperty<T>>& keys) const
+{
+    ASSERT(keys.size() > 0 && "Called BoneAnimationTrack::GetIndex with track without keys");
+
+    // run binary search to find first timestamp that is greater than animationTime (max in time range)
+    auto it = std::lower_bound(keys.begin(), keys.end(), animationTime, [](const KeyProperty<T>& k, float time)
+    {
+        return time > k.Timestamp;
+    });
+
+    bool bLastAnimTimestamp = it == keys.end();
+    if (bLastAnimTimestamp)
+    {
+        return keys.size() > 2 ? static_cast<uint32_t>(keys.size() - 2) : 0;
+    }
+
+    size_t leftSideRange = static_cast<size_t>(std::distance(keys.begin(), it));
+
+    if (leftSideRange != 0)
+    {
+        // if it's not a first frame of animation, adjust that i now defines left side of range
+        // otherwise it's just range {0, 1}
+        --leftSideRange;
+    }
+
+    return leftSideRange;
+}
+
+template <typename T>
+inline void BoneAnimationTrack::FindKeyframes(float animationTime, const std::vector<KeyProperty<T>>& keys, T& outFrom, T& outTo, float& outFactor) const
+{
+    outFactor = 0.0f;
+
+    if (keys.size() == 1)
+    {
+        outFrom = outTo = keys[0].Property;
+    }
+    else if (!keys.empty())
+    {
+        size_t index = GetIndex(animationTime, keys);
+        size_t nextIndex = index + 1;
+
+        float deltaTime = keys[nextIndex].Timestamp - keys[index].Timestamp;
+
+        outFrom = keys[index].Property;
+        outTo = keys[nextIndex].Property;
+        outFactor = glm::clamp((animationTime - keys[index].Timestamp) / deltaTime, 0.0f, 1.0f);
+    }
+}
+
+inline void BoneAnimationTrack::FindPositionKeyframes(float animationTime, glm::vec3& outFrom, glm::vec3& outTo, float& outFactor) const
+{
+    outFrom = outTo = glm::vec3{0, 0, 0};
+    FindKeyframes(animationTime, m_PositionKeys, outFrom, outTo, outFactor);
+}
+
+inline void BoneAnimationTrack::FindRotationKeyframes(float animationTime, glm::quat& outFrom, glm::quat& outTo, float& outFactor) const
+{
+    outFrom = outTo = glm::quat{glm::vec3{0, 0, 0}};
+    FindKeyframes(animationTime, m_RotationKeys, outFrom, outTo, outFactor);
+}
+
+inline void BoneAnimationTrack::AddNewPositionTimestamp(glm::vec3 position, float timestamp)
+{
+    m_PositionKeys.emplace_back(VectorProperty{position, timestamp});
+}
+
+inline void BoneAnimationTrack::AddNewRotationTimestamp(glm::quat Rotation, float timestamp)
+{
+    m_RotationKeys.emplace_back(QuatProperty{Rotation, timestamp});
+}
+
+inline glm::mat4 SkeletalAnimation::GetJointTransformOrRelative(int jointIndex, const glm::mat4& relativeTransform, float animationTime) const
+{
+    const BoneAnimationTrack& track = JointTracks[jointIndex];
+
+    if (track.IsEmpty())
+    {
+        // joint isn't animated, so take default relative transform
+        return relativeTransform;
+    }
+
+    glm::vec3 position = track.Interpolate<glm::vec3>(animationTime);
+    glm::quat rotation = track.Interpolate<glm::quat>(animationTime);
+    return glm::translate(glm::identity<glm::mat4>(), position) * glm::mat4_cast(rotation);
+}
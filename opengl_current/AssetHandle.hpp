@@ -0,0 +1,65 @@
+#pragma once
+
+#include <chrono>
+#include <future>
+#include <memory>
+
+// Handle to asset loaded in background by ResourceManager. It's returned immediately, so
+// caller can keep drawing placeholder until asset is ready
+template <typename T>
+class AssetHandle
+{
+public:
+    AssetHandle() = default;
+    AssetHandle(std::shared_future<std::shared_ptr<T>> future, std::shared_ptr<T> placeholder);
+
+    // Handle of asset that is already loaded
+    AssetHandle(std::shared_ptr<T> asset);
+
+    // Returns true when loading finished, even if it failed
+    bool IsReady() const;
+
+    // Returns loaded asset or placeholder when asset is still loading or failed to load
+    std::shared_ptr<T> Get() const;
+
+private:
+    std::shared_future<std::shared_ptr<T>> m_Future;
+    std::shared_ptr<T> m_Placeholder;
+    std::shared_ptr<T> m_Asset;
+};
+
+template <typename T>
+inline AssetHandle<T>::AssetHandle(std::shared_future<std::shared_ptr<T>> future, std::shared_ptr<T> placeholder) :
+    m_Future{std::move(future)},
+    m_Placeholder{std::move(placeholder)}
+{
+}
+
+template <typename T>
+inline AssetHandle<T>::AssetHandle(std::shared_ptr<T> asset) :
+    m_Asset{std::move(asset)}
+{
+}
+
+template <typename T>
+inline bool AssetHandle<T>::IsReady() const
+{
+    return m_Asset != nullptr || (m_Future.valid() && m_Future.wait_for(std::chrono::seconds{0}) == std::future_status::ready);
+}
+
+template <typename T>
+inline std::shared_ptr<T> AssetHandle<T>::Get() const
+{
+    if (m_Asset)
+    {
+        return m_Asset;
+    }
+
+    if (!IsReady())
+    {
+        return m_Placeholder;
+    }
+
+    const std::shared_ptr<T>& asset = m_Future.get();
+    return asset ? asset : m_Placeholder;
+}
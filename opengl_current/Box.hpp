@@ -39,10 +39,25 @@ struct Box
         return (MaxBounds - MinBounds) / 2.0f;
     }
 
+    // Returns axis aligned box enclosing this box after transformation (including rotation and scale)
     Box TransformedBy(const glm::mat4& transform) const
     {
         glm::vec3 origin = transform * glm::vec4(GetOrigin(), 1.0f);
-        return FromOriginAndExtend(origin, GetExtend());
+        glm::vec3 extend = GetExtend();
+
+        // each axis of new extend is sum of projected extends
+        glm::vec3 newExtend = glm::abs(glm::vec3{transform[0]}) * extend.x +
+            glm::abs(glm::vec3{transform[1]}) * extend.y +
+            glm::abs(glm::vec3{transform[2]}) * extend.z;
+
+        return FromOriginAndExtend(origin, newExtend);
+    }
+
+    // Grows box so it contains other box
+    void Encapsulate(const Box& other)
+    {
+        MinBounds = glm::min(MinBounds, other.MinBounds);
+        MaxBounds = glm::max(MaxBounds, other.MaxBounds);
     }
 
     bool IsIntersectingWithBox(const Box& box) const;
@@ -0,0 +1,128 @@
+#include "CookedMesh.hpp"
+#include "ResourceManager.hpp"
+#include "Texture.hpp"
+#include "Logging.hpp"
+#include "AssimpUtils.hpp"
+
+#include <assimp/version.h>
+
+CookedMeshHeader CookedMeshHeader::Create(CookedMeshType type, uint32_t vertexStride)
+{
+    CookedMeshHeader header;
+    header.Type = type;
+    header.VertexStride = vertexStride;
+
+    return header;
+}
+
+bool CookedMeshHeader::IsValid(const CookedMeshHeader& expected) const
+{
+    return Magic == CookedMeshMagic && Version == expected.Version && Type == expected.Type && VertexStride == expected.VertexStride;
+}
+
+std::optional<DerivedDataKey> MakeCookedMeshKey(const std::filesystem::path& sourcePath, CookedMeshType type)
+{
+    // new version of importer may produce different data from the same source
+    const uint32_t versions[] = {CookedMeshVersion, aiGetVersionMajor(), aiGetVersionMinor(), aiGetVersionRevision()};
+    uint64_t version = DerivedDataCache::HashBytes(std::as_bytes(std::span{versions}));
+
+    return DerivedDataCache::MakeKeyFromFile(type == CookedMeshType::Static ? "StaticMesh" : "SkeletalMesh", version,
+        AssimpImportFlags, sourcePath);
+}
+
+void BinaryWriter::WriteString(std::string_view string)
+{
+    Write(static_cast<uint32_t>(string.size()));
+    WriteBytes(string.data(), string.size());
+}
+
+void BinaryWriter::Align(size_t alignment)
+{
+    size_t alignedSize = (m_Data.size() + alignment - 1) / alignment * alignment;
+    m_Data.resize(alignedSize, std::byte{0});
+}
+
+void BinaryWriter::WriteBytes(const void* data, size_t numBytes)
+{
+    const std::byte* bytes = static_cast<const std::byte*>(data);
+    m_Data.insert(m_Data.end(), bytes, bytes + numBytes);
+}
+
+BinaryReader::BinaryReader(std::span<const std::byte> data) :
+    m_Data{data}
+{
+}
+
+std::string BinaryReader::ReadString()
+{
+    uint32_t length = Read<uint32_t>();
+    const std::byte* bytes = ReadBytes(length);
+
+    if (bytes == nullptr)
+    {
+        return std::string{};
+    }
+
+    return std::string{reinterpret_cast<const char*>(bytes), length};
+}
+
+void BinaryReader::Align(size_t alignment)
+{
+    m_Offset = (m_Offset + alignment - 1) / alignment * alignment;
+}
+
+const std::byte* BinaryReader::ReadBytes(size_t numBytes)
+{
+    if (m_bFailed || m_Offset > m_Data.size() || numBytes > m_Data.size() - m_Offset)
+    {
+        m_bFailed = true;
+        return nullptr;
+    }
+
+    const std::byte* bytes = m_Data.data() + m_Offset;
+    m_Offset += numBytes;
+    return bytes;
+}
+
+DecodedTexture DecodeEmbeddedTexture(const EmbeddedTextureData& texture)
+{
+    return DecodedTexture{texture.Name, LoadRgbaImageFromMemory(texture.Data.data(), static_cast<int>(texture.Data.size()))};
+}
+
+void WriteEmbeddedTextures(BinaryWriter& writer, std::span<const EmbeddedTextureData> textures)
+{
+    writer.Write(static_cast<uint32_t>(textures.size()));
+
+    for (const EmbeddedTextureData& texture : textures)
+    {
+        writer.WriteString(texture.Name);
+        writer.WriteArray(texture.Data);
+    }
+}
+
+void ReadEmbeddedTextures(BinaryReader& reader, std::vector<DecodedTexture>& outTextures)
+{
+    uint32_t numTextures = reader.Read<uint32_t>();
+
+    for (uint32_t i = 0; i < numTextures && !reader.HasFailed(); ++i)
+    {
+        std::string name = reader.ReadString();
+        std::span<const std::byte> data = reader.ReadArray<std::byte>();
+
+        if (reader.HasFailed())
+        {
+            return;
+        }
+
+        outTextures.emplace_back(DecodeEmbeddedTexture(EmbeddedTextureData{std::move(name), data}));
+    }
+}
+
+void AddDecodedTextures(std::span<const DecodedTexture> textures, std::vector<std::string>& outTextureNames)
+{
+    for (const DecodedTexture& texture : textures)
+    {
+        ResourceManager::AddTexture2D(texture.Name, std::make_shared<Texture2D>(texture.Image));
+        outTextureNames.emplace_back(texture.Name);
+    }
+}
@@ -0,0 +1,180 @@
+#pragma once
+
+#include "MappedFile.hpp"
+#include "DerivedDataCache.hpp"
+#include "ImageRgba.hpp"
+#include "ErrorMacros.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+inline constexpr uint32_t CookedMeshMagic = 0x4853454D; // "MESH"
+
+// Increase when layout of cooked data or vertex format changes, so old files are cooked again
+inline constexpr uint32_t CookedMeshVersion = 2;
+
+// arrays in cooked file start at this alignment, so they can be used in place from mapping
+inline constexpr size_t CookedArrayAlignment = 16;
+
+enum class CookedMeshType : uint32_t
+{
+    Static,
+    Skeletal
+};
+
+// Header at start of cooked mesh data. Stale data is detected by key of derived data cache, header only guards layout
+struct CookedMeshHeader
+{
+    uint32_t Magic{CookedMeshMagic};
+    uint32_t Version{CookedMeshVersion};
+    CookedMeshType Type{CookedMeshType::Static};
+    uint32_t VertexStride{0};
+
+    static CookedMeshHeader Create(CookedMeshType type, uint32_t vertexStride);
+
+    bool IsValid(const CookedMeshHeader& expected) const;
+};
+
+// Cooked meshes are stored in derived data cache, keyed by bytes of source file, import flags and version of Assimp.
+// Returns nullopt when source file can't be read
+std::optional<DerivedDataKey> MakeCookedMeshKey(const std::filesystem::path& sourcePath, CookedMeshType type);
+
+// Serializes plain data to memory blob that is later saved as a whole
+class BinaryWriter
+{
+public:
+    template <typename T>
+    void Write(const T& value);
+
+    // Writes number of elements followed by array data aligned to CookedArrayAlignment
+    template <typename T>
+    void WriteArray(std::span<const T> values);
+
+    void WriteString(std::string_view string);
+    void Align(size_t alignment);
+
+    std::span<const std::byte> GetData() const
+    {
+        return m_Data;
+    }
+
+private:
+    std::vector<std::byte> m_Data;
+
+private:
+    void WriteBytes(const void* data, size_t numBytes);
+};
+
+// Reads data written by BinaryWriter. Arrays are returned as spans pointing into read memory, so
+// when reading from MappedFile nothing is copied. Reading past end of data marks reader as failed
+class BinaryReader
+{
+public:
+    BinaryReader(std::span<const std::byte> data);
+
+    template <typename T>
+    T Read();
+
+    template <typename T>
+    std::span<const T> ReadArray();
+
+    std::string ReadString();
+    void Align(size_t alignment);
+
+    bool HasFailed() const
+    {
+        return m_bFailed;
+    }
+
+private:
+    std::span<const std::byte> m_Data;
+    size_t m_Offset{0};
+    bool m_bFailed{false};
+
+private:
+    const std::byte* ReadBytes(size_t numBytes);
+};
+
+// Texture embedded in mesh source file, stored still encoded
+struct EmbeddedTextureData
+{
+    std::string Name;
+    std::span<const std::byte> Data;
+};
+
+// Embedded texture decoded on loading thread. GPU texture is created from it later on main thread
+struct DecodedTexture
+{
+    std::string Name;
+    ImageRgba Image;
+};
+
+DecodedTexture DecodeEmbeddedTexture(const EmbeddedTextureData& texture);
+
+void WriteEmbeddedTextures(BinaryWriter& writer, std::span<const EmbeddedTextureData> textures);
+
+// Decodes embedded textures stored in cooked file
+void ReadEmbeddedTextures(BinaryReader& reader, std::vector<DecodedTexture>& outTextures);
+
+// Creates GPU textures and adds them to ResourceManager. Must be called on main thread
+void AddDecodedTextures(std::span<const DecodedTexture> textures, std::vector<std::string>& outTextureNames);
+
+template <typename T>
+FORCE_INLINE void BinaryWriter::Write(const T& value)
+{
+    static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable types can be written as bytes");
+    WriteBytes(&value, sizeof(T));
+}
+
+template <typename T>
+FORCE_INLINE void BinaryWriter::WriteArray(std::span<const T> values)
+{
+    static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable types can be written as bytes");
+    Write(static_cast<uint64_t>(values.size()));
+    Align(CookedArrayAlignment);
+    WriteBytes(values.data(), values.size_bytes());
+}
+
+template <typename T>
+FORCE_INLINE T BinaryReader::Read()
+{
+    static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable types can be read as bytes");
+    T value{};
+    const std::byte* bytes = ReadBytes(sizeof(T));
+
+    if (bytes != nullptr)
+    {
+        std::memcpy(&value, bytes, sizeof(T));
+    }
+
+    return value;
+}
+
+template <typename T>
+FORCE_INLINE std::span<const T> BinaryReader::ReadArray()
+{
+    static_assert(std::is_trivially_copyable_v<T> && alignof(T) <= CookedArrayAlignment);
+    uint64_t numElements = Read<uint64_t>();
+    Align(CookedArrayAlignment);
+
+    if (numElements > m_Data.size() / sizeof(T))
+    {
+        m_bFailed = true;
+        return {};
+    }
+
+    const std::byte* bytes = ReadBytes(numElements * sizeof(T));
+
+    if (bytes == nullptr)
+    {
+        return {};
+    }
+
+    return std::span<const T>{reinterpret_cast<const T*>(bytes), static_cast<size_t>(numElements)};
+}
@@ -1,9 +1,16 @@
 #include "Debug.hpp"
 #include "RenderCommand.hpp"
-#include "LevelInterface.hpp"
+#include "ErrorMacros.hpp"
 
 #include "Material.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+
 struct DebugVertex
 {
     glm::vec3 Position;
@@ -19,149 +26,213 @@ static constexpr uint32_t BaseBoxIndices[24] =
     0, 4, 1, 5, 2, 6, 3, 7
 };
 
-constexpr int MaxNumDebugVertices{2000};
-constexpr int MaxNumDebugIndices{3 * 2000};
+// Vertices above this number are uploaded and drawn in following draws of the same flush. Must be even,
+// so lines aren't split between draws
+constexpr int MaxNumDebugVerticesPerDraw{65536};
 
 glm::mat4 Debug::s_ProjectionViewMatrix{1.0f};
 
-class DebugRendererBatch
+// Camera of current scene used to project screen space rects, guarded, because BeginScene may run while other threads draw
+static std::mutex s_SceneMutex;
+static glm::mat4 s_SceneProjectionView{1.0f};
+static Viewport s_SceneViewport;
+
+using DebugClock = std::chrono::steady_clock;
+
+// Lines added by single thread since last flush. Only owning thread and flush access it, so mutex is almost never contended
+struct DebugThreadBuffer
 {
-public:
-    DebugRendererBatch(std::shared_ptr<Shader> debugShader) :
-        m_Material{std::make_shared<Material>(debugShader)}
+    struct TimedRange
     {
-        m_Material->bCullFaces = false;
+        float Duration;
+        uint32_t NumVertices;
+    };
 
-        auto vertexBuffer = std::make_shared<VertexBuffer>(static_cast<int>(MaxNumDebugVertices * sizeof(DebugVertex)));
-        auto indexBuffer = std::make_shared<IndexBuffer>(MaxNumDebugIndices);
+    std::mutex Mutex;
 
-        m_Vertices.resize(MaxNumDebugVertices);
-        m_Indices.resize(MaxNumDebugIndices);
+    // drawn in next flush only
+    std::vector<DebugVertex> Vertices;
 
-        constexpr std::array<VertexAttribute, 2> DebugVertexDataFormat{VertexAttribute{3, PrimitiveVertexType::Float}, VertexAttribute{1, PrimitiveVertexType::UnsignedInt}};
+    // timed and persistent lines, ranges are consecutive
+    std::vector<DebugVertex> TimedVertices;
+    std::vector<TimedRange> TimedRanges;
+};
 
-        m_VertexArray.AddVertexBuffer(vertexBuffer, DebugVertexDataFormat);
-        m_VertexArray.SetIndexBuffer(indexBuffer);
-    }
+static std::mutex s_ThreadBuffersMutex;
+
+// Buffer stays registered after its thread ends, so lines it added before are still drawn
+static std::vector<std::shared_ptr<DebugThreadBuffer>> s_ThreadBuffers;
+
+static DebugThreadBuffer& GetThreadBuffer()
+{
+    thread_local std::shared_ptr<DebugThreadBuffer> buffer;
 
-    void AddBoxInstance(const Box& box, const Transform& transform, const glm::vec4& color)
+    if (!buffer)
     {
-        RgbaColor packedColor{color};
+        buffer = std::make_shared<DebugThreadBuffer>();
+        std::lock_guard lock{s_ThreadBuffersMutex};
+        s_ThreadBuffers.emplace_back(buffer);
+    }
 
-        std::array<DebugVertex, 8> boxVertices = {
-            DebugVertex{glm::vec3{box.MinBounds[0], box.MinBounds[1], box.MinBounds[2]}, packedColor},
-            DebugVertex{glm::vec3{box.MaxBounds[0], box.MinBounds[1], box.MinBounds[2]}, packedColor},
-            DebugVertex{glm::vec3{box.MaxBounds[0], box.MaxBounds[1], box.MinBounds[2]}, packedColor},
-            DebugVertex{glm::vec3{box.MinBounds[0], box.MaxBounds[1], box.MinBounds[2]}, packedColor},
+    return *buffer;
+}
 
-            DebugVertex{glm::vec3{box.MinBounds[0], box.MinBounds[1], box.MaxBounds[2]}, packedColor},
-            DebugVertex{glm::vec3{box.MaxBounds[0], box.MinBounds[1], box.MaxBounds[2]}, packedColor},
-            DebugVertex{glm::vec3{box.MaxBounds[0], box.MaxBounds[1], box.MaxBounds[2]}, packedColor},
-            DebugVertex{glm::vec3{box.MinBounds[0], box.MaxBounds[1], box.MaxBounds[2]}, packedColor}
-        };
+// Transforms vertices and appends them to buffer of calling thread as line list
+static void AddGeometry(std::span<const DebugVertex> vertices, std::span<const uint32_t> indices, const glm::mat4& transform, float duration)
+{
+    std::array<DebugVertex, 8> transformedVertices;
+    ASSERT(vertices.size() <= transformedVertices.size());
 
-        glm::mat4 combinedTransform = transform.CalculateTransformMatrix();
-        AddGeometry(boxVertices, BaseBoxIndices, combinedTransform);
+    for (size_t i = 0; i < vertices.size(); ++i)
+    {
+        transformedVertices[i] = DebugVertex{transform * glm::vec4{vertices[i].Position, 1.0f}, vertices[i].Color};
     }
 
-    void AddLineInstance(const Line& line, const Transform& transform, const glm::vec4& color)
-    {
-        RgbaColor packedColor{color};
+    DebugThreadBuffer& buffer = GetThreadBuffer();
+    std::lock_guard lock{buffer.Mutex};
 
-        std::array vertices = {
-            DebugVertex{line.StartPos, packedColor},
-            DebugVertex{line.EndPos, packedColor},
-        };
+    std::vector<DebugVertex>& destination = duration > 0.0f ? buffer.TimedVertices : buffer.Vertices;
 
-        constexpr uint32_t LineIndices[] = {0, 1};
-        glm::mat4 combinedTransform = transform.CalculateTransformMatrix();
-        AddGeometry(vertices, LineIndices, combinedTransform);
+    for (uint32_t index : indices)
+    {
+        destination.emplace_back(transformedVertices[index]);
     }
 
-    void AddRectInstance(glm::vec2 position, glm::vec2 size, const Transform& transform, const glm::vec4& color)
+    if (duration > 0.0f)
     {
-        // Offset to add to prevent flickering when camera moves
-        constexpr float FlickeringStopOffset = 0.5f;
+        buffer.TimedRanges.emplace_back(DebugThreadBuffer::TimedRange{duration, static_cast<uint32_t>(indices.size())});
+    }
+}
 
-        RgbaColor packedColor{color};
+class DebugRendererBatch
+{
+public:
+    DebugRendererBatch(std::shared_ptr<Shader> debugShader) :
+        m_Material{std::make_shared<Material>(debugShader)}
+    {
+        m_Material->bCullFaces = false;
 
-        // rect data initialized with screen space vertices
-        std::array vertices = {
-            DebugVertex{glm::vec3{position, 0}, packedColor},
-            DebugVertex{glm::vec3{position.x + size.x, position.y, FlickeringStopOffset}, packedColor},
-            DebugVertex{glm::vec3{position.x + size.x, position.y + size.y, FlickeringStopOffset}, packedColor},
-            DebugVertex{glm::vec3{position.x, position.y + size.y, FlickeringStopOffset}, packedColor},
-        };
+        auto vertexBuffer = std::make_shared<VertexBuffer>(static_cast<int>(MaxNumDebugVerticesPerDraw * sizeof(DebugVertex)));
 
-        // DebugVertexBatch requires vertices to be in world space so project every point to world
-        for (DebugVertex& vertex : vertices)
-        {
-            vertex.Position = LevelInterface::ProjectScreenToWorld(vertex.Position);
-        }
+        constexpr std::array<VertexAttribute, 2> DebugVertexDataFormat{VertexAttribute{3, PrimitiveVertexType::Float}, VertexAttribute{1, PrimitiveVertexType::UnsignedInt}};
 
-        constexpr uint32_t RectIndices[] = {0, 1, 1, 2, 2, 3, 3, 0};
-        glm::mat4 combinedTransform = transform.CalculateTransformMatrix();
-        AddGeometry(vertices, RectIndices, combinedTransform);
+        m_VertexArray.AddVertexBuffer(vertexBuffer, DebugVertexDataFormat);
     }
 
     void FlushDraw()
     {
+        DebugClock::time_point now = DebugClock::now();
+
+        RemoveExpiredLines(now);
+        MergeThreadBuffers(now);
+
+        if (m_Vertices.empty() && m_TimedVertices.empty())
+        {
+            return;
+        }
+
         m_VertexArray.Bind();
-        UploadBufferData();
 
         std::shared_ptr<Shader> shader = m_Material->GetShader();
 
         shader->Use();
         shader->SetUniform("u_ProjectionView", Debug::GetProjectionViewMatrix());
 
-        RenderCommand::DrawLines(m_VertexArray, m_NumDrawIndices);
+        DrawInChunks(m_Vertices);
+        DrawInChunks(m_TimedVertices);
 
-        m_NumDrawIndices = 0;
-        m_NumDrawVertices = 0;
+        m_Vertices.clear();
         m_VertexArray.Unbind();
     }
 
+    void ClearTimedLines()
+    {
+        m_TimedVertices.clear();
+        m_TimedRanges.clear();
+    }
+
 private:
+    struct TimedRange
+    {
+        DebugClock::time_point ExpireTime;
+        uint32_t NumVertices;
+    };
+
     std::vector<DebugVertex> m_Vertices;
-    std::vector<uint32_t> m_Indices;
+    std::vector<DebugVertex> m_TimedVertices;
+    std::vector<TimedRange> m_TimedRanges;
     VertexArray m_VertexArray;
 
-    int m_NumDrawVertices{0};
-    int m_NumDrawIndices{0};
     std::shared_ptr<Material> m_Material;
-    bool m_bBuffersDirty{false};
 
 private:
-    void UploadBufferData()
+    void MergeThreadBuffers(DebugClock::time_point now)
     {
-        if (m_bBuffersDirty)
+        std::lock_guard lock{s_ThreadBuffersMutex};
+
+        for (const std::shared_ptr<DebugThreadBuffer>& buffer : s_ThreadBuffers)
         {
-            std::shared_ptr<VertexBuffer> vertexBuffer = m_VertexArray.GetVertexBufferAt(0);
-            std::shared_ptr<IndexBuffer> indexBuffer = m_VertexArray.GetIndexBuffer();
+            std::lock_guard bufferLock{buffer->Mutex};
+
+            m_Vertices.insert(m_Vertices.end(), buffer->Vertices.begin(), buffer->Vertices.end());
+            m_TimedVertices.insert(m_TimedVertices.end(), buffer->TimedVertices.begin(), buffer->TimedVertices.end());
 
-            vertexBuffer->Update(std::span<const DebugVertex>{m_Vertices.data(), static_cast<size_t>(m_NumDrawVertices)});
-            indexBuffer->UpdateIndices(m_Indices.data(), m_NumDrawIndices);
-            m_bBuffersDirty = false;
+            for (const DebugThreadBuffer::TimedRange& range : buffer->TimedRanges)
+            {
+                // duration is counted from first flush which draws line
+                DebugClock::time_point expireTime = range.Duration == DebugDrawPersistent ? DebugClock::time_point::max() :
+                    now + std::chrono::duration_cast<DebugClock::duration>(std::chrono::duration<float>{range.Duration});
+
+                m_TimedRanges.emplace_back(TimedRange{expireTime, range.NumVertices});
+            }
+
+            // capacity is kept, so threads don't allocate again next frame
+            buffer->Vertices.clear();
+            buffer->TimedVertices.clear();
+            buffer->TimedRanges.clear();
         }
+
+        // buffers of finished threads are held only by this list
+        auto finishedBuffers = std::remove_if(s_ThreadBuffers.begin(), s_ThreadBuffers.end(),
+            [](const std::shared_ptr<DebugThreadBuffer>& buffer) { return buffer.use_count() == 1; });
+        s_ThreadBuffers.erase(finishedBuffers, s_ThreadBuffers.end());
     }
 
-    void AddGeometry(std::span<const DebugVertex> vertices, std::span<const uint32_t> indices, const glm::mat4& transform)
+    void RemoveExpiredLines(DebugClock::time_point now)
     {
-        for (uint32_t index : indices)
+        size_t readVertex = 0;
+        size_t writeVertex = 0;
+        size_t writeRange = 0;
+
+        for (const TimedRange& range : m_TimedRanges)
         {
-            m_Indices[m_NumDrawIndices] = index + m_NumDrawVertices;
-            m_NumDrawIndices++;
+            if (range.ExpireTime > now)
+            {
+                std::copy_n(m_TimedVertices.begin() + readVertex, range.NumVertices, m_TimedVertices.begin() + writeVertex);
+                m_TimedRanges[writeRange++] = range;
+                writeVertex += range.NumVertices;
+            }
+
+            readVertex += range.NumVertices;
         }
 
-        for (const DebugVertex& vertex : vertices)
+        m_TimedVertices.resize(writeVertex);
+        m_TimedRanges.resize(writeRange);
+    }
+
+    void DrawInChunks(std::span<const DebugVertex> vertices)
+    {
+        std::shared_ptr<VertexBuffer> vertexBuffer = m_VertexArray.GetVertexBufferAt(0);
+
+        for (size_t start = 0; start < vertices.size(); start += MaxNumDebugVerticesPerDraw)
         {
-            DebugVertex transformedVertex = vertex;
-            transformedVertex.Position = transform * glm::vec4{vertex.Position, 1.0f};
-            m_Vertices[m_NumDrawVertices] = transformedVertex;
-            m_NumDrawVertices++;
-        }
+            std::span<const DebugVertex> chunk = vertices.subspan(start, std::min<size_t>(vertices.size() - start, MaxNumDebugVerticesPerDraw));
 
-        m_bBuffersDirty = true;
+            // previous chunk may still be read by GPU, orphaning gives new storage instead of waiting for it
+            vertexBuffer->Orphan();
+            vertexBuffer->Update(chunk);
+            RenderCommand::DrawLineArrays(m_VertexArray, static_cast<int>(chunk.size()));
+        }
     }
 };
 
@@ -172,31 +243,104 @@ void Debug::Quit()
     SafeDelete(s_DebugRenderBatch);
 }
 
-void Debug::BeginScene(const glm::mat4& projectionViewMatrix)
+void Debug::BeginScene(const glm::mat4& projectionViewMatrix, const Viewport& viewport)
 {
     s_ProjectionViewMatrix = projectionViewMatrix;
+
+    std::lock_guard lock{s_SceneMutex};
+    s_SceneProjectionView = projectionViewMatrix;
+    s_SceneViewport = viewport;
 }
 
-void Debug::DrawDebugBox(const Box& box, const Transform& transform, const glm::vec4& color)
+void Debug::DrawDebugBox(const Box& box, const Transform& transform, const glm::vec4& color, float duration)
 {
-    s_DebugRenderBatch->AddBoxInstance(box, transform, color);
+    RgbaColor packedColor{color};
+
+    std::array<DebugVertex, 8> boxVertices = {
+        DebugVertex{glm::vec3{box.MinBounds[0], box.MinBounds[1], box.MinBounds[2]}, packedColor},
+        DebugVertex{glm::vec3{box.MaxBounds[0], box.MinBounds[1], box.MinBounds[2]}, packedColor},
+        DebugVertex{glm::vec3{box.MaxBounds[0], box.MaxBounds[1], box.MinBounds[2]}, packedColor},
+        DebugVertex{glm::vec3{box.MinBounds[0], box.MaxBounds[1], box.MinBounds[2]}, packedColor},
+
+        DebugVertex{glm::vec3{box.MinBounds[0], box.MinBounds[1], box.MaxBounds[2]}, packedColor},
+        DebugVertex{glm::vec3{box.MaxBounds[0], box.MinBounds[1], box.MaxBounds[2]}, packedColor},
+        DebugVertex{glm::vec3{box.MaxBounds[0], box.MaxBounds[1], box.MaxBounds[2]}, packedColor},
+        DebugVertex{glm::vec3{box.MinBounds[0], box.MaxBounds[1], box.MaxBounds[2]}, packedColor}
+    };
+
+    AddGeometry(boxVertices, BaseBoxIndices, transform.CalculateTransformMatrix(), duration);
 }
 
-void Debug::DrawDebugLine(const Line& line, const Transform& transform, const glm::vec4& color)
+void Debug::DrawDebugLine(const Line& line, const Transform& transform, const glm::vec4& color, float duration)
 {
-    s_DebugRenderBatch->AddLineInstance(line, transform, color);
+    RgbaColor packedColor{color};
+
+    std::array vertices = {
+        DebugVertex{line.StartPos, packedColor},
+        DebugVertex{line.EndPos, packedColor},
+    };
+
+    constexpr uint32_t LineIndices[] = {0, 1};
+    AddGeometry(vertices, LineIndices, transform.CalculateTransformMatrix(), duration);
 }
 
-void Debug::DrawDebugRect(glm::vec2 position, glm::vec2 size, const Transform& transform, const glm::vec4& color)
+void Debug::DrawDebugRect(glm::vec2 position, glm::vec2 size, const Transform& transform, const glm::vec4& color, float duration)
 {
-    s_DebugRenderBatch->AddRectInstance(position, size, transform, color);
+    // Offset to add to prevent flickering when camera moves
+    constexpr float FlickeringStopOffset = 0.5f;
+
+    RgbaColor packedColor{color};
+
+    // rect data initialized with screen space vertices
+    std::array vertices = {
+        DebugVertex{glm::vec3{position, 0}, packedColor},
+        DebugVertex{glm::vec3{position.x + size.x, position.y, FlickeringStopOffset}, packedColor},
+        DebugVertex{glm::vec3{position.x + size.x, position.y + size.y, FlickeringStopOffset}, packedColor},
+        DebugVertex{glm::vec3{position.x, position.y + size.y, FlickeringStopOffset}, packedColor},
+    };
+
+    glm::mat4 projectionView;
+    glm::vec4 viewport;
+
+    {
+        std::lock_guard lock{s_SceneMutex};
+        projectionView = s_SceneProjectionView;
+        viewport = glm::vec4{s_SceneViewport.StartPosition, s_SceneViewport.Size};
+    }
+
+    // DebugVertexBatch requires vertices to be in world space so project every point to world
+    for (DebugVertex& vertex : vertices)
+    {
+        vertex.Position = glm::unProject(vertex.Position, glm::mat4{1.0f}, projectionView, viewport);
+    }
+
+    constexpr uint32_t RectIndices[] = {0, 1, 1, 2, 2, 3, 3, 0};
+    AddGeometry(vertices, RectIndices, transform.CalculateTransformMatrix(), duration);
 }
 
 void Debug::FlushDrawDebug()
 {
+    ERR_FAIL_NULL_MSG(s_DebugRenderBatch, "Debug draw isn't initialized");
     s_DebugRenderBatch->FlushDraw();
 }
 
+void Debug::ClearPersistentDebugDraw()
+{
+    if (s_DebugRenderBatch != nullptr)
+    {
+        s_DebugRenderBatch->ClearTimedLines();
+    }
+
+    std::lock_guard lock{s_ThreadBuffersMutex};
+
+    for (const std::shared_ptr<DebugThreadBuffer>& buffer : s_ThreadBuffers)
+    {
+        std::lock_guard bufferLock{buffer->Mutex};
+        buffer->TimedVertices.clear();
+        buffer->TimedRanges.clear();
+    }
+}
+
 void Debug::InitializeDebugDraw(const std::shared_ptr<Shader>& debugShader)
 {
     SafeDelete(s_DebugRenderBatch);
@@ -3,7 +3,15 @@
 #include "Transform.hpp"
 #include "Box.hpp"
 #include "Shader.hpp"
+#include "Viewport.hpp"
 
+#include <limits>
+
+// Duration of debug primitive which stays drawn until Debug::ClearPersistentDebugDraw
+inline constexpr float DebugDrawPersistent = std::numeric_limits<float>::infinity();
+
+// Debug primitives can be drawn from any thread. Each thread appends them to its own buffer, buffers are merged
+// in FlushDrawDebug. Primitive with zero duration is drawn once, others are drawn in each flush until duration in seconds passes
 class Debug
 {
     friend class Game;
@@ -12,13 +20,20 @@ private:
     static void Quit();
 
 public:
-    static void BeginScene(const glm::mat4& projectionViewMatrix);
+    // Camera state is copied, so rects are projected to world without reading level from other threads
+    static void BeginScene(const glm::mat4& projectionViewMatrix, const Viewport& viewport);
 
-    static void DrawDebugBox(const Box& box, const Transform& transform, const glm::vec4& color = glm::vec4{1, 1, 1, 1});
-    static void DrawDebugLine(const Line& line, const Transform& transform, const glm::vec4& color = glm::vec4{1, 1, 1, 1});
-    static void DrawDebugRect(glm::vec2 position, glm::vec2 size, const Transform& transform, const glm::vec4& color = glm::vec4{1, 1, 1, 1});
+    static void DrawDebugBox(const Box& box, const Transform& transform, const glm::vec4& color = glm::vec4{1, 1, 1, 1}, float duration = 0.0f);
+    static void DrawDebugLine(const Line& line, const Transform& transform, const glm::vec4& color = glm::vec4{1, 1, 1, 1}, float duration = 0.0f);
+    static void DrawDebugRect(glm::vec2 position, glm::vec2 size, const Transform& transform, const glm::vec4& color = glm::vec4{1, 1, 1, 1},
+        float duration = 0.0f);
+
+    // Must be called from rendering thread, primitives added by other threads during flush are drawn in next one
     static void FlushDrawDebug();
 
+    // Removes timed and persistent primitives
+    static void ClearPersistentDebugDraw();
+
     static glm::mat4 GetProjectionViewMatrix()
     {
         return s_ProjectionViewMatrix;
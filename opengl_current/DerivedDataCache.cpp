@@ -0,0 +1,296 @@
+#include "DerivedDataCache.hpp"
+#include "Logging.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <system_error>
+#include <vector>
+
+inline constexpr uint32_t DerivedDataMagic = 0x30434444; // "DDC0"
+inline constexpr uint32_t DerivedDataFormatVersion = 1;
+
+// Header at start of each entry. Size is multiple of 16, so arrays aligned in payload stay aligned in mapping
+struct DerivedDataHeader
+{
+    uint32_t Magic{DerivedDataMagic};
+    uint32_t FormatVersion{DerivedDataFormatVersion};
+    uint64_t KeyHash{0};
+    uint64_t PayloadSize{0};
+    uint64_t PayloadChecksum{0};
+};
+
+static_assert(sizeof(DerivedDataHeader) % 16 == 0);
+
+static std::mutex s_CacheMutex;
+static std::filesystem::path s_Directory{"DerivedDataCache"};
+static uint64_t s_MaxSize = 2ull * 1024 * 1024 * 1024;
+
+// Total size of entries, counted by first scan of directory and kept up to date by stores, so directory
+// is scanned again only when cache exceeds limit
+static std::optional<uint64_t> s_CacheSize;
+
+// Eviction removes entries until cache takes this part of limit, so following stores don't scan again right away
+constexpr uint64_t EvictionTargetPercent = 90;
+
+static std::filesystem::path GetEntryPath(const DerivedDataKey& key)
+{
+    constexpr char HexDigits[] = "0123456789abcdef";
+    char fileName[16];
+
+    for (int i = 0; i < 16; ++i)
+    {
+        fileName[i] = HexDigits[(key.Hash >> (60 - 4 * i)) & 0xF];
+    }
+
+    std::lock_guard lock{s_CacheMutex};
+    return s_Directory / (std::string{fileName, 16} + ".ddc");
+}
+
+static uint64_t RotateLeft(uint64_t value, int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+uint64_t DerivedDataCache::HashBytes(std::span<const std::byte> data, uint64_t seed)
+{
+    constexpr uint64_t Prime1 = 0x9E3779B185EBCA87ull;
+    constexpr uint64_t Prime2 = 0xC2B2AE3D27D4EB4Full;
+    constexpr uint64_t Prime3 = 0x165667B19E3779F9ull;
+
+    // 4 independent lanes, so multiplies of consecutive words don't wait for each other
+    uint64_t lanes[4] = {seed + Prime1 + Prime2, seed + Prime2, seed, seed - Prime1};
+    const std::byte* bytes = data.data();
+    size_t numBytes = data.size();
+    size_t offset = 0;
+
+    for (; offset + 32 <= numBytes; offset += 32)
+    {
+        for (int lane = 0; lane < 4; ++lane)
+        {
+            uint64_t word;
+            std::memcpy(&word, bytes + offset + lane * 8, sizeof(word));
+            lanes[lane] = RotateLeft(lanes[lane] + word * Prime2, 31) * Prime1;
+        }
+    }
+
+    uint64_t hash = RotateLeft(lanes[0], 1) + RotateLeft(lanes[1], 7) + RotateLeft(lanes[2], 12) + RotateLeft(lanes[3], 18);
+    hash += static_cast<uint64_t>(numBytes);
+
+    for (; offset < numBytes; ++offset)
+    {
+        hash = RotateLeft(hash ^ (static_cast<uint64_t>(bytes[offset]) * Prime3), 11) * Prime1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= Prime2;
+    hash ^= hash >> 29;
+    hash *= Prime3;
+    hash ^= hash >> 32;
+
+    return hash;
+}
+
+DerivedDataKey DerivedDataCache::MakeKey(std::string_view dataType, uint64_t version, uint64_t flags, std::span<const std::byte> sourceData)
+{
+    uint64_t hash = HashBytes(std::as_bytes(std::span<const char>{dataType.data(), dataType.size()}));
+    hash = HashBytes(std::as_bytes(std::span<const uint64_t>{&version, 1}), hash);
+    hash = HashBytes(std::as_bytes(std::span<const uint64_t>{&flags, 1}), hash);
+    hash = HashBytes(sourceData, hash);
+
+    return DerivedDataKey{hash};
+}
+
+std::optional<DerivedDataKey> DerivedDataCache::MakeKeyFromFile(std::string_view dataType, uint64_t version, uint64_t flags,
+    const std::filesystem::path& sourcePath)
+{
+    MappedFile sourceFile{sourcePath};
+
+    if (!sourceFile.IsOpen())
+    {
+        return std::nullopt;
+    }
+
+    return MakeKey(dataType, version, flags, sourceFile.GetData());
+}
+
+MappedFile DerivedDataCache::Load(const DerivedDataKey& key)
+{
+    std::filesystem::path entryPath = GetEntryPath(key);
+    std::error_code errorCode;
+
+    // last write time marks when entry was used, so eviction removes least recently used entries first
+    std::filesystem::last_write_time(entryPath, std::filesystem::file_time_type::clock::now(), errorCode);
+
+    if (errorCode)
+    {
+        return MappedFile{};
+    }
+
+    MappedFile entry{entryPath};
+
+    if (!entry.IsOpen())
+    {
+        return entry;
+    }
+
+    DerivedDataHeader header;
+    bool bValid = entry.GetSize() >= sizeof(DerivedDataHeader);
+
+    if (bValid)
+    {
+        std::memcpy(&header, entry.GetData().data(), sizeof(DerivedDataHeader));
+        bValid = header.Magic == DerivedDataMagic && header.FormatVersion == DerivedDataFormatVersion &&
+            header.KeyHash == key.Hash && header.PayloadSize == entry.GetSize() - sizeof(DerivedDataHeader) &&
+            header.PayloadChecksum == HashBytes(GetPayload(entry));
+    }
+
+    if (!bValid)
+    {
+        ENG_LOG_WARNING("Derived data {} is corrupted", entryPath.string());
+        uint64_t entrySize = entry.GetSize();
+        entry = MappedFile{};
+
+        if (std::filesystem::remove(entryPath, errorCode))
+        {
+            std::lock_guard lock{s_CacheMutex};
+
+            if (s_CacheSize)
+            {
+                *s_CacheSize -= std::min(*s_CacheSize, entrySize);
+            }
+        }
+    }
+
+    return entry;
+}
+
+std::span<const std::byte> DerivedDataCache::GetPayload(const MappedFile& entry)
+{
+    if (entry.GetSize() < sizeof(DerivedDataHeader))
+    {
+        return {};
+    }
+
+    return entry.GetData().subspan(sizeof(DerivedDataHeader));
+}
+
+// Scans directory and removes least recently used entries when their total size exceeds maxSize. Returns size left
+static uint64_t EvictLeastRecentlyUsed(const std::filesystem::path& directory, uint64_t maxSize)
+{
+    struct CacheEntry
+    {
+        std::filesystem::path Path;
+        std::filesystem::file_time_type LastUseTime;
+        uint64_t Size;
+    };
+
+    std::vector<CacheEntry> entries;
+    uint64_t totalSize = 0;
+    std::error_code errorCode;
+
+    for (const std::filesystem::directory_entry& file : std::filesystem::directory_iterator{directory, errorCode})
+    {
+        if (file.is_regular_file(errorCode) && file.path().extension() == ".ddc")
+        {
+            CacheEntry& entry = entries.emplace_back(CacheEntry{file.path(), file.last_write_time(errorCode), file.file_size(errorCode)});
+            totalSize += entry.Size;
+        }
+    }
+
+    if (totalSize <= maxSize)
+    {
+        return totalSize;
+    }
+
+    uint64_t targetSize = maxSize / 100 * EvictionTargetPercent;
+
+    std::sort(entries.begin(), entries.end(), [](const CacheEntry& a, const CacheEntry& b) { return a.LastUseTime < b.LastUseTime; });
+
+    for (const CacheEntry& entry : entries)
+    {
+        if (totalSize <= targetSize)
+        {
+            break;
+        }
+
+        // entry still mapped by other thread can't be removed on some platforms, then it stays until next eviction
+        if (std::filesystem::remove(entry.Path, errorCode))
+        {
+            totalSize -= entry.Size;
+            ENG_LOG_VERBOSE("Evicted derived data {}", entry.Path.string());
+        }
+    }
+
+    return totalSize;
+}
+
+void DerivedDataCache::Store(const DerivedDataKey& key, std::span<const std::byte> payload)
+{
+    DerivedDataHeader header;
+    header.KeyHash = key.Hash;
+    header.PayloadSize = payload.size();
+    header.PayloadChecksum = HashBytes(payload);
+
+    std::filesystem::path entryPath = GetEntryPath(key);
+    std::filesystem::path temporaryPath = entryPath;
+    temporaryPath += ".tmp";
+
+    std::lock_guard lock{s_CacheMutex};
+    std::error_code errorCode;
+    std::filesystem::create_directories(s_Directory, errorCode);
+
+    // entry of the same key written by other thread is replaced, so its size isn't counted twice
+    uint64_t replacedSize = std::filesystem::file_size(entryPath, errorCode);
+
+    if (errorCode)
+    {
+        replacedSize = 0;
+    }
+
+    {
+        std::ofstream file{temporaryPath, std::ios::binary | std::ios::trunc};
+
+        if (!file.is_open())
+        {
+            ENG_LOG_WARNING("Failed to save derived data {}", entryPath.string());
+            return;
+        }
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(payload.data()), static_cast<std::streamsize>(payload.size()));
+    }
+
+    // entry is written under temporary name, so other threads never map half written entry
+    std::filesystem::rename(temporaryPath, entryPath, errorCode);
+
+    if (errorCode)
+    {
+        std::filesystem::remove(temporaryPath, errorCode);
+        return;
+    }
+
+    if (s_CacheSize)
+    {
+        *s_CacheSize += sizeof(header) + payload.size() - std::min(*s_CacheSize, replacedSize);
+    }
+
+    if (!s_CacheSize || *s_CacheSize > s_MaxSize)
+    {
+        s_CacheSize = EvictLeastRecentlyUsed(s_Directory, s_MaxSize);
+    }
+}
+
+void DerivedDataCache::SetDirectory(const std::filesystem::path& directory)
+{
+    std::lock_guard lock{s_CacheMutex};
+    s_Directory = directory;
+    s_CacheSize.reset();
+}
+
+void DerivedDataCache::SetMaxSize(uint64_t maxSizeInBytes)
+{
+    std::lock_guard lock{s_CacheMutex};
+    s_MaxSize = maxSizeInBytes;
+}
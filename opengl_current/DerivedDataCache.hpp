@@ -0,0 +1,43 @@
+#pragma once
+
+#include "MappedFile.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string_view>
+
+// Identifies derived data by hash of source bytes, type of data, version of code producing it and import flags
+struct DerivedDataKey
+{
+    uint64_t Hash{0};
+};
+
+// Local cache of data derived from source assets, like cooked meshes, compressed textures or shader binaries.
+// Entries are keyed by content of sources, so touching or moving a source doesn't invalidate them and cache works
+// without network. Each entry stores checksum of its payload, corrupted entries are treated as missing. When total
+// size of cache exceeds limit, least recently used entries are removed. Can be used from loading threads
+class DerivedDataCache
+{
+public:
+    static DerivedDataKey MakeKey(std::string_view dataType, uint64_t version, uint64_t flags, std::span<const std::byte> sourceData);
+
+    // Returns nullopt when source file can't be read
+    static std::optional<DerivedDataKey> MakeKeyFromFile(std::string_view dataType, uint64_t version, uint64_t flags,
+        const std::filesystem::path& sourcePath);
+
+    // Maps cached entry, returned file is closed when entry is missing or corrupted
+    static MappedFile Load(const DerivedDataKey& key);
+
+    // Returns data stored in entry returned by Load
+    static std::span<const std::byte> GetPayload(const MappedFile& entry);
+
+    static void Store(const DerivedDataKey& key, std::span<const std::byte> payload);
+
+    static void SetDirectory(const std::filesystem::path& directory);
+    static void SetMaxSize(uint64_t maxSizeInBytes);
+
+    static uint64_t HashBytes(std::span<const std::byte> data, uint64_t seed = 0);
+};
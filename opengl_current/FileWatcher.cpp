@@ -0,0 +1,159 @@
+#include "FileWatcher.hpp"
+#include "Logging.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <system_error>
+
+#if defined(__linux__)
+#include <sys/inotify.h>
+#include <unistd.h>
+
+// editors either write file in place or write temporary file and rename it over the original
+static constexpr uint32_t FileChangeEvents = IN_CLOSE_WRITE | IN_MOVED_TO;
+static constexpr uint32_t DirectoryCreatedEvents = IN_CREATE | IN_ISDIR;
+
+FileWatcher::FileWatcher(const std::filesystem::path& directory) :
+    m_Directory{directory}
+{
+    m_NotifyHandle = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+    if (m_NotifyHandle < 0)
+    {
+        ENG_LOG_WARNING("Failed to watch {}: {}", directory.string(), std::strerror(errno));
+        return;
+    }
+
+    // inotify isn't recursive, so each subdirectory gets own watch
+    AddWatch(directory);
+    std::error_code errorCode;
+
+    for (const std::filesystem::directory_entry& entry : std::filesystem::recursive_directory_iterator{directory, errorCode})
+    {
+        if (entry.is_directory(errorCode))
+        {
+            AddWatch(entry.path());
+        }
+    }
+}
+
+FileWatcher::~FileWatcher()
+{
+    if (m_NotifyHandle >= 0)
+    {
+        close(m_NotifyHandle);
+    }
+}
+
+std::vector<std::filesystem::path> FileWatcher::GetChangedFiles()
+{
+    std::vector<std::filesystem::path> changedFiles;
+
+    if (m_NotifyHandle < 0)
+    {
+        return changedFiles;
+    }
+
+    alignas(inotify_event) std::array<char, 4096> buffer;
+    ssize_t numBytesRead;
+
+    while ((numBytesRead = read(m_NotifyHandle, buffer.data(), buffer.size())) > 0)
+    {
+        for (ssize_t offset = 0; offset < numBytesRead;)
+        {
+            const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer.data() + offset);
+            offset += sizeof(inotify_event) + event->len;
+
+            auto it = m_WatchedDirectories.find(event->wd);
+
+            if (it == m_WatchedDirectories.end() || event->len == 0)
+            {
+                continue;
+            }
+
+            std::filesystem::path path = it->second / event->name;
+
+            if ((event->mask & DirectoryCreatedEvents) == DirectoryCreatedEvents)
+            {
+                AddWatch(path);
+            }
+            else if (event->mask & FileChangeEvents)
+            {
+                changedFiles.emplace_back(std::move(path));
+            }
+        }
+    }
+
+    // single save can produce several events for the same file
+    std::sort(changedFiles.begin(), changedFiles.end());
+    changedFiles.erase(std::unique(changedFiles.begin(), changedFiles.end()), changedFiles.end());
+
+    return changedFiles;
+}
+
+void FileWatcher::AddWatch(const std::filesystem::path& directory)
+{
+    int watch = inotify_add_watch(m_NotifyHandle, directory.c_str(), FileChangeEvents | IN_CREATE | IN_ONLYDIR);
+
+    if (watch < 0)
+    {
+        ENG_LOG_WARNING("Failed to watch {}: {}", directory.string(), std::strerror(errno));
+        return;
+    }
+
+    m_WatchedDirectories[watch] = directory;
+}
+
+#else
+
+FileWatcher::FileWatcher(const std::filesystem::path& directory) :
+    m_Directory{directory},
+    m_LastPollTime{std::chrono::steady_clock::now()}
+{
+    ScanDirectory(nullptr);
+}
+
+FileWatcher::~FileWatcher() = default;
+
+std::vector<std::filesystem::path> FileWatcher::GetChangedFiles()
+{
+    std::vector<std::filesystem::path> changedFiles;
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+    if (now - m_LastPollTime >= s_PollInterval)
+    {
+        m_LastPollTime = now;
+        ScanDirectory(&changedFiles);
+    }
+
+    return changedFiles;
+}
+
+void FileWatcher::ScanDirectory(std::vector<std::filesystem::path>* outChangedFiles)
+{
+    std::error_code errorCode;
+
+    for (const std::filesystem::directory_entry& entry : std::filesystem::recursive_directory_iterator{m_Directory, errorCode})
+    {
+        if (!entry.is_regular_file(errorCode))
+        {
+            continue;
+        }
+
+        std::filesystem::file_time_type writeTime = entry.last_write_time(errorCode);
+        auto [it, bInserted] = m_WriteTimes.try_emplace(entry.path().string(), writeTime);
+
+        if (!bInserted && it->second != writeTime)
+        {
+            it->second = writeTime;
+
+            if (outChangedFiles != nullptr)
+            {
+                outChangedFiles->emplace_back(entry.path());
+            }
+        }
+    }
+}
+
+#endif
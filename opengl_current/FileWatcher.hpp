@@ -0,0 +1,39 @@
+#pragma once
+
+#include "Duration.hpp"
+
+#include <filesystem>
+#include <unordered_map>
+#include <vector>
+
+// Reports files modified in directory and its subdirectories. On Linux changes come from inotify, so checking
+// them costs single read. Other platforms compare write times, so directory is rescanned at most once per interval
+class FileWatcher
+{
+public:
+    FileWatcher(const std::filesystem::path& directory);
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    // Returns each file written since last call once, paths start with watched directory. Doesn't block
+    std::vector<std::filesystem::path> GetChangedFiles();
+
+    static inline milliseconds_float_t s_PollInterval{1000.0f};
+
+private:
+    std::filesystem::path m_Directory;
+
+#if defined(__linux__)
+    int m_NotifyHandle{-1};
+    std::unordered_map<int, std::filesystem::path> m_WatchedDirectories;
+
+    void AddWatch(const std::filesystem::path& directory);
+#else
+    std::unordered_map<std::string, std::filesystem::file_time_type> m_WriteTimes;
+    std::chrono::steady_clock::time_point m_LastPollTime;
+
+    void ScanDirectory(std::vector<std::filesystem::path>* outChangedFiles);
+#endif
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "Box.hpp"
+
+#include <glm/glm.hpp>
+
+// View frustum planes extracted from projection view matrix. Planes normals point inside frustum
+struct Frustum
+{
+    glm::vec4 Planes[6];
+
+    static Frustum FromProjectionView(const glm::mat4& projectionView);
+
+    // Conservative test, box that is near the frustum corner might be reported as visible
+    bool IsBoxVisible(const Box& box) const;
+};
+
+FORCE_INLINE Frustum Frustum::FromProjectionView(const glm::mat4& projectionView)
+{
+    // glm is column major, so gather rows of matrix first
+    glm::vec4 rows[4];
+
+    for (int i = 0; i < 4; ++i)
+    {
+        rows[i] = glm::vec4{projectionView[0][i], projectionView[1][i], projectionView[2][i], projectionView[3][i]};
+    }
+
+    Frustum frustum;
+    frustum.Planes[0] = rows[3] + rows[0]; // left
+    frustum.Planes[1] = rows[3] - rows[0]; // right
+    frustum.Planes[2] = rows[3] + rows[1]; // bottom
+    frustum.Planes[3] = rows[3] - rows[1]; // top
+    frustum.Planes[4] = rows[3] + rows[2]; // near
+    frustum.Planes[5] = rows[3] - rows[2]; // far
+
+    return frustum;
+}
+
+FORCE_INLINE bool Frustum::IsBoxVisible(const Box& box) const
+{
+    for (const glm::vec4& plane : Planes)
+    {
+        // take corner of box that is furthest along plane normal
+        glm::vec3 corner{
+            plane.x >= 0.0f ? box.MaxBounds.x : box.MinBounds.x,
+            plane.y >= 0.0f ? box.MaxBounds.y : box.MinBounds.y,
+            plane.z >= 0.0f ? box.MaxBounds.z : box.MinBounds.z
+        };
+
+        if (glm::dot(glm::vec3{plane}, corner) + plane.w < 0.0f)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
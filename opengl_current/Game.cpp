@@ -18,6 +18,10 @@ using ChronoDeltaTimeClock = std::chrono::steady_clock;
 constexpr ChronoDeltaTimeClock::duration MaxMillisecondsDeltaTime = std::chrono::duration_cast<ChronoDeltaTimeClock::duration>(milliseconds_float_t(1000.0f));
 constexpr ChronoDeltaTimeClock::duration MinMillisecondsDeltaTime = std::chrono::duration_cast<ChronoDeltaTimeClock::duration>(milliseconds_float_t(16.66667));
 
+// budget for creating GPU objects of assets loaded in background, so streaming doesn't cause hitches
+constexpr size_t MaxUploadBytesPerFrame = 16 * 1024 * 1024;
+constexpr milliseconds_float_t MaxUploadTimePerFrame{2.0f};
+
 
 struct GlfwLib
 {
@@ -62,7 +66,7 @@ Game::Game(const WindowSettings& settings) :
     m_LevelContext.CreateNewEmpty();
 
     Debug::InitializeDebugDraw(ResourceManager::GetShader("assets/shaders/unshaded.shd"));
-    Renderer2D::SetDrawShader(ResourceManager::GetShader("assets/shaders/sprite_2d.shd"));
+    Renderer2D::SetDrawShader(ResourceManager::GetShader("assets/shaders/sprite_2d_instanced.shd"), SpriteBatchMode::Instanced);
     ImGuizmo::SetOrthographic(false);
 }
 
@@ -115,11 +119,15 @@ void Game::Run()
         }
         
 
+        ResourceManager::ReloadChangedAssets();
+        ResourceManager::ProcessUploads(MaxUploadBytesPerFrame, MaxUploadTimePerFrame);
+        ResourceManager::UpdateResidency();
+
         RenderCommand::Clear();
         std::shared_ptr<Level> level = m_LevelContext.CurrentLevel;
         Renderer::BeginScene(level->CameraPosition, level->CameraRotation, level->GetLightsData());
         Level::BeginScene(Renderer::GetProjectionMatrix(), Renderer::GetViewMatrix(), Renderer::GetViewport());
-        Debug::BeginScene(Renderer::GetProjectionViewMatrix());
+        Debug::BeginScene(Renderer::GetProjectionViewMatrix(), Renderer::GetViewport());
 
         m_LevelContext.CurrentLevel->BroadcastRender();
 
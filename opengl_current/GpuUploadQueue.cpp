@@ -0,0 +1,84 @@
+#include "GpuUploadQueue.hpp"
+
+#include <algorithm>
+
+GpuUploadId GpuUploadQueue::Enqueue(std::function<void()> upload, size_t numBytes)
+{
+    std::lock_guard lock{m_UploadsMutex};
+    GpuUploadId id = m_NextUploadId++;
+    m_Uploads.emplace_back(PendingUpload{std::move(upload), numBytes, id});
+    return id;
+}
+
+size_t GpuUploadQueue::Process(size_t maxBytes, milliseconds_float_t maxTime)
+{
+    using Clock = std::chrono::steady_clock;
+
+    Clock::time_point startTime = Clock::now();
+    size_t numBytesUploaded = 0;
+    size_t numUploads = 0;
+
+    while (true)
+    {
+        PendingUpload upload;
+
+        {
+            std::lock_guard lock{m_UploadsMutex};
+
+            if (m_Uploads.empty())
+            {
+                return numUploads;
+            }
+
+            // budget is checked before upload, so the first one always runs
+            if (numBytesUploaded > 0 && numBytesUploaded + m_Uploads.front().NumBytes > maxBytes)
+            {
+                return numUploads;
+            }
+
+            upload = std::move(m_Uploads.front());
+            m_Uploads.pop_front();
+        }
+
+        // upload may queue another upload, so it runs without lock
+        upload.Upload();
+        ++numUploads;
+        numBytesUploaded += std::max<size_t>(upload.NumBytes, 1);
+
+        if (Clock::now() - startTime >= maxTime)
+        {
+            return numUploads;
+        }
+    }
+}
+
+bool GpuUploadQueue::ProcessUpload(GpuUploadId id)
+{
+    PendingUpload upload;
+
+    {
+        std::lock_guard lock{m_UploadsMutex};
+
+        auto it = std::find_if(m_Uploads.begin(), m_Uploads.end(), [id](const PendingUpload& pendingUpload)
+        {
+            return pendingUpload.Id == id;
+        });
+
+        if (it == m_Uploads.end())
+        {
+            return false;
+        }
+
+        upload = std::move(*it);
+        m_Uploads.erase(it);
+    }
+
+    upload.Upload();
+    return true;
+}
+
+size_t GpuUploadQueue::GetNumPendingUploads() const
+{
+    std::lock_guard lock{m_UploadsMutex};
+    return m_Uploads.size();
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "Duration.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+// Meshes loaded with Deferred mode only read files and decode data. GPU objects are created
+// later by FinishLoading, because OpenGL context is current only on main thread
+enum class GpuUploadMode
+{
+    Immediate,
+    Deferred
+};
+
+// Queue of GPU object creations for assets prepared on loading threads. Uploads can be queued from any thread,
+// but they are run on main thread with limited budget per frame, so streaming assets in doesn't cause hitches
+using GpuUploadId = uint64_t;
+
+class GpuUploadQueue
+{
+public:
+    // Returns id, that can be used to run this upload ahead of others
+    GpuUploadId Enqueue(std::function<void()> upload, size_t numBytes);
+
+    // Runs queued uploads until maxBytes are uploaded or maxTime passes. At least one upload is run,
+    // so upload bigger than budget isn't starved. Must be called on main thread. Returns number of uploads run
+    size_t Process(size_t maxBytes, milliseconds_float_t maxTime);
+
+    // Runs only given upload, when it is still queued. Must be called on main thread. Returns false when upload isn't queued
+    bool ProcessUpload(GpuUploadId id);
+
+    size_t GetNumPendingUploads() const;
+
+private:
+    struct PendingUpload
+    {
+        std::function<void()> Upload;
+        size_t NumBytes{0};
+        GpuUploadId Id{0};
+    };
+
+    std::deque<PendingUpload> m_Uploads;
+    GpuUploadId m_NextUploadId{1};
+    mutable std::mutex m_UploadsMutex;
+};
@@ -1,19 +1,40 @@
 #include "ImageRgba.hpp"
 #include <algorithm>
 #include <cstring>
+#include <utility>
+
+static void DeletePixelsArray(void* pixels)
+{
+    delete[] static_cast<uint8_t*>(pixels);
+}
 
 ImageRgba::ImageRgba(const uint8_t* image, int width, int height) :
-    m_ImageData{},
+    m_ImageData{new uint8_t[4 * static_cast<size_t>(width) * height], PixelsDeleter{&DeletePixelsArray}},
+    m_Width{width},
+    m_Height{height}
+{
+    std::memcpy(m_ImageData.get(), image, GetSizeInBytes());
+}
+
+ImageRgba::ImageRgba(int width, int height) :
+    m_ImageData{new uint8_t[4 * static_cast<size_t>(width) * height], PixelsDeleter{&DeletePixelsArray}},
     m_Width{width},
     m_Height{height}
 {
-    int length = 4 * width * height;
-    m_ImageData.insert(m_ImageData.begin(), image, image + length);
 }
 
-ImageRgba::ImageRgba(ImageRgba&& image) noexcept
+ImageRgba::ImageRgba(uint8_t* image, int width, int height, FreeFunction freeFunction) :
+    m_ImageData{image, PixelsDeleter{freeFunction}},
+    m_Width{width},
+    m_Height{height}
+{
+}
+
+ImageRgba::ImageRgba(ImageRgba&& image) noexcept :
+    m_ImageData{std::move(image.m_ImageData)},
+    m_Width{std::exchange(image.m_Width, 0)},
+    m_Height{std::exchange(image.m_Height, 0)}
 {
-    *this = std::move(image);
 }
 
 ImageRgba& ImageRgba::operator=(ImageRgba&& image) noexcept
@@ -27,7 +48,12 @@ ImageRgba& ImageRgba::operator=(ImageRgba&& image) noexcept
 
 const uint8_t* ImageRgba::GetRawImageData() const
 {
-    return m_ImageData.data();
+    return m_ImageData.get();
+}
+
+uint8_t* ImageRgba::GetRawImageData()
+{
+    return m_ImageData.get();
 }
 
 int ImageRgba::GetWidth() const
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <vector>
@@ -7,18 +8,44 @@
 class ImageRgba
 {
 public:
+    // Releases pixels allocated by image decoder
+    using FreeFunction = void (*)(void*);
+
+    // Copies pixels
     ImageRgba(const uint8_t* image, int width, int height);
 
+    // Allocates pixels that are filled by caller
+    ImageRgba(int width, int height);
+
+    // Takes ownership of pixels allocated by decoder, so decoded image isn't copied again
+    ImageRgba(uint8_t* image, int width, int height, FreeFunction freeFunction);
+
     ImageRgba(ImageRgba&& image) noexcept;
     ImageRgba& operator=(ImageRgba&& image) noexcept;
 
     const uint8_t* GetRawImageData() const;
+    uint8_t* GetRawImageData();
 
     int GetWidth() const;
     int GetHeight() const;
 
+    size_t GetSizeInBytes() const
+    {
+        return 4 * static_cast<size_t>(m_Width) * m_Height;
+    }
+
 private:
-    std::vector<uint8_t> m_ImageData;
+    struct PixelsDeleter
+    {
+        FreeFunction Free{nullptr};
+
+        void operator()(uint8_t* pixels) const
+        {
+            Free(pixels);
+        }
+    };
+
+    std::unique_ptr<uint8_t, PixelsDeleter> m_ImageData;
     int m_Width;
     int m_Height;
 };
@@ -5,7 +5,7 @@
 #include "ErrorMacros.hpp"
 #include "RenderCommand.hpp"
 
-IndexBuffer::IndexBuffer(std::span<uint32_t> data, bool bDynamic) :
+IndexBuffer::IndexBuffer(std::span<const uint32_t> data, bool bDynamic) :
     m_NumIndices{static_cast<int>(data.size())}
 {
     GenerateRendererId(data.data(), bDynamic);
@@ -10,7 +10,7 @@
 class IndexBuffer
 {
 public:
-    IndexBuffer(std::span<uint32_t> data, bool bDynamic = false);
+    IndexBuffer(std::span<const uint32_t> data, bool bDynamic = false);
     IndexBuffer(int maxNumIndices);
     ~IndexBuffer();
 
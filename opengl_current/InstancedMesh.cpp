@@ -22,7 +22,7 @@ void InstancedMesh::Draw(const glm::mat4& transform)
     }
 }
 
-int InstancedMesh::AddInstance(const Transform& transform, int textureId)
+int InstancedMesh::AddInstance(const Transform& transform, int textureLayer)
 {
     auto it = m_TransformBuffers.begin();
     int id = m_NumInstances;
@@ -54,11 +54,12 @@ int InstancedMesh::AddInstance(const Transform& transform, int textureId)
     if (bShouldRecycleTransform)
     {
         it->UpdateTransform(transform.CalculateTransformMatrix(), id);
+        it->UpdateTextureLayer(textureLayer, id);
         return id;
     }
     else
     {
-        it->AddTransform(transform.CalculateTransformMatrix());
+        it->AddTransform(transform.CalculateTransformMatrix(), textureLayer);
     }
 
     return m_NumInstances++;
@@ -4,6 +4,8 @@
 #include "UniformBuffer.hpp"
 #include "Transform.hpp"
 
+#include <cstddef>
+
 #include <glm/gtc/quaternion.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
@@ -14,6 +16,9 @@ constexpr int NumInstancesTransform = 800;
 struct InstancingTransforms
 {
     glm::mat4 Transforms[NumInstancesTransform];
+
+    // layer of texture array sampled by each instance, std140 pads int array elements to 16 bytes, so 4 layers share ivec4
+    glm::ivec4 TextureLayers[NumInstancesTransform / 4];
 };
 
 // Buffer for storing transform inside uniform buffer so it's faster to access
@@ -27,9 +32,10 @@ struct InstancingTransformBuffer
     {
     }
 
-    void AddTransform(const glm::mat4& transform)
+    void AddTransform(const glm::mat4& transform, int textureLayer)
     {
         Buffer->UpdateElement(transform, NumTransformsOccupied);
+        UpdateTextureLayer(textureLayer, NumTransformsOccupied);
         NumTransformsOccupied++;
     }
 
@@ -43,6 +49,11 @@ struct InstancingTransformBuffer
     {
         Buffer->UpdateElement(transform, relativeIndex);
     }
+
+    void UpdateTextureLayer(int textureLayer, int relativeIndex) const
+    {
+        Buffer->UpdateBuffer(&textureLayer, sizeof(textureLayer), static_cast<int>(offsetof(InstancingTransforms, TextureLayers) + relativeIndex * sizeof(int)));
+    }
 };
 
 class InstancedMesh
@@ -52,8 +63,9 @@ public:
 
     void Draw(const glm::mat4& transform);
 
-    // Adds new mesh instance. Returns index of newly created instance
-    int AddInstance(const Transform& transform, int textureId);
+    // Adds new mesh instance. Returns index of newly created instance. Texture layer selects layer of texture array
+    // in shaders with TEXTURE_ARRAY keyword, so instances with different textures are drawn in one call
+    int AddInstance(const Transform& transform, int textureLayer);
 
     const StaticMesh& GetMesh() const
     {
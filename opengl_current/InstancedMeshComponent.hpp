@@ -15,10 +15,10 @@ struct InstancedMeshComponent
     {
     }
 
-    void AddInstance(const Transform& transform)
+    void AddInstance(const Transform& transform, int textureLayer = 0)
     {
         Transforms.push_back(transform);
-        TargetInstancedMesh->AddInstance(transform, 0);
+        TargetInstancedMesh->AddInstance(transform, textureLayer);
     }
 
     void RemoveInstance(int index)
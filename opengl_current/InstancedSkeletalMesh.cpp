@@ -0,0 +1,49 @@
+#include "InstancedSkeletalMesh.hpp"
+#include "Renderer.hpp"
+
+// initial capacity of buffers, grows when crowd gets larger
+constexpr int InitialNumInstances = 64;
+
+InstancedSkeletalMesh::InstancedSkeletalMesh(std::shared_ptr<SkeletalMesh> skeletalMesh, std::shared_ptr<Material> material) :
+    m_SkeletalMesh{skeletalMesh},
+    m_Material{material},
+    m_BonePaletteBuffer{static_cast<int>(InitialNumInstances * skeletalMesh->GetNumBones() * sizeof(glm::mat4))},
+    m_InstancesBuffer{static_cast<int>(InitialNumInstances * sizeof(SkeletalMeshInstanceData))}
+{
+}
+
+void InstancedSkeletalMesh::Draw(const glm::mat4& transform)
+{
+    if (m_Instances.empty())
+    {
+        return;
+    }
+
+    int paletteSize = GetTotalSizeOf(m_BonePalette);
+    int instancesSize = GetTotalSizeOf(m_Instances);
+
+    m_BonePaletteBuffer.Reserve(paletteSize);
+    m_InstancesBuffer.Reserve(instancesSize);
+
+    m_BonePaletteBuffer.UpdateBuffer(m_BonePalette.data(), paletteSize);
+    m_InstancesBuffer.UpdateBuffer(m_Instances.data(), instancesSize);
+
+    Renderer::SubmitSkeletonInstanced(*m_SkeletalMesh, *m_Material, m_BonePaletteBuffer, m_InstancesBuffer, GetSize(), transform, m_Lod);
+}
+
+int InstancedSkeletalMesh::AddInstance(const glm::mat4& transform, std::span<const glm::mat4> boneTransforms)
+{
+    SkeletalMeshInstanceData& instance = m_Instances.emplace_back();
+    instance.Transform = transform;
+    instance.PaletteOffset = glm::ivec4{GetContainerSizeInt(m_BonePalette), 0, 0, 0};
+
+    m_BonePalette.insert(m_BonePalette.end(), boneTransforms.begin(), boneTransforms.end());
+
+    return GetSize() - 1;
+}
+
+void InstancedSkeletalMesh::Clear()
+{
+    m_BonePalette.clear();
+    m_Instances.clear();
+}
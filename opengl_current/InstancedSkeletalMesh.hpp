@@ -0,0 +1,62 @@
+#pragma once
+
+#include "SkeletalMesh.hpp"
+#include "ShaderStorageBuffer.hpp"
+
+#include <span>
+
+// Per instance record as it's laid out in std430 SkeletalInstances block
+struct SkeletalMeshInstanceData
+{
+    glm::mat4 Transform;
+
+    // x holds index of first bone of this instance inside bone palette, rest is padding
+    glm::ivec4 PaletteOffset;
+};
+
+// Batches all instances of single skeletal mesh, so whole crowd is drawn with one drawcall.
+// Bone transforms of each instance are appended to shared bone palette and instance refers to it by palette offset
+class InstancedSkeletalMesh
+{
+public:
+    InstancedSkeletalMesh(std::shared_ptr<SkeletalMesh> skeletalMesh, std::shared_ptr<Material> material);
+
+    void Draw(const glm::mat4& transform);
+
+    // Adds new instance for current frame. Returns index of newly created instance
+    int AddInstance(const glm::mat4& transform, std::span<const glm::mat4> boneTransforms);
+
+    void Clear();
+
+    int GetSize() const
+    {
+        return static_cast<int>(m_Instances.size());
+    }
+
+    const SkeletalMesh& GetMesh() const
+    {
+        return *m_SkeletalMesh;
+    }
+
+    // All instances are drawn using the same lod of mesh
+    void SetLod(int lod)
+    {
+        m_Lod = lod;
+    }
+
+    std::shared_ptr<Material> GetMaterial()
+    {
+        return m_Material;
+    }
+
+private:
+    std::shared_ptr<SkeletalMesh> m_SkeletalMesh;
+    std::shared_ptr<Material> m_Material;
+
+    std::vector<glm::mat4> m_BonePalette;
+    std::vector<SkeletalMeshInstanceData> m_Instances;
+
+    ShaderStorageBuffer m_BonePaletteBuffer;
+    ShaderStorageBuffer m_InstancesBuffer;
+    int m_Lod{0};
+};
@@ -5,6 +5,7 @@
 #include "ResourceManager.hpp"
 #include "PlayerController.hpp"
 #include "LightComponent.hpp"
+#include "Renderer.hpp"
 
 #include <future>
 
@@ -92,9 +93,13 @@ void Level::StartupLevel()
 void Level::BroadcastUpdate(Duration duration)
 {
     // start all update tasks that are independent from themselfs
-    auto skeletalAnimationUpdateTask = std::async(std::launch::async, [this](Duration duration)
+    // camera is moved on this thread meanwhile, so animation lods use it's position from last frame
+    glm::vec3 cameraPosition = CameraPosition;
+    Frustum cameraFrustum = Frustum::FromProjectionView(Renderer::GetProjectionViewMatrix());
+
+    auto skeletalAnimationUpdateTask = std::async(std::launch::async, [this, cameraPosition, cameraFrustum](Duration duration)
     {
-        UpdateSkeletalMeshesAnimation(duration);
+        UpdateSkeletalMeshesAnimation(duration, cameraPosition, cameraFrustum);
     }, duration);
 
     auto playerControllerView = m_Registry.view<PlayerController>();
@@ -178,10 +183,35 @@ void Level::BroadcastRender()
         mesh->Clear();
     }
 
+    Frustum cameraFrustum = Frustum::FromProjectionView(Renderer::GetProjectionViewMatrix());
     auto skeletalMeshView = m_Registry.view<TransformComponent, SkeletalMeshComponent>();
+
     for (auto&& [entity, transform, skeletalMesh] : skeletalMeshView.each())
     {
-        skeletalMesh.Draw(transform.GetWorldTransformMatrix());
+        glm::mat4 worldTransform = transform.GetWorldTransformMatrix();
+
+        if (!cameraFrustum.IsBoxVisible(skeletalMesh.GetAnimationBounds().TransformedBy(worldTransform)))
+        {
+            continue;
+        }
+
+        if (skeletalMesh.bPoseOutdated)
+        {
+            // mesh was offscreen during last update, but camera moved since then
+            float distance = glm::distance(CameraPosition, transform.Position);
+            skeletalMesh.UpdateAnimation(0.0f, m_AnimationPoseCache, m_AnimationPoseCache.GetLodForDistance(distance));
+        }
+
+        if (!AddNewSkeletalMesh(skeletalMesh, worldTransform))
+        {
+            skeletalMesh.Draw(worldTransform);
+        }
+    }
+
+    for (auto& [key, instancedMesh] : m_SkeletalMeshToInstancedMesh)
+    {
+        instancedMesh->Draw(glm::mat4{1.0f});
+        instancedMesh->Clear();
     }
 
     auto instancedMeshComponentView = m_Registry.view<TransformComponent, InstancedMeshComponent>();
@@ -204,7 +234,9 @@ void Level::AddNewStaticMesh(const std::string& meshName, const Transform& trans
 {
     float distance = glm::distance(CameraPosition, transform.Position);
     int lod = 0;
-    std::shared_ptr<StaticMesh> mesh = ResourceManager::GetStaticMesh(meshName);
+
+    // mesh is streamed in background, placeholder is drawn until it's ready
+    std::shared_ptr<StaticMesh> mesh = ResourceManager::GetStaticMeshAsync(meshName).Get();
 
     int numLods = mesh->GetNumLods();
 
@@ -217,12 +249,15 @@ void Level::AddNewStaticMesh(const std::string& meshName, const Transform& trans
         lod = 2;
     }
 
-    MeshKey key{meshName, lod};
+    // placeholder has single lod
+    lod = std::min(lod, numLods - 1);
+
+    MeshKey key{mesh->GetPath(), lod};
     auto it = m_MeshNameToInstancedMesh.find(key);
 
     if (it == m_MeshNameToInstancedMesh.end())
     {
-        it = m_MeshNameToInstancedMesh.try_emplace(key, std::make_shared<InstancedMesh>(ResourceManager::GetStaticMesh(meshName),
+        it = m_MeshNameToInstancedMesh.try_emplace(key, std::make_shared<InstancedMesh>(mesh,
             ResourceManager::GetMaterial("instanced"))).first;
 
         it->second->SetLod(lod);
@@ -231,6 +266,27 @@ void Level::AddNewStaticMesh(const std::string& meshName, const Transform& trans
     it->second->AddInstance(transform, 0);
 }
 
+bool Level::AddNewSkeletalMesh(const SkeletalMeshComponent& skeletalMesh, const glm::mat4& transform)
+{
+    const std::shared_ptr<SkeletalMesh>& mesh = skeletalMesh.TargetSkeletalMesh;
+
+    if (!mesh->InstancedMaterial)
+    {
+        return false;
+    }
+
+    SkeletalMeshKey key{mesh, skeletalMesh.Lod};
+    auto it = m_SkeletalMeshToInstancedMesh.find(key);
+
+    if (it == m_SkeletalMeshToInstancedMesh.end())
+    {
+        it = m_SkeletalMeshToInstancedMesh.try_emplace(key, std::make_shared<InstancedSkeletalMesh>(mesh, mesh->InstancedMaterial)).first;
+        it->second->SetLod(key.Lod);
+    }
+
+    it->second->AddInstance(transform, skeletalMesh.GetBoneTransforms());
+    return true;
+}
 
 std::optional<Actor> Level::TryFindActor(const std::string& name)
 {
@@ -258,15 +314,26 @@ void Level::SaveLevel(std::string_view path)
     archive->Save(path);
 }
 
-void Level::UpdateSkeletalMeshesAnimation(Duration duration)
+void Level::UpdateSkeletalMeshesAnimation(Duration duration, glm::vec3 cameraPosition, const Frustum& cameraFrustum)
 {
     auto skeletalMeshView = m_Registry.view<SkeletalMeshComponent, TransformComponent>();
 
     float seconds = duration.GetSeconds();
+    m_AnimationPoseCache.BeginFrame();
 
     for (auto&& [entity, skeletalMesh, transform] : skeletalMeshView.each())
     {
-        skeletalMesh.UpdateAnimation(seconds, transform.GetAsTransform());
+        Box worldBounds = skeletalMesh.GetAnimationBounds().TransformedBy(transform.GetWorldTransformMatrix());
+
+        if (!cameraFrustum.IsBoxVisible(worldBounds))
+        {
+            // pose of offscreen mesh isn't needed, so only keep it's animation in sync
+            skeletalMesh.AdvanceAnimationTime(seconds);
+            continue;
+        }
+
+        float distance = glm::distance(cameraPosition, transform.Position);
+        skeletalMesh.UpdateAnimation(seconds, m_AnimationPoseCache, m_AnimationPoseCache.GetLodForDistance(distance));
     }
 }
 
@@ -6,6 +6,9 @@
 #include "StaticMeshEntity.hpp"
 
 #include "InstancedMesh.hpp"
+#include "InstancedSkeletalMesh.hpp"
+#include "AnimationPoseCache.hpp"
+#include "Frustum.hpp"
 #include "Lights.hpp"
 
 #include "Archive.hpp"
@@ -13,6 +16,7 @@
 #include <optional>
 
 class ResourceManagerImpl;
+struct SkeletalMeshComponent;
 
 class Level : public LevelInterface, public std::enable_shared_from_this<Level>
 {
@@ -69,6 +73,11 @@ public:
 
     void SaveLevel(std::string_view path);
 
+    AnimationPoseCache& GetAnimationPoseCache()
+    {
+        return m_AnimationPoseCache;
+    }
+
     template <typename T>
     std::shared_ptr<T> CreateEntity(std::string_view name)
     {
@@ -92,6 +101,7 @@ private:
     std::shared_ptr<ResourceManagerImpl> m_ResourceManager;
 
     std::unordered_map<MeshKey, std::shared_ptr<InstancedMesh>> m_MeshNameToInstancedMesh;
+    std::unordered_map<SkeletalMeshKey, std::shared_ptr<InstancedSkeletalMesh>> m_SkeletalMeshToInstancedMesh;
     std::vector<LightData> m_Lights;
 
     std::vector<std::shared_ptr<BaseEntity>> m_Entities;
@@ -99,8 +109,14 @@ private:
 
     std::vector<std::shared_ptr<StaticMeshEntity>> m_StaticMeshEntity;
 
+    // poses shared by skeletal meshes in the same animation state
+    AnimationPoseCache m_AnimationPoseCache;
+
 private:
-    void UpdateSkeletalMeshesAnimation(Duration duration);
+    void UpdateSkeletalMeshesAnimation(Duration duration, glm::vec3 cameraPosition, const Frustum& cameraFrustum);
+
+    // Adds skeletal mesh to instanced batch of it's mesh. Returns false if mesh doesn't support instancing
+    bool AddNewSkeletalMesh(const SkeletalMeshComponent& skeletalMesh, const glm::mat4& transform);
 
     Actor ConstructFromEntity(entt::entity entity) const
     {
@@ -0,0 +1,149 @@
+#include "MappedFile.hpp"
+#include "Logging.hpp"
+
+#include <utility>
+
+#if defined(_WIN32) || defined(WIN32)
+#define MAPPED_FILE_WINDOWS
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::filesystem::path& filePath)
+{
+#if defined(MAPPED_FILE_WINDOWS)
+    HANDLE file = CreateFileW(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return;
+    }
+
+    LARGE_INTEGER fileSize{};
+
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return;
+    }
+
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+    if (mapping == nullptr)
+    {
+        CloseHandle(file);
+        return;
+    }
+
+    m_FileHandle = file;
+    m_MappingHandle = mapping;
+    m_Data = static_cast<const std::byte*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    m_Size = m_Data != nullptr ? static_cast<size_t>(fileSize.QuadPart) : 0;
+#else
+    int file = open(filePath.c_str(), O_RDONLY);
+
+    if (file < 0)
+    {
+        return;
+    }
+
+    struct stat fileStat{};
+
+    if (fstat(file, &fileStat) != 0 || fileStat.st_size == 0)
+    {
+        close(file);
+        return;
+    }
+
+    void* data = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+
+    // mapping keeps file referenced, so descriptor isn't needed anymore
+    close(file);
+
+    if (data == MAP_FAILED)
+    {
+        return;
+    }
+
+    m_Data = static_cast<const std::byte*>(data);
+    m_Size = static_cast<size_t>(fileStat.st_size);
+#endif
+
+    if (m_Data == nullptr)
+    {
+        ENG_LOG_WARNING("Failed to map file {}", filePath.string());
+        Close();
+        return;
+    }
+
+    s_NumBytesMapped += m_Size;
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+    if (this != &other)
+    {
+        Close();
+
+        m_Data = std::exchange(other.m_Data, nullptr);
+        m_Size = std::exchange(other.m_Size, 0);
+#if defined(MAPPED_FILE_WINDOWS)
+        m_FileHandle = std::exchange(other.m_FileHandle, nullptr);
+        m_MappingHandle = std::exchange(other.m_MappingHandle, nullptr);
+#endif
+    }
+
+    return *this;
+}
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+void MappedFile::Close()
+{
+    if (m_Data != nullptr)
+    {
+        s_NumBytesMapped -= m_Size;
+    }
+
+#if defined(MAPPED_FILE_WINDOWS)
+    if (m_Data != nullptr)
+    {
+        UnmapViewOfFile(m_Data);
+    }
+
+    if (m_MappingHandle != nullptr)
+    {
+        CloseHandle(m_MappingHandle);
+    }
+
+    if (m_FileHandle != nullptr)
+    {
+        CloseHandle(m_FileHandle);
+    }
+
+    m_FileHandle = nullptr;
+    m_MappingHandle = nullptr;
+#else
+    if (m_Data != nullptr)
+    {
+        munmap(const_cast<std::byte*>(m_Data), m_Size);
+    }
+#endif
+
+    m_Data = nullptr;
+    m_Size = 0;
+}
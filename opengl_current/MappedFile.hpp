@@ -0,0 +1,53 @@
+#pragma once
+
+#include "Core.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <filesystem>
+#include <span>
+
+// Read-only memory mapping of whole file. Pages are loaded by OS on first access,
+// so data can be uploaded to GPU straight from mapping without copying it to heap first
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    MappedFile(const std::filesystem::path& filePath);
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool IsOpen() const
+    {
+        return m_Data != nullptr;
+    }
+
+    std::span<const std::byte> GetData() const
+    {
+        return std::span<const std::byte>{m_Data, m_Size};
+    }
+
+    size_t GetSize() const
+    {
+        return m_Size;
+    }
+
+    // files can be mapped from loading threads
+    static inline std::atomic<size_t> s_NumBytesMapped = 0;
+
+private:
+    const std::byte* m_Data{nullptr};
+    size_t m_Size{0};
+
+#if defined(_WIN32) || defined(WIN32)
+    void* m_FileHandle{nullptr};
+    void* m_MappingHandle{nullptr};
+#endif
+
+private:
+    void Close();
+};
@@ -6,6 +6,61 @@
 namespace
 {
     constexpr std::string_view MaterialTag = "u_Material.";
+
+    std::vector<UniformInfo> GetMaterialUniforms(const Shader& shader)
+    {
+        std::vector<UniformInfo> uniforms = shader.GetUniformsInfo();
+        std::erase_if(uniforms, [](const UniformInfo& info) { return !ContainsString(info.Name, MaterialTag); });
+        return uniforms;
+    }
+
+    // locations aren't compared, they're looked up by name on each draw
+    bool HaveSameLayout(std::span<const UniformInfo> uniforms, std::span<const UniformInfo> otherUniforms)
+    {
+        return std::equal(uniforms.begin(), uniforms.end(), otherUniforms.begin(), otherUniforms.end(),
+            [](const UniformInfo& a, const UniformInfo& b)
+            {
+                return a.Type == b.Type && a.Name == b.Name && a.ArraySize == b.ArraySize && a.BlockOffset == b.BlockOffset;
+            });
+    }
+}
+
+Material::Material(const Material& material) :
+    bCullFaces{material.bCullFaces},
+    m_Parent{material.m_Parent},
+    m_Shader{material.m_Shader},
+    m_MaterialParams{material.m_MaterialParams},
+    m_NumTextureUnits{material.m_NumTextureUnits},
+    m_UniformBlockSize{material.m_UniformBlockSize},
+    m_UniformBlockData{material.m_UniformBlockData},
+    m_bOverridesUniformBlock{material.m_bOverridesUniformBlock}
+{
+}
+
+Material& Material::operator=(const Material& material)
+{
+    bCullFaces = material.bCullFaces;
+    m_Parent = material.m_Parent;
+    m_Shader = material.m_Shader;
+    m_MaterialParams = material.m_MaterialParams;
+    m_NumTextureUnits = material.m_NumTextureUnits;
+    m_UniformBlockSize = material.m_UniformBlockSize;
+    m_UniformBlockData = material.m_UniformBlockData;
+    m_bOverridesUniformBlock = material.m_bOverridesUniformBlock;
+
+    // size of block may differ, so buffer is created again on next draw
+    m_UniformBlock.reset();
+    ++m_ParamsVersion;
+    return *this;
+}
+
+Material::Material(const std::shared_ptr<const Material>& parent) :
+    bCullFaces{parent->bCullFaces},
+    m_Parent{parent},
+    m_Shader{parent->m_Shader},
+    m_NumTextureUnits{parent->m_NumTextureUnits},
+    m_UniformBlockSize{parent->m_UniformBlockSize}
+{
 }
 
 Material::Material(std::shared_ptr<Shader> shader) :
@@ -18,6 +73,8 @@ Material::Material(std::shared_ptr<Shader> shader) :
     {
         TryAddNewProperty(info);
     }
+
+    AddUniformBlockProperties();
 }
 
 int Material::GetIntProperty(const char* name) const
@@ -80,8 +137,26 @@ void Material::SetTextureProperty(const char* name, std::shared_ptr<ITexture> va
     GetParam(name).SetTexture(value);
 }
 
+uint32_t Material::GetId() const
+{
+    if (m_Parent != nullptr && m_MaterialParams.empty() && bCullFaces == m_Parent->bCullFaces)
+    {
+        return m_Parent->GetId();
+    }
+
+    return m_Id;
+}
+
+void Material::SetTextureArrayProperty(const char* name, const std::shared_ptr<Texture2DArray>& value)
+{
+    GetParam(name).SetTexture(value);
+}
+
 void Material::VisitForEachParam(IMaterialParameterVisitor& visitor)
 {
+    // visitor can change values of parameters
+    ++m_ParamsVersion;
+
     for (auto& [name, param] : m_MaterialParams)
     {
         param.Accept(visitor, name);
@@ -138,20 +213,204 @@ void Material::AddNewProperty(const UniformInfo& info)
         m_MaterialParams.try_emplace(info.Name.substr(MaterialTag.length()), param);
         break;
     }
+    case UniformType::Sampler2DArray:
+    {
+        MaterialParam param{info.Name.c_str(), Renderer::GetDefaultTextureArray(), m_NumTextureUnits++};
+        m_MaterialParams.try_emplace(info.Name.substr(MaterialTag.length()), param);
+        break;
+    }
+    default:
+        // matrices and other types can't be set through material
+        break;
     }
 }
 
-void Material::SetupRenderState() const
+bool Material::HasSameParameterLayout(const Shader& shader, const Shader& otherShader)
 {
-    RenderCommand::SetCullFace(bCullFaces);
+    std::optional<UniformBlockInfo> blockInfo = shader.GetUniformBlockInfo(MaterialUniformBlock);
+    std::optional<UniformBlockInfo> otherBlockInfo = otherShader.GetUniformBlockInfo(MaterialUniformBlock);
+
+    if (blockInfo.has_value() != otherBlockInfo.has_value())
+    {
+        return false;
+    }
+
+    if (blockInfo && (blockInfo->NumBytes != otherBlockInfo->NumBytes || !HaveSameLayout(blockInfo->Members, otherBlockInfo->Members)))
+    {
+        return false;
+    }
+
+    return HaveSameLayout(GetMaterialUniforms(shader), GetMaterialUniforms(otherShader));
 }
 
-void Material::SetShaderUniforms() const
+void Material::AddUniformBlockProperties()
 {
-    std::shared_ptr<Shader> shader = GetShader();
+    std::optional<UniformBlockInfo> blockInfo = m_Shader->GetUniformBlockInfo(MaterialUniformBlock);
 
-    for (auto& [name, param] : m_MaterialParams)
+    if (!blockInfo)
+    {
+        return;
+    }
+
+    for (const UniformInfo& info : blockInfo->Members)
+    {
+        // members are named MaterialParameters.Name, so properties are looked up the same way as standalone uniforms
+        std::string name = info.Name.substr(info.Name.find('.') + 1);
+        const size_t numParams = m_MaterialParams.size();
+        AddNewProperty(UniformInfo{info.Type, std::string{MaterialTag} + name, -1, info.ArraySize, info.BlockOffset});
+
+        if (m_MaterialParams.size() != numParams)
+        {
+            m_MaterialParams.at(name).m_BlockOffset = info.BlockOffset;
+        }
+    }
+
+    m_UniformBlockSize = blockInfo->NumBytes;
+    m_UniformBlockData.resize(m_UniformBlockSize);
+}
+
+uint64_t Material::GetParamsVersion() const
+{
+    return m_ParamsVersion + (m_Parent != nullptr ? m_Parent->GetParamsVersion() : 0);
+}
+
+bool Material::OwnsUniformBlock() const
+{
+    return m_Parent == nullptr || m_bOverridesUniformBlock;
+}
+
+void Material::PackUniformBlock(std::span<std::byte> blockData) const
+{
+    // values of parent are written first, so overrides replace them
+    if (m_Parent != nullptr)
     {
-        param.SetUniform(*shader);
+        m_Parent->PackUniformBlock(blockData);
     }
-}
\ No newline at end of file
+
+    for (const auto& [name, param] : m_MaterialParams)
+    {
+        if (param.IsInUniformBlock())
+        {
+            param.CopyToUniformBlock(blockData);
+        }
+    }
+}
+
+void Material::BindUniformBlock() const
+{
+    if (m_UniformBlockSize == 0)
+    {
+        return;
+    }
+
+    if (!OwnsUniformBlock())
+    {
+        m_Parent->BindUniformBlock();
+        return;
+    }
+
+    const uint64_t paramsVersion = GetParamsVersion();
+
+    if (paramsVersion != m_UploadedParamsVersion)
+    {
+        PackUniformBlock(m_UniformBlockData);
+
+        if (m_UniformBlock == nullptr)
+        {
+            m_UniformBlock = std::make_unique<UniformBuffer>(m_UniformBlockSize);
+        }
+
+        m_UniformBlock->UpdateBuffer(m_UniformBlockData.data(), m_UniformBlockSize);
+        m_UploadedParamsVersion = paramsVersion;
+    }
+
+    m_UniformBlock->BindRange(MaterialUniformBlockBinding, 0, m_UniformBlockSize);
+}
+
+void Material::SetStandaloneUniforms(Shader& shader) const
+{
+    // overridden parameters are set after parent's, so they replace them
+    if (m_Parent != nullptr)
+    {
+        m_Parent->SetStandaloneUniforms(shader);
+    }
+
+    for (const auto& [name, param] : m_MaterialParams)
+    {
+        if (!param.IsInUniformBlock())
+        {
+            param.SetUniform(shader);
+        }
+    }
+}
+
+MaterialParam& Material::GetParam(const char* name)
+{
+    ++m_ParamsVersion;
+    auto it = m_MaterialParams.find(name);
+
+    if (it != m_MaterialParams.end() || m_Parent == nullptr)
+    {
+        return m_MaterialParams.at(name);
+    }
+
+    MaterialParam& param = m_MaterialParams.try_emplace(name, m_Parent->GetParam(name)).first->second;
+
+    if (param.IsInUniformBlock() && !m_bOverridesUniformBlock)
+    {
+        m_bOverridesUniformBlock = true;
+        m_UniformBlockData.resize(m_UniformBlockSize);
+    }
+
+    return param;
+}
+
+const MaterialParam& Material::GetParam(const char* name) const
+{
+    auto it = m_MaterialParams.find(name);
+
+    if (it != m_MaterialParams.end() || m_Parent == nullptr)
+    {
+        return m_MaterialParams.at(name);
+    }
+
+    return m_Parent->GetParam(name);
+}
+
+MaterialInstance::MaterialInstance(const std::shared_ptr<const Material>& parent) :
+    Material{parent}
+{
+}
+
+bool MaterialInstance::IsPropertyOverridden(const char* name) const
+{
+    return m_MaterialParams.contains(name);
+}
+
+void MaterialInstance::ResetProperty(const char* name)
+{
+    m_MaterialParams.erase(name);
+    ++m_ParamsVersion;
+
+    m_bOverridesUniformBlock = std::any_of(m_MaterialParams.begin(), m_MaterialParams.end(),
+        [](const auto& entry) { return entry.second.IsInUniformBlock(); });
+
+    if (!m_bOverridesUniformBlock)
+    {
+        // parent's block is bound again, so memory of own block is released
+        m_UniformBlock.reset();
+        m_UniformBlockData = {};
+        m_UploadedParamsVersion = ~0ull;
+    }
+}
+
+void Material::SetupRenderState() const
+{
+    RenderCommand::SetCullFace(bCullFaces);
+}
+
+void Material::SetShaderUniforms() const
+{
+    BindUniformBlock();
+    SetStandaloneUniforms(*m_Shader);
+}
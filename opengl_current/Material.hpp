@@ -1,14 +1,21 @@
 #pragma once
 
 #include "MaterialParameter.hpp"
+#include "UniformBuffer.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
 
 class Material
 {
 public:
     Material(std::shared_ptr<Shader> shader);
 
-    Material(const Material&) = default;
-    Material& operator=(const Material&) = default;
+    // Copy gets its own uniform block, so changing parameters of one material doesn't affect the other
+    Material(const Material& material);
+    Material& operator=(const Material& material);
 
 public:
     int GetIntProperty(const char* name) const;
@@ -29,6 +36,10 @@ public:
     std::shared_ptr<ITexture> GetTextureProperty(const char* name) const;
     void SetTextureProperty(const char* name, std::shared_ptr<ITexture> value);
 
+    // Sets sampler2DArray parameter. Layer isn't part of material, it's passed per instance (see InstancedMesh::AddInstance)
+    // or per vertex, so meshes using different layers of the same array share material and can be batched
+    void SetTextureArrayProperty(const char* name, const std::shared_ptr<Texture2DArray>& value);
+
     void SetupRenderState() const;
     void SetShaderUniforms() const;
 
@@ -42,30 +53,76 @@ public:
         return m_NumTextureUnits;
     }
 
-    
+    // Materials with the same id set the same state, so their draws can be batched. Instance without overrides
+    // returns id of its parent
+    uint32_t GetId() const;
+
+    // Material instance visits only parameters it overrides
     void VisitForEachParam(IMaterialParameterVisitor& visitor);
 
+    // Materials keep block offsets and texture units reflected from their shader, so program of shader can be
+    // replaced only by one with the same parameters
+    static bool HasSameParameterLayout(const Shader& shader, const Shader& otherShader);
+
 public:
 
     bool bCullFaces : 1{ true };
 
-private:
+protected:
+    explicit Material(const std::shared_ptr<const Material>& parent);
+
+    std::shared_ptr<const Material> m_Parent;
     std::shared_ptr<Shader> m_Shader;
+
+    // parameters of instance contain only overrides, others are read from parent
     std::unordered_map<std::string, MaterialParam> m_MaterialParams;
     uint32_t m_NumTextureUnits{0};
+    uint32_t m_Id{s_NextId++};
+
+    // Scalar and vector parameters packed in std140 layout. Buffer is uploaded only after some parameter changed.
+    // Instance packs its own block only after it overrides parameter stored in block, until then parent's is bound
+    int m_UniformBlockSize{0};
+    mutable std::vector<std::byte> m_UniformBlockData;
+    mutable std::unique_ptr<UniformBuffer> m_UniformBlock;
+    bool m_bOverridesUniformBlock{false};
+
+    // increased on every change of parameters, block is uploaded again when sum of versions up to root changes
+    uint64_t m_ParamsVersion{0};
+    mutable uint64_t m_UploadedParamsVersion{~0ull};
+
+    static inline std::atomic<uint32_t> s_NextId{1};
 
-private:
+protected:
     void TryAddNewProperty(const UniformInfo& info);
     void AddNewProperty(const UniformInfo& info);
+    void AddUniformBlockProperties();
 
-    MaterialParam& GetParam(const char* name)
-    {
-        return m_MaterialParams.at(name);
-    }
+    uint64_t GetParamsVersion() const;
+    bool OwnsUniformBlock() const;
+    void PackUniformBlock(std::span<std::byte> blockData) const;
+    void BindUniformBlock() const;
+    void SetStandaloneUniforms(Shader& shader) const;
 
-    const MaterialParam& GetParam(const char* name) const
+    // Parameter of instance is copied from parent on first write
+    MaterialParam& GetParam(const char* name);
+    const MaterialParam& GetParam(const char* name) const;
+};
+
+// Variant of material, which stores only parameters changed from parent. Shader, reflection data, textures and
+// uniform block of parent are shared until they are overridden, so variants like tinted props cost few bytes each
+class MaterialInstance : public Material
+{
+public:
+    explicit MaterialInstance(const std::shared_ptr<const Material>& parent);
+
+    const std::shared_ptr<const Material>& GetParent() const
     {
-        return m_MaterialParams.at(name);
+        return m_Parent;
     }
+
+    bool IsPropertyOverridden(const char* name) const;
+
+    // Drops override, so value of parent is used again
+    void ResetProperty(const char* name);
 };
 
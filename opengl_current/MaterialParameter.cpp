@@ -136,10 +136,25 @@ void MaterialParam::Accept(IMaterialParameterVisitor& visitor, const std::string
     paramater->Accept(visitor, name);
 }
 
+void MaterialParam::CopyToUniformBlock(std::span<std::byte> blockData) const
+{
+    ASSERT(IsInUniformBlock());
+
+    std::visit([this, blockData]<typename T>(const T& param)
+    {
+        if constexpr (!std::is_same_v<T, TextureParameter> && !std::is_same_v<T, UnknownParameter>)
+        {
+            auto value = param.GetPrimitiveValue();
+            ERR_FAIL_EXPECTED_TRUE(static_cast<size_t>(m_BlockOffset) + sizeof(value) <= blockData.size());
+            std::memcpy(blockData.data() + m_BlockOffset, &value, sizeof(value));
+        }
+    }, m_Parameter);
+}
+
 void TextureParameter::SetUniform(Shader& shader) const
 {
     m_Texture->Bind(m_TextureUnit);
-    shader.SetSamplerUniform(m_UniformName.c_str(), m_Texture, m_TextureUnit);
+    shader.SetSamplerUniform(m_Uniform, m_Texture, m_TextureUnit);
 }
 
 void UnknownParameter::SetUniform(Shader& shader) const
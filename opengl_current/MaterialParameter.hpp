@@ -9,6 +9,7 @@
 
 #include <cstring>
 #include <array>
+#include <span>
 
 #include <variant>
 #include <any>
@@ -95,7 +96,7 @@ class PrimitiveParameter : public Parameter
 {
 public:
     PrimitiveParameter(std::string uniformName, T value) :
-        m_UniformName{uniformName},
+        m_Uniform{UniformHandle::FromName(uniformName)},
         m_Value{value}
     {
     }
@@ -110,7 +111,7 @@ public:
 
     void SetUniform(Shader& shader) const override
     {
-        shader.SetUniform(m_UniformName.c_str(), m_Value);
+        shader.SetUniform(m_Uniform, m_Value);
     }
 
     std::any GetValue() const override
@@ -129,7 +130,7 @@ public:
     }
 
 private:
-    std::string m_UniformName;
+    UniformHandle m_Uniform;
     T m_Value;
 };
 
@@ -137,7 +138,7 @@ class TextureParameter : public Parameter
 {
 public:
     TextureParameter(std::string uniformName, std::shared_ptr<ITexture> value, uint32_t textureUnit) :
-        m_UniformName{uniformName},
+        m_Uniform{UniformHandle::FromName(uniformName)},
         m_Texture{value},
         m_TextureUnit{textureUnit}
     {
@@ -174,7 +175,7 @@ public:
 
 
 private:
-    std::string m_UniformName;
+    UniformHandle m_Uniform;
     std::shared_ptr<ITexture> m_Texture;
     uint32_t m_TextureUnit;
 };
@@ -228,8 +229,19 @@ public:
 
     void Accept(IMaterialParameterVisitor& visitor, const std::string& name);
 
+    bool IsInUniformBlock() const
+    {
+        return m_BlockOffset >= 0;
+    }
+
+    // Writes value at its offset in std140 block of material. Textures can't be stored in blocks, so they are skipped
+    void CopyToUniformBlock(std::span<std::byte> blockData) const;
+
 private:
     ParamVariant m_Parameter{UnknownParameter{}};
     Parameter* (*m_Getter)(const ParamVariant& value);
     MaterialParamType m_ParamType{MaterialParamType::Unknown};
+
+    // byte offset in uniform block of material, -1 when parameter is set as standalone uniform
+    int m_BlockOffset{-1};
 };
\ No newline at end of file
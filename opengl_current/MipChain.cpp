@@ -0,0 +1,173 @@
+#include "MipChain.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#if MIP_CHAIN_SSE
+#include <xmmintrin.h>
+#endif
+
+constexpr int LinearToSrgbTableSize = 16384;
+
+// Precise conversion uses pow, so it's evaluated once into tables
+struct SrgbTables
+{
+    std::array<float, 256> SrgbToLinear;
+    std::array<uint8_t, LinearToSrgbTableSize> LinearToSrgb;
+
+    SrgbTables()
+    {
+        for (int i = 0; i < 256; ++i)
+        {
+            float srgb = i / 255.0f;
+            SrgbToLinear[i] = srgb <= 0.04045f ? srgb / 12.92f : std::pow((srgb + 0.055f) / 1.055f, 2.4f);
+        }
+
+        for (int i = 0; i < LinearToSrgbTableSize; ++i)
+        {
+            float linear = i / static_cast<float>(LinearToSrgbTableSize - 1);
+            float srgb = linear <= 0.0031308f ? linear * 12.92f : 1.055f * std::pow(linear, 1.0f / 2.4f) - 0.055f;
+            LinearToSrgb[i] = static_cast<uint8_t>(std::clamp(srgb * 255.0f + 0.5f, 0.0f, 255.0f));
+        }
+    }
+};
+
+static const SrgbTables& GetSrgbTables()
+{
+    static const SrgbTables tables;
+    return tables;
+}
+
+// Image with RGBA channels stored as floats in range 0-1
+struct LinearImage
+{
+    int Width{0};
+    int Height{0};
+    std::vector<float> Pixels;
+
+    LinearImage(int width, int height) :
+        Width{width},
+        Height{height},
+        Pixels(4 * static_cast<size_t>(width) * height)
+    {
+    }
+};
+
+static LinearImage ConvertToLinearImage(const ImageRgba& image, bool bSrgb)
+{
+    const SrgbTables& tables = GetSrgbTables();
+    const uint8_t* pixels = image.GetRawImageData();
+
+    LinearImage linearImage{image.GetWidth(), image.GetHeight()};
+
+    for (size_t i = 0; i < image.GetSizeInBytes(); i += 4)
+    {
+        for (size_t channel = 0; channel < 3; ++channel)
+        {
+            linearImage.Pixels[i + channel] = bSrgb ? tables.SrgbToLinear[pixels[i + channel]] : pixels[i + channel] / 255.0f;
+        }
+
+        linearImage.Pixels[i + 3] = pixels[i + 3] / 255.0f;
+    }
+
+    return linearImage;
+}
+
+static ImageRgba ConvertToImage(const LinearImage& linearImage, bool bSrgb)
+{
+    const SrgbTables& tables = GetSrgbTables();
+
+    ImageRgba image{linearImage.Width, linearImage.Height};
+    uint8_t* pixels = image.GetRawImageData();
+
+    for (size_t i = 0; i < linearImage.Pixels.size(); ++i)
+    {
+        float value = std::clamp(linearImage.Pixels[i], 0.0f, 1.0f);
+        bool bAlpha = (i % 4) == 3;
+
+        if (bSrgb && !bAlpha)
+        {
+            pixels[i] = tables.LinearToSrgb[static_cast<size_t>(value * (LinearToSrgbTableSize - 1) + 0.5f)];
+        }
+        else
+        {
+            pixels[i] = static_cast<uint8_t>(value * 255.0f + 0.5f);
+        }
+    }
+
+    return image;
+}
+
+static LinearImage Downsample(const LinearImage& source)
+{
+    LinearImage destination{GetMipSize(source.Width, 1), GetMipSize(source.Height, 1)};
+
+#if MIP_CHAIN_SSE
+    const __m128 quarter = _mm_set1_ps(0.25f);
+#endif
+
+    for (int y = 0; y < destination.Height; ++y)
+    {
+        // odd row or column of source is repeated, so edge pixels don't get averaged with nothing
+        const float* row0 = &source.Pixels[static_cast<size_t>(2 * y) * source.Width * 4];
+        const float* row1 = &source.Pixels[static_cast<size_t>(std::min(2 * y + 1, source.Height - 1)) * source.Width * 4];
+        float* destinationRow = &destination.Pixels[static_cast<size_t>(y) * destination.Width * 4];
+
+        for (int x = 0; x < destination.Width; ++x)
+        {
+            int x0 = 2 * x * 4;
+            int x1 = std::min(2 * x + 1, source.Width - 1) * 4;
+
+#if MIP_CHAIN_SSE
+            // whole RGBA pixel fits single register
+            __m128 sum = _mm_add_ps(_mm_add_ps(_mm_loadu_ps(&row0[x0]), _mm_loadu_ps(&row0[x1])),
+                _mm_add_ps(_mm_loadu_ps(&row1[x0]), _mm_loadu_ps(&row1[x1])));
+            _mm_storeu_ps(&destinationRow[x * 4], _mm_mul_ps(sum, quarter));
+#else
+            for (int channel = 0; channel < 4; ++channel)
+            {
+                destinationRow[x * 4 + channel] = (row0[x0 + channel] + row0[x1 + channel] + row1[x0 + channel] + row1[x1 + channel]) * 0.25f;
+            }
+#endif
+        }
+    }
+
+    return destination;
+}
+
+int GetNumMipLevels(int width, int height)
+{
+    int size = std::max(width, height);
+    int numLevels = 1;
+
+    while (size > 1)
+    {
+        size >>= 1;
+        ++numLevels;
+    }
+
+    return numLevels;
+}
+
+std::vector<ImageRgba> GenerateMipChain(const ImageRgba& image, bool bSrgb)
+{
+    std::vector<ImageRgba> mips;
+    int numLevels = GetNumMipLevels(image.GetWidth(), image.GetHeight());
+
+    if (numLevels <= 1)
+    {
+        return mips;
+    }
+
+    mips.reserve(numLevels - 1);
+    LinearImage level = ConvertToLinearImage(image, bSrgb);
+
+    for (int i = 1; i < numLevels; ++i)
+    {
+        level = Downsample(level);
+        mips.emplace_back(ConvertToImage(level, bSrgb));
+    }
+
+    return mips;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "ImageRgba.hpp"
+
+#include <vector>
+
+// SSE2 is baseline on x64, so filter uses it unless compiled for architecture without it
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MIP_CHAIN_SSE 1
+#else
+#define MIP_CHAIN_SSE 0
+#endif
+
+// Number of levels of full mip chain, down to 1x1
+int GetNumMipLevels(int width, int height);
+
+inline int GetMipSize(int size, int level)
+{
+    return (size >> level) > 1 ? (size >> level) : 1;
+}
+
+// Generates levels 1 to last with 2x2 box filter, level 0 is passed image. Each level is filtered from
+// previous one kept in floats, so rounding errors don't accumulate. When bSrgb is set, color channels are
+// averaged in linear space, so mips don't get darker. Alpha is always filtered linearly
+std::vector<ImageRgba> GenerateMipChain(const ImageRgba& image, bool bSrgb);
@@ -0,0 +1,103 @@
+#include "PixelUnpackRing.hpp"
+
+#include <GL/glew.h>
+#include <cstring>
+
+PixelUnpackRing::PixelUnpackRing(int numBuffers, size_t bufferSize) :
+    m_Buffers(numBuffers),
+    m_BufferSize{bufferSize}
+{
+    for (UnpackBuffer& buffer : m_Buffers)
+    {
+        glCreateBuffers(1, &buffer.RendererId);
+        glNamedBufferData(buffer.RendererId, static_cast<GLsizeiptr>(bufferSize), nullptr, GL_STREAM_DRAW);
+    }
+}
+
+PixelUnpackRing::~PixelUnpackRing()
+{
+    for (UnpackBuffer& buffer : m_Buffers)
+    {
+        if (buffer.Fence != nullptr)
+        {
+            glDeleteSync(static_cast<GLsync>(buffer.Fence));
+        }
+
+        glDeleteBuffers(1, &buffer.RendererId);
+    }
+}
+
+void PixelUnpackRing::Upload(const TextureUploadRegion& region, std::span<const std::byte> pixels)
+{
+    if (pixels.size() > m_BufferSize)
+    {
+        UploadDirect(region, pixels.data(), pixels.size());
+        return;
+    }
+
+    UnpackBuffer& buffer = m_Buffers[m_NextBuffer];
+    m_NextBuffer = (m_NextBuffer + 1) % static_cast<int>(m_Buffers.size());
+
+    if (buffer.Fence != nullptr)
+    {
+        // ring is long enough that GPU is usually done with the oldest buffer, so this rarely waits
+        constexpr GLuint64 MaxWaitNanoseconds = 1000000000;
+        GLenum waitResult = glClientWaitSync(static_cast<GLsync>(buffer.Fence), GL_SYNC_FLUSH_COMMANDS_BIT, MaxWaitNanoseconds);
+
+        if (waitResult == GL_TIMEOUT_EXPIRED || waitResult == GL_WAIT_FAILED)
+        {
+            // GPU may still read from buffer, so it stays guarded by it's fence and pixels are uploaded without it
+            UploadDirect(region, pixels.data(), pixels.size());
+            return;
+        }
+
+        glDeleteSync(static_cast<GLsync>(buffer.Fence));
+        buffer.Fence = nullptr;
+    }
+
+    // fence already guarantees GPU doesn't read from buffer, so driver doesn't need to synchronize mapping
+    void* mappedBuffer = glMapNamedBufferRange(buffer.RendererId, 0, static_cast<GLsizeiptr>(pixels.size()),
+        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+
+    if (mappedBuffer == nullptr)
+    {
+        UploadDirect(region, pixels.data(), pixels.size());
+        return;
+    }
+
+    std::memcpy(mappedBuffer, pixels.data(), pixels.size());
+    glUnmapNamedBuffer(buffer.RendererId);
+
+    // with unpack buffer bound pixels pointer is offset into buffer
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer.RendererId);
+    UploadDirect(region, nullptr, pixels.size());
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    buffer.Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void PixelUnpackRing::UploadDirect(const TextureUploadRegion& region, const void* pixels, size_t numBytes)
+{
+    if (region.CompressedFormat != 0)
+    {
+        GLsizei imageSize = static_cast<GLsizei>(numBytes);
+
+        if (region.Face < 0)
+        {
+            glCompressedTextureSubImage2D(region.TextureId, region.MipLevel, 0, 0, region.Width, region.Height, region.CompressedFormat, imageSize, pixels);
+        }
+        else
+        {
+            glCompressedTextureSubImage3D(region.TextureId, region.MipLevel, 0, 0, region.Face, region.Width, region.Height, 1, region.CompressedFormat, imageSize, pixels);
+        }
+    }
+    else if (region.Face < 0)
+    {
+        glTextureSubImage2D(region.TextureId, region.MipLevel, 0, 0, region.Width, region.Height, region.DataFormat, GL_UNSIGNED_BYTE, pixels);
+    }
+    else
+    {
+        // faces of cube map are layers of it's storage
+        glTextureSubImage3D(region.TextureId, region.MipLevel, 0, 0, region.Face, region.Width, region.Height, 1, region.DataFormat, GL_UNSIGNED_BYTE, pixels);
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+struct TextureUploadRegion
+{
+    uint32_t TextureId{0};
+    int Width{0};
+    int Height{0};
+
+    // face of cube map or layer of texture array, -1 for 2D texture
+    int Face{-1};
+
+    // GL_RGB or GL_RGBA
+    uint32_t DataFormat{0};
+
+    // internal format of block compressed pixels, 0 when pixels aren't compressed
+    uint32_t CompressedFormat{0};
+
+    int MipLevel{0};
+};
+
+// Ring of pixel unpack buffers used for texture uploads. Texture copy from unpack buffer is done
+// by driver in background, so main thread doesn't wait for it, only copies pixels to mapped buffer.
+// Each buffer is guarded by fence, so it's not overwritten while GPU still reads from it
+class PixelUnpackRing
+{
+public:
+    PixelUnpackRing(int numBuffers, size_t bufferSize);
+    ~PixelUnpackRing();
+
+    PixelUnpackRing(const PixelUnpackRing&) = delete;
+    PixelUnpackRing& operator=(const PixelUnpackRing&) = delete;
+
+    // Pixels that don't fit into single buffer are uploaded directly
+    void Upload(const TextureUploadRegion& region, std::span<const std::byte> pixels);
+
+    static void UploadDirect(const TextureUploadRegion& region, const void* pixels, size_t numBytes);
+
+private:
+    struct UnpackBuffer
+    {
+        uint32_t RendererId{0};
+
+        // GLsync of last upload that reads from buffer
+        void* Fence{nullptr};
+    };
+
+    std::vector<UnpackBuffer> m_Buffers;
+    size_t m_BufferSize;
+    int m_NextBuffer{0};
+};
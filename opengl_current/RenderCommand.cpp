@@ -46,6 +46,14 @@ void RenderCommand::DrawLines(const VertexArray& vertexArray, int numIndices)
     s_RenderStats.NumDrawcalls++;
 }
 
+void RenderCommand::DrawLineArrays(const VertexArray& vertexArray, int numVertices)
+{
+    ASSERT(s_bRenderCommandInitialized);
+
+    s_RendererApi.DrawLineArrays(vertexArray, numVertices);
+    s_RenderStats.NumDrawcalls++;
+}
+
 void RenderCommand::DrawIndexedInstanced(const VertexArray& vertexArray, int numInstances)
 {
     s_RendererApi.DrawIndexedInstanced(vertexArray, numInstances);
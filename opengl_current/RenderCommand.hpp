@@ -26,6 +26,7 @@ public:
     static void DrawIndexed(const VertexArray& vertexArray, int numIndices);
     static void DrawArrays(const VertexArray& vertexArray, int numVertices);
     static void DrawLines(const VertexArray& vertexArray, int numIndices);
+    static void DrawLineArrays(const VertexArray& vertexArray, int numVertices);
     static void DrawIndexedInstanced(const VertexArray& vertexArray, int numInstances);
 
     static void BeginScene();
@@ -10,6 +10,7 @@
 
 RendererData Renderer::s_RendererData{};
 std::shared_ptr<Texture2D> Renderer::s_DefaultTexture;
+std::shared_ptr<Texture2DArray> Renderer::s_DefaultTextureArray;
 
 static constexpr RgbColor Black{0, 0, 0};
 static constexpr RgbColor Magenta{255, 0, 255};
@@ -35,9 +36,9 @@ public:
         m_ActualNumLights = 0;
     }
 
-    void BindBuffer(Shader& shader, const std::string& bindingName) const
+    void BindBuffer(Shader& shader, UniformHandle block) const
     {
-        shader.BindUniformBuffer(shader.GetUniformBlockIndex(bindingName), m_UniformBuffer);
+        shader.BindUniformBuffer(shader.GetUniformBlockIndex(block), m_UniformBuffer);
     }
 
     int GetNumLights() const
@@ -51,6 +52,11 @@ private:
 };
 
 static LightBuffer* s_LightBuffer = nullptr;
+static PixelUnpackRing* s_PixelUnpackRing = nullptr;
+
+// 3 buffers, so texture can be copied to buffer while GPU reads from previous two
+constexpr int NumPixelUnpackBuffers = 3;
+constexpr size_t PixelUnpackBufferSize = 16 * 1024 * 1024;
 
 void Renderer::UpdateProjection(const CameraProjection& projection)
 {
@@ -86,7 +92,7 @@ void Renderer::Submit(const StaticMeshEntry& meshEntry, const glm::mat4& transfo
     RenderCommand::DrawIndexed(meshEntry.GetVertexArray(), meshEntry.GetNumIndices());
 }
 
-void Renderer::SubmitSkeleton(const SkeletalMesh& skeletalMesh, const glm::mat4& transform, std::span<const glm::mat4> boneTransforms)
+void Renderer::SubmitSkeleton(const SkeletalMesh& skeletalMesh, const glm::mat4& transform, std::span<const glm::mat4> boneTransforms, int lod)
 {
     const Material& material = *skeletalMesh.MainMaterial;
 
@@ -94,7 +100,7 @@ void Renderer::SubmitSkeleton(const SkeletalMesh& skeletalMesh, const glm::mat4&
     StartSubmiting(material, transform);
     shader->SetUniformMat4Array("u_BoneTransforms", boneTransforms);
 
-    const VertexArray& vertexArray = skeletalMesh.GetVertexArray();
+    const VertexArray& vertexArray = skeletalMesh.GetVertexArray(lod);
     RenderCommand::DrawIndexed(vertexArray, vertexArray.GetNumIndices());
 }
 
@@ -108,6 +114,18 @@ void Renderer::SubmitMeshInstanced(const StaticMeshEntry& mesh, const Material&
     RenderCommand::DrawIndexedInstanced(mesh.GetVertexArray(), numInstances);
 }
 
+void Renderer::SubmitSkeletonInstanced(const SkeletalMesh& skeletalMesh, const Material& material, const ShaderStorageBuffer& bonePalette,
+    const ShaderStorageBuffer& instances, int numInstances, const glm::mat4& transform, int lod)
+{
+    std::shared_ptr<Shader> shader = material.GetShader();
+    StartSubmiting(material, transform);
+
+    shader->BindShaderStorageBuffer(shader->GetShaderStorageBlockIndex("BonePalette"), bonePalette);
+    shader->BindShaderStorageBuffer(shader->GetShaderStorageBlockIndex("SkeletalInstances"), instances);
+
+    RenderCommand::DrawIndexedInstanced(skeletalMesh.GetVertexArray(lod), numInstances);
+}
+
 void Renderer::Initialize()
 {
     // array of checkerboard with black and magenta
@@ -122,8 +140,26 @@ void Renderer::Initialize()
     int colorsWidth = 4;
     int colorsHeight = 4;
 
+    s_PixelUnpackRing = new PixelUnpackRing(NumPixelUnpackBuffers, PixelUnpackBufferSize);
+
     s_DefaultTexture = std::make_shared<Texture2D>(colors, TextureSpecification{colorsWidth, colorsHeight, TextureFormat::Rgb});
     s_DefaultTexture->SetFilteringType(FilteringType::Nearest);
+
+    ImageRgba checkerboard{colorsWidth, colorsHeight};
+
+    for (int i = 0; i < colorsWidth * colorsHeight; ++i)
+    {
+        const RgbColor& color = colors[i / colorsWidth][i % colorsWidth];
+        uint8_t* pixel = checkerboard.GetRawImageData() + 4 * i;
+        pixel[0] = color.Red;
+        pixel[1] = color.Green;
+        pixel[2] = color.Blue;
+        pixel[3] = 255;
+    }
+
+    s_DefaultTextureArray = std::make_shared<Texture2DArray>(TextureSpecification{colorsWidth, colorsHeight, TextureFormat::Rgba}, 1);
+    s_DefaultTextureArray->AddLayer(checkerboard);
+    s_DefaultTextureArray->SetFilteringType(FilteringType::Nearest);
     RenderCommand::Initialize();
 
     RenderCommand::ClearBufferBindings_Debug();
@@ -135,11 +171,24 @@ void Renderer::Initialize()
 void Renderer::Quit()
 {
     SafeDelete(s_LightBuffer);
+    SafeDelete(s_PixelUnpackRing);
 
     s_DefaultTexture.reset();
+    s_DefaultTextureArray.reset();
     RenderCommand::Quit();
 }
 
+void Renderer::UploadTexturePixels(const TextureUploadRegion& region, std::span<const std::byte> pixels)
+{
+    if (s_PixelUnpackRing == nullptr)
+    {
+        PixelUnpackRing::UploadDirect(region, pixels.data(), pixels.size());
+        return;
+    }
+
+    s_PixelUnpackRing->Upload(region, pixels);
+}
+
 void Renderer::StartSubmiting(const Material& material, const glm::mat4& transform)
 {
     material.SetupRenderState();
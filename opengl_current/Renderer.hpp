@@ -10,6 +10,7 @@
 #include "CameraProjection.hpp"
 #include "Box.hpp"
 #include "Viewport.hpp"
+#include "PixelUnpackRing.hpp"
 
 #include "StaticMesh.hpp"
 #include "SkeletalMesh.hpp"
@@ -36,12 +37,23 @@ public:
     static void EndScene();
 
     static void Submit(const StaticMeshEntry& meshEntry, const glm::mat4& transform);
-    static void SubmitSkeleton(const SkeletalMesh& skeletalMesh, const glm::mat4& transform, std::span<const glm::mat4> boneTransforms);
+    static void SubmitSkeleton(const SkeletalMesh& skeletalMesh, const glm::mat4& transform, std::span<const glm::mat4> boneTransforms, int lod = 0);
 
     static void SubmitMeshInstanced(const StaticMeshEntry& mesh, const Material& material, const UniformBuffer& buffer, int numInstances, const glm::mat4& transform);
 
+    // Draws numInstances of skeletal mesh with single drawcall. bonePalette holds bone transforms of all instances,
+    // instances holds per instance transform with offset into the palette
+    static void SubmitSkeletonInstanced(const SkeletalMesh& skeletalMesh, const Material& material, const ShaderStorageBuffer& bonePalette,
+        const ShaderStorageBuffer& instances, int numInstances, const glm::mat4& transform, int lod = 0);
+
     static std::shared_ptr<Texture2D> GetDefaultTexture();
 
+    // Single layer array with the same checkerboard, bound to sampler2DArray parameters that aren't set
+    static std::shared_ptr<Texture2DArray> GetDefaultTextureArray();
+
+    // Uploads pixels through ring of pixel unpack buffers, so main thread doesn't wait for texture copy
+    static void UploadTexturePixels(const TextureUploadRegion& region, std::span<const std::byte> pixels);
+
     static glm::mat4 GetViewMatrix()
     {
         return s_RendererData.ViewMatrix;
@@ -65,6 +77,7 @@ public:
 private:
     static RendererData s_RendererData;
     static std::shared_ptr<Texture2D> s_DefaultTexture;
+    static std::shared_ptr<Texture2DArray> s_DefaultTextureArray;
 
 private:
     static void Initialize();
@@ -76,4 +89,9 @@ private:
 FORCE_INLINE std::shared_ptr<Texture2D> Renderer::GetDefaultTexture()
 {
     return s_DefaultTexture;
+}
+
+FORCE_INLINE std::shared_ptr<Texture2DArray> Renderer::GetDefaultTextureArray()
+{
+    return s_DefaultTextureArray;
 }
\ No newline at end of file
@@ -4,10 +4,30 @@
 
 #include <glm/gtc/matrix_transform.hpp>
 
+#include <algorithm>
+#include <limits>
+#include <vector>
+
 static glm::mat4 s_Projection{1.0f};
 
 static SpriteBatch* s_SpriteBatch = nullptr;
 
+// Sprite collected by sort stage. Key is (layer, translucent flag, texture order) from most significant bits,
+// translucent sprites have zero texture order, so stable sort keeps their submission order
+struct SpriteSortRecord
+{
+    uint32_t Key;
+    uint32_t Index;
+};
+
+static bool s_bSortingEnabled = false;
+static std::vector<Sprite2D> s_SortedSprites;
+static std::vector<SpriteSortRecord> s_SortRecords;
+static std::vector<SpriteSortRecord> s_SortScratch;
+
+// Textures seen this frame in order of first use. Few textures are used per frame, so linear find is enough
+static std::vector<const ITexture*> s_SortTextures;
+
 void Renderer2D::Initialize()
 {
 }
@@ -17,10 +37,10 @@ void Renderer2D::Quit()
     SafeDelete(s_SpriteBatch);
 }
 
-void Renderer2D::SetDrawShader(const std::shared_ptr<Shader>& shader)
+void Renderer2D::SetDrawShader(const std::shared_ptr<Shader>& shader, SpriteBatchMode mode)
 {
     SafeDelete(s_SpriteBatch);
-    s_SpriteBatch = new SpriteBatch(std::make_shared<Material>(shader), s_Projection);
+    s_SpriteBatch = new SpriteBatch(std::make_shared<Material>(shader), s_Projection, mode);
 }
 
 void Renderer2D::UpdateProjection(const CameraProjection& projection)
@@ -34,14 +54,19 @@ static constexpr glm::vec2 SpriteVertexPositions[4] =
  {  1.0f,  1.0f },
  {  0.0f,  1.0f }};
 
-void Renderer2D::DrawSprite(const Sprite2D& definition)
+static void AddSpriteToBatch(const Sprite2D& definition)
 {
-    ASSERT(s_SpriteBatch);
-    ASSERT(definition.TextureId < s_SpriteBatch->GetNumBindedTextures());
-
     glm::vec2 start = definition.SpriteSheetInfo.GetStartUvCoordinate(definition.AnimationFrame);
     glm::vec2 end = definition.SpriteSheetInfo.GetEndUvCoordinate(definition.AnimationFrame);
 
+    if (s_SpriteBatch->GetMode() == SpriteBatchMode::Instanced)
+    {
+        const Transform2D& transform = definition.Transform;
+        s_SpriteBatch->AddSpriteInstance(SpriteInstance{transform.Position, transform.Size, transform.Origin, transform.Rotation,
+            glm::vec4{start, end}, definition.TextureId, definition.Tint});
+        return;
+    }
+
     std::array<SpriteVertex, NumQuadVertices> vertices = {
         SpriteVertex{SpriteVertexPositions[0], start, definition.TextureId, definition.Tint},
         SpriteVertex{SpriteVertexPositions[1], glm::vec2(end.x, start.y), definition.TextureId, definition.Tint},
@@ -52,13 +77,180 @@ void Renderer2D::DrawSprite(const Sprite2D& definition)
     s_SpriteBatch->AddSpriteInstance(vertices, definition.Transform);
 }
 
+static uint32_t MakeSortKey(const Sprite2D& sprite)
+{
+    constexpr int MinLayer = std::numeric_limits<int16_t>::min();
+    constexpr int MaxLayer = std::numeric_limits<int16_t>::max();
+
+    uint32_t key = static_cast<uint32_t>(std::clamp(sprite.Layer, MinLayer, MaxLayer) - MinLayer) << 16;
+    const ITexture* texture = sprite.SpriteSheetInfo.GetTexture().get();
+
+    // only sprites that blend with what's under them keep submission order, glyph edges are blended too
+    bool bTranslucent = sprite.Tint.Alpha < 255 || (sprite.TextureId & SdfTextureFlag) != 0 ||
+        (texture != nullptr && texture->IsTranslucent());
+
+    if (bTranslucent)
+    {
+        return key | 0x8000;
+    }
+
+    auto it = std::find(s_SortTextures.begin(), s_SortTextures.end(), texture);
+
+    if (it == s_SortTextures.end())
+    {
+        it = s_SortTextures.insert(it, texture);
+    }
+
+    return key | static_cast<uint32_t>(std::min<ptrdiff_t>(std::distance(s_SortTextures.begin(), it), 0x7FFF));
+}
+
+// LSD radix sort by 8 bit digits. Each pass is stable, so records with equal keys stay in submission order
+static void RadixSortRecords(std::vector<SpriteSortRecord>& records, std::vector<SpriteSortRecord>& scratch)
+{
+    scratch.resize(records.size());
+
+    for (uint32_t shift = 0; shift < 32; shift += 8)
+    {
+        uint32_t offsets[256] = {};
+
+        for (const SpriteSortRecord& record : records)
+        {
+            ++offsets[(record.Key >> shift) & 0xFF];
+        }
+
+        // all keys share this digit, pass wouldn't move anything
+        if (offsets[(records[0].Key >> shift) & 0xFF] == records.size())
+        {
+            continue;
+        }
+
+        uint32_t sum = 0;
+
+        for (uint32_t& offset : offsets)
+        {
+            uint32_t count = offset;
+            offset = sum;
+            sum += count;
+        }
+
+        for (const SpriteSortRecord& record : records)
+        {
+            scratch[offsets[(record.Key >> shift) & 0xFF]++] = record;
+        }
+
+        records.swap(scratch);
+    }
+}
+
+void Renderer2D::SetSortingEnabled(bool bEnabled)
+{
+    if (s_bSortingEnabled && !bEnabled && s_SpriteBatch != nullptr)
+    {
+        FlushDraw();
+    }
+
+    s_bSortingEnabled = bEnabled;
+}
+
+void Renderer2D::DrawSprite(const Sprite2D& definition)
+{
+    ASSERT(s_SpriteBatch);
+
+    if (s_bSortingEnabled)
+    {
+        s_SortRecords.emplace_back(SpriteSortRecord{MakeSortKey(definition), static_cast<uint32_t>(s_SortedSprites.size())});
+        s_SortedSprites.emplace_back(definition);
+        return;
+    }
+
+    ASSERT(definition.TextureId < s_SpriteBatch->GetNumBindedTextures());
+    AddSpriteToBatch(definition);
+}
+
+static void DrawSortedSprites()
+{
+    if (s_SortRecords.empty())
+    {
+        return;
+    }
+
+    RadixSortRecords(s_SortRecords, s_SortScratch);
+
+    // texture slots are bound in sorted order, so batch flushes only when more textures than slots are used in frame
+    for (const SpriteSortRecord& record : s_SortRecords)
+    {
+        Sprite2D& sprite = s_SortedSprites[record.Index];
+        sprite.TextureId = s_SpriteBatch->BindNewTexture(sprite.SpriteSheetInfo.GetTexture()) | (sprite.TextureId & SdfTextureFlag);
+        AddSpriteToBatch(sprite);
+    }
+
+    s_SortedSprites.clear();
+    s_SortRecords.clear();
+    s_SortTextures.clear();
+}
+
+void Renderer2D::DrawTextLayout(const TextLayout& layout, glm::vec2 position, float fontSize, RgbaColor tint, int layer)
+{
+    ASSERT(s_SpriteBatch);
+
+    if (layout.Glyphs.empty())
+    {
+        return;
+    }
+
+    float scale = fontSize / layout.PixelHeight;
+
+    if (s_bSortingEnabled)
+    {
+        for (const GlyphQuad& glyph : layout.Glyphs)
+        {
+            AtlasRegion region{layout.Atlas, glm::vec2{glyph.UvRect.x, glyph.UvRect.y}, glm::vec2{glyph.UvRect.z, glyph.UvRect.w}, glm::ivec2{glyph.Size}};
+            Sprite2D sprite{position + glyph.Position * scale, glyph.Size * scale, SdfTextureFlag, SpriteSheetData{glm::uvec2{1, 1}, glm::vec2{0, 0}, region}, glm::uvec2{0, 0}, tint};
+            sprite.Layer = layer;
+            DrawSprite(sprite);
+        }
+
+        return;
+    }
+
+    int textureId = s_SpriteBatch->BindNewTexture(layout.Atlas) | SdfTextureFlag;
+
+    for (const GlyphQuad& glyph : layout.Glyphs)
+    {
+        glm::vec2 glyphPosition = position + glyph.Position * scale;
+        glm::vec2 glyphSize = glyph.Size * scale;
+
+        if (s_SpriteBatch->GetMode() == SpriteBatchMode::Instanced)
+        {
+            s_SpriteBatch->AddSpriteInstance(SpriteInstance{glyphPosition, glyphSize, glm::vec2{0, 0}, 0.0f, glyph.UvRect, textureId, tint});
+            continue;
+        }
+
+        glm::vec2 start{glyph.UvRect.x, glyph.UvRect.y};
+        glm::vec2 end{glyph.UvRect.z, glyph.UvRect.w};
+
+        std::array<SpriteVertex, NumQuadVertices> vertices = {
+            SpriteVertex{SpriteVertexPositions[0], start, textureId, tint},
+            SpriteVertex{SpriteVertexPositions[1], glm::vec2(end.x, start.y), textureId, tint},
+            SpriteVertex{SpriteVertexPositions[2], end, textureId, tint},
+            SpriteVertex{SpriteVertexPositions[3], glm::vec2(start.x, end.y), textureId, tint}
+        };
+
+        s_SpriteBatch->AddSpriteInstance(vertices, Transform2D{glyphPosition, 0.0f, glyphSize});
+    }
+}
+
 void Renderer2D::FlushDraw()
 {
+    if (s_bSortingEnabled)
+    {
+        DrawSortedSprites();
+    }
+
     s_SpriteBatch->FlushDraw(s_Projection);
 }
 
 int Renderer2D::BindTextureToDraw(const std::shared_ptr<ITexture>& texture)
 {
-    s_SpriteBatch->BindNewTexture(texture);
-    return s_SpriteBatch->GetNumBindedTextures() - 1;
+    return s_SpriteBatch->BindNewTexture(texture);
 }
\ No newline at end of file
@@ -8,6 +8,16 @@
 #include "Transform.hpp"
 #include "Sprite2D.hpp"
 #include "CameraProjection.hpp"
+#include "SdfFont.hpp"
+
+enum class SpriteBatchMode : uint8_t
+{
+    // 4 vertices transformed on CPU are uploaded per sprite
+    Vertices,
+
+    // one SpriteInstance is uploaded per sprite, shader must expand quads (see sprite_2d_instanced.vert)
+    Instanced
+};
 
 class Renderer2D
 {
@@ -18,12 +28,22 @@ private:
     static void Quit();
 
 public:
-    static void SetDrawShader(const std::shared_ptr<Shader>& shader);
+    // Instanced mode requires shader that expands SpriteInstance records to quads
+    static void SetDrawShader(const std::shared_ptr<Shader>& shader, SpriteBatchMode mode = SpriteBatchMode::Vertices);
 
     static void UpdateProjection(const CameraProjection& projection);
 
+    // When enabled, sprites are collected until FlushDraw and sorted by layer and texture of their sprite sheet,
+    // so sprites sharing texture are drawn together and TextureId is ignored. Translucent sprites (tint alpha below 255,
+    // text or texture with any alpha below 255) keep submission order inside layer and are drawn after opaque ones of the same layer
+    static void SetSortingEnabled(bool bEnabled);
+
     static void DrawSprite(const Sprite2D& sprite);
     static void FlushDraw();
 
+    // Draws glyphs of layout as sprites, position is start of baseline of first line and font size is height of line
+    // in pixels. Layouts of static strings should be cached (see SdfFont::GetCachedLayout), so drawing only uploads quads
+    static void DrawTextLayout(const TextLayout& layout, glm::vec2 position, float fontSize, RgbaColor tint = RgbaColor{}, int layer = 0);
+
     static int BindTextureToDraw(const std::shared_ptr<ITexture>& texture);
 };
\ No newline at end of file
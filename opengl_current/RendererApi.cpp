@@ -89,6 +89,14 @@ void RendererApi::DrawLines(const VertexArray& vertexArray, int numIndices)
     DrawIndexedUsingGlPrimitives(vertexArray, numIndices, GL_LINES);
 }
 
+void RendererApi::DrawLineArrays(const VertexArray& vertexArray, int numVertices)
+{
+    ASSERT(numVertices >= 0);
+
+    vertexArray.Bind();
+    glDrawArrays(GL_LINES, 0, numVertices);
+}
+
 void RendererApi::DrawIndexedInstanced(const VertexArray& vertexArray, int numInstances)
 {
     ASSERT(numInstances >= 0);
@@ -63,6 +63,7 @@ public:
     void DrawIndexed(const VertexArray& vertexArray, int numIndices);
     void DrawArrays(const VertexArray& vertexArray, int numVertices);
     void DrawLines(const VertexArray& vertexArray, int numIndices);
+    void DrawLineArrays(const VertexArray& vertexArray, int numVertices);
     void DrawIndexedInstanced(const VertexArray& vertexArray, int numInstances);
 
     void SetCullFace(bool bCullFaces);
@@ -1,40 +1,199 @@
 #include "ResourceManager.hpp"
+#include "Renderer.hpp"
+#include "Logging.hpp"
+#include "ThreadPool.hpp"
+#include "GpuUploadQueue.hpp"
+#include "IndexBuffer.hpp"
+#include "VertexBuffer.hpp"
+#include "UniformBuffer.hpp"
+#include "ShaderStorageBuffer.hpp"
+#include "FileWatcher.hpp"
+#include "ShaderPreprocessor.hpp"
+
 #include <fstream>
 #include <filesystem>
+#include <functional>
+#include <limits>
 
 std::shared_ptr<ResourceManagerImpl> ResourceManager::s_ResourceManagerInstance;
 
+// loading is mostly waiting for disk and decoding, so few threads are enough and rest of cores are left for game
+static constexpr int NumLoadingThreads = 2;
+static constexpr const char* PlaceholderStaticMeshName = "PlaceholderCube";
+
+// Result of part of asset loading done on loading thread. Create is called on main thread and makes GPU objects
+template <typename T>
+struct LoadedAssetData
+{
+    std::function<std::shared_ptr<T>()> Create;
+    size_t NumBytes{0};
+};
+
+// Asset that is loading in background. Upload is set by loading thread once GPU upload of asset is queued
+template <typename T>
+struct PendingAsset
+{
+    std::shared_future<std::shared_ptr<T>> Asset;
+    std::shared_future<GpuUploadId> Upload;
+};
+
+template <typename T>
+using PendingAssetMap = std::unordered_map<std::string, PendingAsset<T>>;
+
+// Asset kept by resource manager. Asset is referenced while anything besides manager holds pointer to it
+template <typename T>
+struct ResidentAsset
+{
+    std::shared_ptr<T> Asset;
+    uint64_t LastUsedFrame{0};
+
+    // Loads asset again when it's changed. Assets registered from memory have none, so they are never evicted
+    std::function<LoadedAssetData<T>()> Load;
+
+    // normalized paths of files asset is made of
+    std::vector<std::string> SourceFiles;
+
+    // Loads asset without given number of its top mips. Only textures with cooked mip chain have it
+    std::function<LoadedAssetData<T>(int)> LoadWithDroppedMips{nullptr};
+    int NumDroppedMips{0};
+
+    bool CanBeLoadedAgain() const
+    {
+        return Load != nullptr;
+    }
+
+    // reloaded asset keeps mips dropped to fit GPU budget
+    std::function<LoadedAssetData<T>()> GetLoadFunction() const
+    {
+        if (LoadWithDroppedMips)
+        {
+            return [load = LoadWithDroppedMips, numDroppedMips = NumDroppedMips]() { return load(numDroppedMips); };
+        }
+
+        return Load;
+    }
+
+    bool IsReferenced() const
+    {
+        return Asset.use_count() > 1;
+    }
+};
+
+struct ShaderManifest;
+
+template <typename T>
+using ResidentAssetMap = std::unordered_map<std::string, ResidentAsset<T>>;
+
 class ResourceManagerImpl
 {
 public:
-    std::shared_ptr<Shader> GetShader(const std::string& filePath);
-    std::shared_ptr<Shader> LoadShader(const std::string& filePath);
+    std::shared_ptr<Shader> GetShader(const std::string& filePath, const std::vector<std::string>& keywords);
+    std::shared_ptr<Shader> LoadShader(const std::string& filePath, const std::vector<std::string>& keywords, const std::string& variantName);
 
     std::shared_ptr<Texture2D> GetTexture2D(const std::string& filePath);
     std::shared_ptr<Texture2D> LoadTexture2D(const std::string& filePath);
     void AddTexture2D(const std::string& path, const std::shared_ptr<Texture2D>& texture);
 
+    TextureArrayLayer GetTextureArrayLayer(const std::string& filePath, TextureCompression compression);
+
     std::shared_ptr<SkeletalMesh> GetSkeletalMesh(const std::string& filePath);
     std::shared_ptr<SkeletalMesh> LoadSkeletalMesh(const std::string& filePath);
 
     std::shared_ptr<StaticMesh> GetStaticMesh(const std::string& filePath);
     std::shared_ptr<StaticMesh> LoadStaticMesh(const std::string& filePath);
 
+    AssetHandle<Texture2D> GetTexture2DAsync(const std::string& filePath, TextureCompression compression);
+    AssetHandle<StaticMesh> GetStaticMeshAsync(const std::string& filePath);
+    AssetHandle<SkeletalMesh> GetSkeletalMeshAsync(const std::string& filePath);
+    void ProcessUploads(size_t maxBytes, milliseconds_float_t maxTime);
+    std::shared_ptr<StaticMesh> GetPlaceholderStaticMesh();
+
+    std::shared_ptr<Skeleton> FindOrAddSkeleton(const std::shared_ptr<Skeleton>& skeleton);
+
     std::shared_ptr<Material> GetMaterial(const std::string& materialName);
     std::shared_ptr<Material> CreateMaterial(const std::string& shaderFilePath, const std::string& materialName);
+    std::shared_ptr<MaterialInstance> CreateMaterialInstance(const std::string& parentMaterialName, const std::string& instanceName);
+
+    void SetMemoryBudget(size_t gpuBudget, size_t cpuBudget);
+    void UpdateResidency();
+    ResourceResidencyStats GetResidencyStats() const;
+
+    void WatchAssetDirectory(const std::filesystem::path& directory);
+    void ReloadChangedAssets();
+
+    ThreadPool& GetLoadingThreadPool()
+    {
+        return m_LoadingThreads;
+    }
 
 private:
-    std::unordered_map<std::string, std::shared_ptr<Shader>> m_Shaders;
+    ResidentAssetMap<Shader> m_Shaders;
+
+    // preprocessed sources by manifest path, variants only add defines to them, so files are read once
+    std::unordered_map<std::string, std::shared_ptr<const ShaderManifest>> m_ShaderManifests;
     std::unordered_map<std::string, std::shared_ptr<Material>> m_Materials;
-    std::unordered_map<std::string, std::shared_ptr<Texture2D>> m_Textures2d;
-    std::unordered_map<std::string, std::shared_ptr<SkeletalMesh>> m_SkeletalMeshes;
-    std::unordered_map<std::string, std::shared_ptr<StaticMesh>> m_StaticMeshes;
+    ResidentAssetMap<Texture2D> m_Textures2d;
+    std::unordered_map<std::string, TextureArrayLayer> m_TextureArrayLayers;
+    std::vector<std::shared_ptr<Texture2DArray>> m_TextureArrays;
+    ResidentAssetMap<SkeletalMesh> m_SkeletalMeshes;
+    ResidentAssetMap<StaticMesh> m_StaticMeshes;
+    // hash collision of different hierarchies keeps both skeletons under the same hash
+    std::unordered_multimap<uint64_t, std::shared_ptr<Skeleton>> m_Skeletons;
+
+    // pending maps are used only on main thread, loading threads communicate back only through upload queue
+    PendingAssetMap<Texture2D> m_PendingTextures2d;
+    PendingAssetMap<SkeletalMesh> m_PendingSkeletalMeshes;
+    PendingAssetMap<StaticMesh> m_PendingStaticMeshes;
+    std::shared_ptr<StaticMesh> m_PlaceholderStaticMesh;
+    GpuUploadQueue m_UploadQueue;
+
+    uint64_t m_FrameIndex{0};
+    size_t m_GpuBudget{std::numeric_limits<size_t>::max()};
+    size_t m_CpuBudget{std::numeric_limits<size_t>::max()};
+    int m_NumEvictedAssets{0};
+
+    std::vector<std::unique_ptr<FileWatcher>> m_FileWatchers;
+
+    // destroyed first, so loading threads are stopped before anything they use
+    ThreadPool m_LoadingThreads{NumLoadingThreads};
+
+private:
+    template <typename ImageType>
+    TextureArrayLayer AddTextureArrayLayer(const ImageType& image, const TextureSpecification& specification, int numMips);
+
+    template <typename T>
+    AssetHandle<T> LoadAsync(const std::string& filePath, ResidentAssetMap<T>& assets,
+        PendingAssetMap<T>& pendingAssets, const std::shared_ptr<T>& placeholder, std::function<LoadedAssetData<T>()> load,
+        std::function<LoadedAssetData<T>(int)> loadWithDroppedMips = nullptr);
+
+    // Blocks until asset that is loading in background is ready. Returns nullptr when asset isn't loading
+    template <typename T>
+    std::shared_ptr<T> WaitForPendingAsset(const PendingAssetMap<T>& pendingAssets, const std::string& filePath);
+
+    template <typename T>
+    std::shared_ptr<T> UseAsset(ResidentAsset<T>& residentAsset);
+
+    // Removes least recently used asset that nothing references. Returns false when there is no such asset
+    bool EvictLeastRecentlyUsedAsset();
+
+    // Loads textures that are still over GPU budget again without their top mip, the largest ones first
+    void DropTextureMipsOverBudget();
+
+    // Sum of CPU memory held by resident assets
+    size_t GetNumCpuBytesUsed() const;
+
+    // Loads asset again on loading thread and swaps it into existing object, so everything holding asset sees new one
+    template <typename T>
+    void ReloadAsset(const std::string& filePath, const ResidentAsset<T>& residentAsset);
+
+    template <typename T>
+    void ReloadAssetsUsingFile(const ResidentAssetMap<T>& assets, const std::string& changedFile);
 };
 
-std::shared_ptr<Shader> ResourceManager::GetShader(const std::string& filePath)
+std::shared_ptr<Shader> ResourceManager::GetShader(const std::string& filePath, const std::vector<std::string>& keywords)
 {
     ASSERT(s_ResourceManagerInstance);
-    return s_ResourceManagerInstance->GetShader(filePath);
+    return s_ResourceManagerInstance->GetShader(filePath, keywords);
 }
 
 std::shared_ptr<Texture2D> ResourceManager::GetTexture2D(const std::string& filePath)
@@ -43,6 +202,12 @@ std::shared_ptr<Texture2D> ResourceManager::GetTexture2D(const std::string& file
     return s_ResourceManagerInstance->GetTexture2D(filePath);
 }
 
+TextureArrayLayer ResourceManager::GetTextureArrayLayer(const std::string& filePath, TextureCompression compression)
+{
+    ASSERT(s_ResourceManagerInstance);
+    return s_ResourceManagerInstance->GetTextureArrayLayer(filePath, compression);
+}
+
 void ResourceManager::AddTexture2D(const std::string& path, const std::shared_ptr<Texture2D>& texture)
 {
     ASSERT(s_ResourceManagerInstance);
@@ -61,6 +226,42 @@ std::shared_ptr<StaticMesh> ResourceManager::GetStaticMesh(const std::string& fi
     return s_ResourceManagerInstance->GetStaticMesh(filePath);
 }
 
+AssetHandle<Texture2D> ResourceManager::GetTexture2DAsync(const std::string& filePath, TextureCompression compression)
+{
+    ASSERT(s_ResourceManagerInstance);
+    return s_ResourceManagerInstance->GetTexture2DAsync(filePath, compression);
+}
+
+AssetHandle<StaticMesh> ResourceManager::GetStaticMeshAsync(const std::string& filePath)
+{
+    ASSERT(s_ResourceManagerInstance);
+    return s_ResourceManagerInstance->GetStaticMeshAsync(filePath);
+}
+
+AssetHandle<SkeletalMesh> ResourceManager::GetSkeletalMeshAsync(const std::string& filePath)
+{
+    ASSERT(s_ResourceManagerInstance);
+    return s_ResourceManagerInstance->GetSkeletalMeshAsync(filePath);
+}
+
+void ResourceManager::ProcessUploads(size_t maxBytes, milliseconds_float_t maxTime)
+{
+    ASSERT(s_ResourceManagerInstance);
+    s_ResourceManagerInstance->ProcessUploads(maxBytes, maxTime);
+}
+
+std::shared_ptr<StaticMesh> ResourceManager::GetPlaceholderStaticMesh()
+{
+    ASSERT(s_ResourceManagerInstance);
+    return s_ResourceManagerInstance->GetPlaceholderStaticMesh();
+}
+
+std::shared_ptr<Skeleton> ResourceManager::FindOrAddSkeleton(const std::shared_ptr<Skeleton>& skeleton)
+{
+    ASSERT(s_ResourceManagerInstance);
+    return s_ResourceManagerInstance->FindOrAddSkeleton(skeleton);
+}
+
 std::shared_ptr<Material> ResourceManager::GetMaterial(const std::string& materialName)
 {
     ASSERT(s_ResourceManagerInstance);
@@ -73,27 +274,57 @@ std::shared_ptr<Material> ResourceManager::CreateMaterial(const std::string& sha
     return s_ResourceManagerInstance->CreateMaterial(shaderFilePath, materialName);
 }
 
-void ResourceManager::Quit()
+std::shared_ptr<MaterialInstance> ResourceManager::CreateMaterialInstance(const std::string& parentMaterialName, const std::string& instanceName)
 {
-    s_ResourceManagerInstance = nullptr;
+    ASSERT(s_ResourceManagerInstance);
+    return s_ResourceManagerInstance->CreateMaterialInstance(parentMaterialName, instanceName);
 }
 
-std::shared_ptr<ResourceManagerImpl> ResourceManager::CreateResourceManager()
+void ResourceManager::SetMemoryBudget(size_t gpuBudget, size_t cpuBudget)
 {
-    s_ResourceManagerInstance = std::make_shared<ResourceManagerImpl>();
-    return s_ResourceManagerInstance;
+    ASSERT(s_ResourceManagerInstance);
+    s_ResourceManagerInstance->SetMemoryBudget(gpuBudget, cpuBudget);
 }
 
-std::shared_ptr<Shader> ResourceManagerImpl::GetShader(const std::string& filePath)
+void ResourceManager::UpdateResidency()
 {
-    auto it = m_Shaders.find(filePath);
+    ASSERT(s_ResourceManagerInstance);
+    s_ResourceManagerInstance->UpdateResidency();
+}
 
-    if (it == m_Shaders.end())
-    {
-        return LoadShader(filePath);
-    }
+ResourceResidencyStats ResourceManager::GetResidencyStats()
+{
+    ASSERT(s_ResourceManagerInstance);
+    return s_ResourceManagerInstance->GetResidencyStats();
+}
 
-    return it->second;
+void ResourceManager::WatchAssetDirectory(const std::filesystem::path& directory)
+{
+    ASSERT(s_ResourceManagerInstance);
+    s_ResourceManagerInstance->WatchAssetDirectory(directory);
+}
+
+void ResourceManager::ReloadChangedAssets()
+{
+    ASSERT(s_ResourceManagerInstance);
+    s_ResourceManagerInstance->ReloadChangedAssets();
+}
+
+ThreadPool& ResourceManager::GetLoadingThreadPool()
+{
+    ASSERT(s_ResourceManagerInstance);
+    return s_ResourceManagerInstance->GetLoadingThreadPool();
+}
+
+void ResourceManager::Quit()
+{
+    s_ResourceManagerInstance = nullptr;
+}
+
+std::shared_ptr<ResourceManagerImpl> ResourceManager::CreateResourceManager()
+{
+    s_ResourceManagerInstance = std::make_shared<ResourceManagerImpl>();
+    return s_ResourceManagerInstance;
 }
 
 struct ShaderStringMatch
@@ -102,15 +333,34 @@ struct ShaderStringMatch
     ShaderIndex::IndexType Index;
 };
 
-std::shared_ptr<Shader> ResourceManagerImpl::LoadShader(const std::string& filePath)
+// Sources of shader stages listed in shader manifest file, with includes expanded
+struct ShaderManifest
+{
+    std::vector<std::string> Sources;
+
+    // manifest, stage and included files, shader is compiled again when any of them changes
+    std::vector<std::string> SourceFiles;
+
+    // keywords every variant of shader is compiled with
+    std::vector<std::string> Keywords;
+};
+
+static std::string NormalizeAssetPath(const std::filesystem::path& path)
+{
+    return path.lexically_normal().generic_string();
+}
+
+static ShaderManifest ReadShaderManifest(const std::string& filePath)
 {
     std::string line;
     std::fstream file(filePath);
-    std::vector<std::string> shaderSources;
+    ShaderManifest manifest;
+    std::vector<std::string>& shaderSources = manifest.Sources;
 
     ASSERT(file.good() || !file.fail());
 
     shaderSources.reserve(ShaderIndex::Count);
+    manifest.SourceFiles.emplace_back(NormalizeAssetPath(filePath));
     std::filesystem::path path = filePath;
     path = path.remove_filename();
 
@@ -136,55 +386,247 @@ std::shared_ptr<Shader> ResourceManagerImpl::LoadShader(const std::string& fileP
 
     while (std::getline(file, line))
     {
-        std::vector<std::string> manifestLine = SplitString(line, "=");
+        // value can contain '=' itself, like keyword NUM_LIGHTS=4
+        size_t separator = line.find('=');
 
-        if (manifestLine.empty())
+        if (separator == std::string::npos)
         {
             continue;
         }
 
-        manifestLine[1] = path.string() + manifestLine[1];
+        std::string tag = line.substr(0, separator);
+        std::string value = line.substr(separator + 1);
+
+        if (tag == "Keywords")
+        {
+            for (std::string& keyword : SplitString(value, ","))
+            {
+                if (!keyword.empty())
+                {
+                    manifest.Keywords.emplace_back(std::move(keyword));
+                }
+            }
+
+            continue;
+        }
 
         for (const ShaderStringMatch& match : StringMatches)
         {
-            if (manifestLine[0] == match.Tag)
+            if (tag == match.Tag)
             {
-                insertAt(LoadFileContent(manifestLine[1]), match.Index);
+                ExpandedShaderSource expandedSource = ExpandShaderIncludes(path / value);
+                insertAt(expandedSource.Source, match.Index);
+
+                for (const std::filesystem::path& sourceFile : expandedSource.Files)
+                {
+                    manifest.SourceFiles.emplace_back(NormalizeAssetPath(sourceFile));
+                }
+
                 break;
             }
         }
     }
 
     ASSERT(shaderSources.size() < ShaderIndex::Count);
+    return manifest;
+}
+
+static std::vector<std::string> ApplyKeywordsToStages(const ShaderManifest& manifest, const std::vector<std::string>& keywords)
+{
+    std::vector<std::string> allKeywords = manifest.Keywords;
+    allKeywords.insert(allKeywords.end(), keywords.begin(), keywords.end());
+    allKeywords = NormalizeShaderKeywords(std::move(allKeywords));
+
+    std::vector<std::string> sources;
+    sources.reserve(manifest.Sources.size());
+
+    for (const std::string& source : manifest.Sources)
+    {
+        // stages missing in manifest stay empty
+        sources.emplace_back(source.empty() ? source : ApplyShaderKeywords(source, allKeywords));
+    }
+
+    return sources;
+}
+
+static std::string GetShaderVariantName(const std::string& filePath, const std::vector<std::string>& keywords)
+{
+    std::string variantName = filePath;
+
+    for (const std::string& keyword : keywords)
+    {
+        variantName += '|';
+        variantName += keyword;
+    }
+
+    return variantName;
+}
+
+static std::function<LoadedAssetData<Shader>()> MakeShaderLoader(const std::string& filePath, const std::vector<std::string>& keywords)
+{
+    return [filePath, keywords]()
+    {
+        // reading and preprocessing sources is done on loading thread, only compiling needs OpenGL
+        std::shared_ptr<std::vector<std::string>> sources = std::make_shared<std::vector<std::string>>(
+            ApplyKeywordsToStages(ReadShaderManifest(filePath), keywords));
+
+        return LoadedAssetData<Shader>{[sources]() { return std::make_shared<Shader>(*sources); }, 0};
+    };
+}
+
+// Encoding splits block rows between loading thread and other threads of pool
+static std::function<LoadedAssetData<Texture2D>(int)> MakeCompressedTextureLoader(const std::string& filePath, TextureCompression compression,
+    ThreadPool* threadPool)
+{
+    return [filePath, compression, threadPool](int numDroppedMips)
+    {
+        std::shared_ptr<CompressedImage> compressedImage = std::make_shared<CompressedImage>(LoadCompressedImageFromFile(filePath, compression, threadPool));
+        size_t numCompressedBytes = compressedImage->GetSizeInBytes();
+
+        return LoadedAssetData<Texture2D>{[compressedImage, numDroppedMips]()
+        {
+            return std::make_shared<Texture2D>(*compressedImage, numDroppedMips);
+        }, numCompressedBytes};
+    };
+}
+
+static std::function<LoadedAssetData<Texture2D>()> MakeTextureLoader(const std::string& filePath, TextureCompression compression, ThreadPool* threadPool)
+{
+    if (compression != TextureCompression::None)
+    {
+        return [load = MakeCompressedTextureLoader(filePath, compression, threadPool)]() { return load(0); };
+    }
+
+    return [filePath]()
+    {
+        // decoding is the slow part, only creating texture object needs OpenGL
+        std::shared_ptr<ImageRgba> image = std::make_shared<ImageRgba>(LoadRgbaImageFromFile(filePath));
+        size_t numBytes = image->GetSizeInBytes();
+
+        return LoadedAssetData<Texture2D>{[image]() { return std::make_shared<Texture2D>(*image); }, numBytes};
+    };
+}
+
+template <typename T>
+static std::function<LoadedAssetData<T>()> MakeMeshLoader(const std::string& filePath, const std::shared_ptr<Material>& material)
+{
+    return [filePath, material]()
+    {
+        std::shared_ptr<T> mesh = std::make_shared<T>(filePath, material, GpuUploadMode::Deferred);
+
+        return LoadedAssetData<T>{[mesh]()
+        {
+            mesh->FinishLoading();
+            return mesh;
+        }, mesh->GetNumPendingBytes()};
+    };
+}
+
+std::shared_ptr<Shader> ResourceManagerImpl::LoadShader(const std::string& filePath, const std::vector<std::string>& keywords,
+    const std::string& variantName)
+{
+    auto it = m_ShaderManifests.find(filePath);
+
+    if (it == m_ShaderManifests.end())
+    {
+        it = m_ShaderManifests.try_emplace(filePath, std::make_shared<const ShaderManifest>(ReadShaderManifest(filePath))).first;
+    }
 
-    std::shared_ptr<Shader> shader = std::make_shared<Shader>(shaderSources);
-    m_Shaders[filePath] = shader;
+    const ShaderManifest& manifest = *it->second;
+
+    std::shared_ptr<Shader> shader = std::make_shared<Shader>(ApplyKeywordsToStages(manifest, keywords));
+    m_Shaders[variantName] = ResidentAsset<Shader>{shader, m_FrameIndex, MakeShaderLoader(filePath, keywords), manifest.SourceFiles};
     return shader;
 }
 
+std::shared_ptr<Shader> ResourceManagerImpl::GetShader(const std::string& filePath, const std::vector<std::string>& keywords)
+{
+    std::vector<std::string> normalizedKeywords = NormalizeShaderKeywords(keywords);
+    std::string variantName = GetShaderVariantName(filePath, normalizedKeywords);
+    auto it = m_Shaders.find(variantName);
+
+    if (it == m_Shaders.end())
+    {
+        // variant is compiled when it's used first time, so unused combinations of keywords cost nothing
+        return LoadShader(filePath, normalizedKeywords, variantName);
+    }
+
+    return UseAsset(it->second);
+}
+
 std::shared_ptr<Texture2D> ResourceManagerImpl::GetTexture2D(const std::string& filePath)
 {
     auto it = m_Textures2d.find(filePath);
 
     if (it == m_Textures2d.end())
     {
-        return LoadTexture2D(filePath);
+        // joins asset that is already loading, instead of loading it second time
+        std::shared_ptr<Texture2D> texture = WaitForPendingAsset(m_PendingTextures2d, filePath);
+        return texture ? texture : LoadTexture2D(filePath);
     }
 
-    return it->second;
+    return UseAsset(it->second);
 }
 
 std::shared_ptr<Texture2D> ResourceManagerImpl::LoadTexture2D(const std::string& filePath)
 {
     std::shared_ptr<Texture2D> texture = std::make_shared<Texture2D>(filePath);
-    m_Textures2d[filePath] = texture;
+    m_Textures2d[filePath] = ResidentAsset<Texture2D>{texture, m_FrameIndex, MakeTextureLoader(filePath, TextureCompression::None, &m_LoadingThreads),
+        {NormalizeAssetPath(filePath)}};
 
     return texture;
 }
 
 void ResourceManagerImpl::AddTexture2D(const std::string& path, const std::shared_ptr<Texture2D>& texture)
 {
-    m_Textures2d[path] = texture;
+    m_Textures2d[path] = ResidentAsset<Texture2D>{texture, m_FrameIndex, nullptr, {}};
+}
+
+TextureArrayLayer ResourceManagerImpl::GetTextureArrayLayer(const std::string& filePath, TextureCompression compression)
+{
+    std::string path = NormalizeAssetPath(filePath);
+    auto it = m_TextureArrayLayers.find(path);
+
+    if (it != m_TextureArrayLayers.end())
+    {
+        return it->second;
+    }
+
+    TextureArrayLayer layer;
+
+    if (compression == TextureCompression::None)
+    {
+        ImageRgba image = LoadRgbaImageFromFile(path);
+        layer = AddTextureArrayLayer(image, TextureSpecification{image.GetWidth(), image.GetHeight(), TextureFormat::Rgba},
+            GetNumMipLevels(image.GetWidth(), image.GetHeight()));
+    }
+    else
+    {
+        CompressedImage image = LoadCompressedImageFromFile(path, compression, &m_LoadingThreads);
+        layer = AddTextureArrayLayer(image, TextureSpecification{image.Width, image.Height, image.Format}, image.GetNumMips());
+    }
+
+    m_TextureArrayLayers[path] = layer;
+    return layer;
+}
+
+template <typename ImageType>
+TextureArrayLayer ResourceManagerImpl::AddTextureArrayLayer(const ImageType& image, const TextureSpecification& specification, int numMips)
+{
+    auto it = std::find_if(m_TextureArrays.begin(), m_TextureArrays.end(), [&](const std::shared_ptr<Texture2DArray>& textureArray)
+    {
+        return textureArray->GetWidth() == specification.Width && textureArray->GetHeight() == specification.Height &&
+            textureArray->GetTextureFormat() == specification.Format && textureArray->GetNumMips() == numMips &&
+            textureArray->GetNumLayers() < MaxTextureArrayLayers;
+    });
+
+    if (it == m_TextureArrays.end())
+    {
+        m_TextureArrays.emplace_back(std::make_shared<Texture2DArray>(specification, numMips));
+        it = std::prev(m_TextureArrays.end());
+    }
+
+    return TextureArrayLayer{*it, (*it)->AddLayer(image)};
 }
 
 std::shared_ptr<SkeletalMesh> ResourceManagerImpl::GetSkeletalMesh(const std::string& filePath)
@@ -193,38 +635,230 @@ std::shared_ptr<SkeletalMesh> ResourceManagerImpl::GetSkeletalMesh(const std::st
 
     if (it == m_SkeletalMeshes.end())
     {
-        return LoadSkeletalMesh(filePath);
+        std::shared_ptr<SkeletalMesh> mesh = WaitForPendingAsset(m_PendingSkeletalMeshes, filePath);
+        return mesh ? mesh : LoadSkeletalMesh(filePath);
     }
 
-    return it->second;
+    return UseAsset(it->second);
 }
 
 std::shared_ptr<SkeletalMesh> ResourceManagerImpl::LoadSkeletalMesh(const std::string& filePath)
 {
-    std::shared_ptr<SkeletalMesh> skeletalMesh = std::make_shared<SkeletalMesh>(filePath, GetMaterial("default"));
-    m_SkeletalMeshes[filePath] = skeletalMesh;
+    std::shared_ptr<Material> material = GetMaterial("default");
+    std::shared_ptr<SkeletalMesh> skeletalMesh = std::make_shared<SkeletalMesh>(filePath, material);
+    m_SkeletalMeshes[filePath] = ResidentAsset<SkeletalMesh>{skeletalMesh, m_FrameIndex, MakeMeshLoader<SkeletalMesh>(filePath, material),
+        {NormalizeAssetPath(filePath)}};
     return skeletalMesh;
 }
 
+std::shared_ptr<Skeleton> ResourceManagerImpl::FindOrAddSkeleton(const std::shared_ptr<Skeleton>& skeleton)
+{
+    const FlatSkeleton& joints = skeleton->GetJoints();
+    auto [first, last] = m_Skeletons.equal_range(skeleton->GetHierarchyHash());
+
+    for (auto it = first; it != last; ++it)
+    {
+        const FlatSkeleton& sharedJoints = it->second->GetJoints();
+
+        if (sharedJoints.JointNames == joints.JointNames && sharedJoints.ParentIndices == joints.ParentIndices)
+        {
+            return it->second;
+        }
+    }
+
+    if (first != last)
+    {
+        ENG_LOG_WARNING("Skeleton hierarchy hash {} collides with different hierarchy, skeleton isn't shared", skeleton->GetHierarchyHash());
+    }
+
+    m_Skeletons.emplace(skeleton->GetHierarchyHash(), skeleton);
+    return skeleton;
+}
+
 std::shared_ptr<StaticMesh> ResourceManagerImpl::GetStaticMesh(const std::string& filePath)
 {
     auto it = m_StaticMeshes.find(filePath);
 
     if (it == m_StaticMeshes.end())
     {
-        return LoadStaticMesh(filePath);
+        std::shared_ptr<StaticMesh> mesh = WaitForPendingAsset(m_PendingStaticMeshes, filePath);
+        return mesh ? mesh : LoadStaticMesh(filePath);
     }
 
-    return it->second;
+    return UseAsset(it->second);
 }
 
 std::shared_ptr<StaticMesh> ResourceManagerImpl::LoadStaticMesh(const std::string& filePath)
 {
-    std::shared_ptr<StaticMesh> staticMesh = std::make_shared<StaticMesh>(filePath, GetMaterial("default"));
-    m_StaticMeshes[filePath] = staticMesh;
+    std::shared_ptr<Material> material = GetMaterial("default");
+    std::shared_ptr<StaticMesh> staticMesh = std::make_shared<StaticMesh>(filePath, material);
+    m_StaticMeshes[filePath] = ResidentAsset<StaticMesh>{staticMesh, m_FrameIndex, MakeMeshLoader<StaticMesh>(filePath, material),
+        {NormalizeAssetPath(filePath)}};
     return staticMesh;
 }
 
+template <typename T>
+AssetHandle<T> ResourceManagerImpl::LoadAsync(const std::string& filePath, ResidentAssetMap<T>& assets,
+    PendingAssetMap<T>& pendingAssets, const std::shared_ptr<T>& placeholder, std::function<LoadedAssetData<T>()> load,
+    std::function<LoadedAssetData<T>(int)> loadWithDroppedMips)
+{
+    auto it = assets.find(filePath);
+
+    if (it != assets.end())
+    {
+        return AssetHandle<T>{UseAsset(it->second)};
+    }
+
+    auto pendingIt = pendingAssets.find(filePath);
+
+    if (pendingIt == pendingAssets.end())
+    {
+        std::shared_ptr<std::promise<std::shared_ptr<T>>> promise = std::make_shared<std::promise<std::shared_ptr<T>>>();
+        std::shared_ptr<std::promise<GpuUploadId>> uploadPromise = std::make_shared<std::promise<GpuUploadId>>();
+        pendingIt = pendingAssets.try_emplace(filePath,
+            PendingAsset<T>{promise->get_future().share(), uploadPromise->get_future().share()}).first;
+
+        m_LoadingThreads.Enqueue([this, filePath, promise, uploadPromise, load, loadWithDroppedMips, &assets, &pendingAssets]()
+        {
+            LoadedAssetData<T> loadedData;
+
+            try
+            {
+                loadedData = load();
+            }
+            catch (const std::exception& e)
+            {
+                ENG_LOG_ERROR("Failed to load {}: {}", filePath, e.what());
+            }
+
+            GpuUploadId uploadId = m_UploadQueue.Enqueue([this, filePath, promise, load, loadWithDroppedMips,
+                create = std::move(loadedData.Create), &assets, &pendingAssets]()
+            {
+                std::shared_ptr<T> asset;
+
+                if (create)
+                {
+                    // asset might be loaded synchronously in meantime, then that one is kept
+                    ResidentAsset<T> residentAsset{create(), m_FrameIndex, load, {NormalizeAssetPath(filePath)}, loadWithDroppedMips};
+                    asset = UseAsset(assets.try_emplace(filePath, std::move(residentAsset)).first->second);
+                }
+
+                pendingAssets.erase(filePath);
+                promise->set_value(asset);
+            }, loadedData.NumBytes);
+
+            uploadPromise->set_value(uploadId);
+        });
+    }
+
+    return AssetHandle<T>{pendingIt->second.Asset, placeholder};
+}
+
+template <typename T>
+std::shared_ptr<T> ResourceManagerImpl::WaitForPendingAsset(const PendingAssetMap<T>& pendingAssets, const std::string& filePath)
+{
+    auto it = pendingAssets.find(filePath);
+
+    if (it == pendingAssets.end())
+    {
+        return nullptr;
+    }
+
+    // copy, because finished upload erases entry from pending map
+    PendingAsset<T> pendingAsset = it->second;
+
+    // asset is finished by upload queue on main thread, so only its own upload is run here, once loading thread queues it.
+    // Upload can't be run already, because it would have erased pending entry
+    GpuUploadId uploadId = pendingAsset.Upload.get();
+    m_UploadQueue.ProcessUpload(uploadId);
+
+    return pendingAsset.Asset.get();
+}
+
+template <typename T>
+std::shared_ptr<T> ResourceManagerImpl::UseAsset(ResidentAsset<T>& residentAsset)
+{
+    residentAsset.LastUsedFrame = m_FrameIndex;
+    return residentAsset.Asset;
+}
+
+AssetHandle<Texture2D> ResourceManagerImpl::GetTexture2DAsync(const std::string& filePath, TextureCompression compression)
+{
+    std::function<LoadedAssetData<Texture2D>(int)> loadWithDroppedMips;
+
+    if (compression != TextureCompression::None)
+    {
+        loadWithDroppedMips = MakeCompressedTextureLoader(filePath, compression, &m_LoadingThreads);
+    }
+
+    return LoadAsync<Texture2D>(filePath, m_Textures2d, m_PendingTextures2d, Renderer::GetDefaultTexture(),
+        MakeTextureLoader(filePath, compression, &m_LoadingThreads), std::move(loadWithDroppedMips));
+}
+
+AssetHandle<StaticMesh> ResourceManagerImpl::GetStaticMeshAsync(const std::string& filePath)
+{
+    return LoadAsync<StaticMesh>(filePath, m_StaticMeshes, m_PendingStaticMeshes, GetPlaceholderStaticMesh(),
+        MakeMeshLoader<StaticMesh>(filePath, GetMaterial("default")));
+}
+
+AssetHandle<SkeletalMesh> ResourceManagerImpl::GetSkeletalMeshAsync(const std::string& filePath)
+{
+    return LoadAsync<SkeletalMesh>(filePath, m_SkeletalMeshes, m_PendingSkeletalMeshes, nullptr,
+        MakeMeshLoader<SkeletalMesh>(filePath, GetMaterial("default")));
+}
+
+void ResourceManagerImpl::ProcessUploads(size_t maxBytes, milliseconds_float_t maxTime)
+{
+    m_UploadQueue.Process(maxBytes, maxTime);
+}
+
+static std::shared_ptr<StaticMesh> CreatePlaceholderCube(const std::shared_ptr<Material>& material)
+{
+    std::vector<StaticMeshVertex> vertices;
+    std::vector<uint32_t> indices;
+    const glm::vec2 corners[] = {{-1, -1}, {1, -1}, {1, 1}, {-1, 1}};
+
+    // each face has own vertices, so normals stay flat
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        for (float sign : {-1.0f, 1.0f})
+        {
+            glm::vec3 normal{0.0f};
+            normal[axis] = sign;
+
+            glm::vec3 tangent{0.0f};
+            tangent[(axis + 1) % 3] = 1.0f;
+            glm::vec3 bitangent = glm::cross(normal, tangent);
+
+            uint32_t firstVertex = static_cast<uint32_t>(vertices.size());
+
+            for (const glm::vec2& corner : corners)
+            {
+                glm::vec3 position = 0.5f * (normal + corner.x * tangent + corner.y * bitangent);
+                vertices.emplace_back(position, normal, 0.5f * (corner + 1.0f), 0);
+            }
+
+            // tangent, bitangent and normal are right handed, so corners are counter clockwise seen from outside
+            for (uint32_t index : {0, 1, 2, 0, 2, 3})
+            {
+                indices.emplace_back(firstVertex + index);
+            }
+        }
+    }
+
+    return std::make_shared<StaticMesh>(PlaceholderStaticMeshName, vertices, indices, material);
+}
+
+std::shared_ptr<StaticMesh> ResourceManagerImpl::GetPlaceholderStaticMesh()
+{
+    if (!m_PlaceholderStaticMesh)
+    {
+        m_PlaceholderStaticMesh = CreatePlaceholderCube(GetMaterial("default"));
+    }
+
+    return m_PlaceholderStaticMesh;
+}
+
 std::shared_ptr<Material> ResourceManagerImpl::GetMaterial(const std::string& materialName)
 {
     auto it = m_Materials.find(materialName);
@@ -239,8 +873,359 @@ std::shared_ptr<Material> ResourceManagerImpl::GetMaterial(const std::string& ma
 
 std::shared_ptr<Material> ResourceManagerImpl::CreateMaterial(const std::string& shaderFilePath, const std::string& materialName)
 {
-    auto shader = GetShader(shaderFilePath);
+    auto shader = GetShader(shaderFilePath, {});
     m_Materials[materialName] = std::make_shared<Material>(shader);
     return m_Materials[materialName];
 }
 
+std::shared_ptr<MaterialInstance> ResourceManagerImpl::CreateMaterialInstance(const std::string& parentMaterialName, const std::string& instanceName)
+{
+    auto instance = std::make_shared<MaterialInstance>(GetMaterial(parentMaterialName));
+    m_Materials[instanceName] = instance;
+    return instance;
+}
+
+static size_t GetNumGpuBytesUsed()
+{
+    return Texture2D::s_NumTextureVramUsed + VertexBuffer::s_NumVertexBufferMemoryAllocated +
+        static_cast<size_t>(IndexBuffer::s_IndexBufferMemoryAllocation) + UniformBuffer::s_NumBytesAllocated +
+        ShaderStorageBuffer::s_NumBytesAllocated;
+}
+
+// Shaders and textures don't keep anything on CPU after their GPU objects are created
+static size_t GetNumCpuBytes(const Shader&)
+{
+    return 0;
+}
+
+static size_t GetNumCpuBytes(const Texture2D&)
+{
+    return 0;
+}
+
+static size_t GetNumCpuBytes(const StaticMesh& mesh)
+{
+    return mesh.GetNumPendingBytes();
+}
+
+static size_t GetNumCpuBytes(const SkeletalMesh& mesh)
+{
+    return mesh.GetNumCpuBytes();
+}
+
+template <typename T>
+static size_t SumCpuBytes(const ResidentAssetMap<T>& assets)
+{
+    size_t numBytes = 0;
+
+    for (const auto& [path, residentAsset] : assets)
+    {
+        if (residentAsset.Asset)
+        {
+            numBytes += GetNumCpuBytes(*residentAsset.Asset);
+        }
+    }
+
+    return numBytes;
+}
+
+size_t ResourceManagerImpl::GetNumCpuBytesUsed() const
+{
+    return SumCpuBytes(m_Shaders) + SumCpuBytes(m_Textures2d) + SumCpuBytes(m_SkeletalMeshes) + SumCpuBytes(m_StaticMeshes);
+}
+
+void ResourceManagerImpl::SetMemoryBudget(size_t gpuBudget, size_t cpuBudget)
+{
+    m_GpuBudget = gpuBudget;
+    m_CpuBudget = cpuBudget;
+}
+
+template <typename T>
+static void MarkReferencedAssetsUsed(ResidentAssetMap<T>& assets, uint64_t frameIndex)
+{
+    for (auto& [path, residentAsset] : assets)
+    {
+        if (residentAsset.IsReferenced())
+        {
+            residentAsset.LastUsedFrame = frameIndex;
+        }
+    }
+}
+
+void ResourceManagerImpl::UpdateResidency()
+{
+    ++m_FrameIndex;
+
+    // asset is used as long as something holds it, not only when it's looked up
+    MarkReferencedAssetsUsed(m_Shaders, m_FrameIndex);
+    MarkReferencedAssetsUsed(m_Textures2d, m_FrameIndex);
+    MarkReferencedAssetsUsed(m_SkeletalMeshes, m_FrameIndex);
+    MarkReferencedAssetsUsed(m_StaticMeshes, m_FrameIndex);
+
+    // counters are updated by destructors of GPU objects and evicted asset leaves map, so both are read again after each eviction
+    while (GetNumGpuBytesUsed() > m_GpuBudget || GetNumCpuBytesUsed() > m_CpuBudget)
+    {
+        if (!EvictLeastRecentlyUsedAsset())
+        {
+            break;
+        }
+    }
+
+    if (GetNumGpuBytesUsed() > m_GpuBudget)
+    {
+        DropTextureMipsOverBudget();
+    }
+}
+
+// Asset chosen for eviction, assets used in current frame are kept, otherwise asset looked up and dropped
+// every frame would be loaded again each frame
+struct EvictionCandidate
+{
+    uint64_t LastUsedFrame{0};
+    std::string Path;
+    std::function<void()> Evict;
+};
+
+template <typename T>
+static void FindLeastRecentlyUsedAsset(ResidentAssetMap<T>& assets, EvictionCandidate& candidate)
+{
+    for (auto it = assets.begin(); it != assets.end(); ++it)
+    {
+        const ResidentAsset<T>& residentAsset = it->second;
+
+        if (residentAsset.CanBeLoadedAgain() && !residentAsset.IsReferenced() && residentAsset.LastUsedFrame < candidate.LastUsedFrame)
+        {
+            candidate.LastUsedFrame = residentAsset.LastUsedFrame;
+            candidate.Path = it->first;
+            candidate.Evict = [&assets, it]() { assets.erase(it); };
+        }
+    }
+}
+
+bool ResourceManagerImpl::EvictLeastRecentlyUsedAsset()
+{
+    EvictionCandidate candidate;
+    candidate.LastUsedFrame = m_FrameIndex;
+
+    // of equally old assets meshes are evicted first, because evicting mesh can release textures of its materials
+    FindLeastRecentlyUsedAsset(m_StaticMeshes, candidate);
+    FindLeastRecentlyUsedAsset(m_SkeletalMeshes, candidate);
+    FindLeastRecentlyUsedAsset(m_Textures2d, candidate);
+    FindLeastRecentlyUsedAsset(m_Shaders, candidate);
+
+    if (!candidate.Evict)
+    {
+        return false;
+    }
+
+    candidate.Evict();
+    ++m_NumEvictedAssets;
+    ENG_LOG_VERBOSE("Evicted {}", candidate.Path);
+
+    return true;
+}
+
+// Each mip level has quarter of bytes of level above
+static size_t EstimateBytesWithDroppedMips(const Texture2D& texture, int numDroppedMips)
+{
+    int numMipsToDrop = std::clamp(numDroppedMips - texture.GetNumDroppedMips(), 0, texture.GetNumMips() - 1);
+    return texture.GetNumBytesInVram() >> (2 * numMipsToDrop);
+}
+
+void ResourceManagerImpl::DropTextureMipsOverBudget()
+{
+    // textures with drop queued in previous frames are replaced once their reload is uploaded, so their savings are counted ahead
+    size_t numBytesUsed = GetNumGpuBytesUsed();
+    std::vector<std::pair<std::string, ResidentAsset<Texture2D>*>> candidates;
+
+    for (auto& [path, residentAsset] : m_Textures2d)
+    {
+        const Texture2D& texture = *residentAsset.Asset;
+
+        if (!residentAsset.LoadWithDroppedMips)
+        {
+            continue;
+        }
+
+        if (residentAsset.NumDroppedMips != texture.GetNumDroppedMips())
+        {
+            numBytesUsed -= std::min(numBytesUsed, texture.GetNumBytesInVram() - EstimateBytesWithDroppedMips(texture, residentAsset.NumDroppedMips));
+        }
+        else if (texture.GetNumMips() > 1)
+        {
+            candidates.emplace_back(path, &residentAsset);
+        }
+    }
+
+    std::sort(candidates.begin(), candidates.end(), [](const auto& lhs, const auto& rhs)
+    {
+        return lhs.second->Asset->GetNumBytesInVram() > rhs.second->Asset->GetNumBytesInVram();
+    });
+
+    // at most one level per texture is dropped each frame
+    for (auto& [path, residentAsset] : candidates)
+    {
+        if (numBytesUsed <= m_GpuBudget)
+        {
+            break;
+        }
+
+        const Texture2D& texture = *residentAsset->Asset;
+        residentAsset->NumDroppedMips = texture.GetNumDroppedMips() + 1;
+        numBytesUsed -= std::min(numBytesUsed, texture.GetNumBytesInVram() - EstimateBytesWithDroppedMips(texture, residentAsset->NumDroppedMips));
+
+        ENG_LOG_VERBOSE("Dropping top mip of {} to fit GPU budget", path);
+        ReloadAsset(path, *residentAsset);
+    }
+}
+
+template <typename T>
+static void CountResidentAssets(const ResidentAssetMap<T>& assets, ResourceResidencyStats& stats)
+{
+    for (const auto& [path, residentAsset] : assets)
+    {
+        ++stats.NumResidentAssets;
+
+        if (residentAsset.IsReferenced())
+        {
+            ++stats.NumReferencedAssets;
+        }
+    }
+}
+
+ResourceResidencyStats ResourceManagerImpl::GetResidencyStats() const
+{
+    ResourceResidencyStats stats;
+    stats.NumGpuBytesUsed = GetNumGpuBytesUsed();
+    stats.GpuBudget = m_GpuBudget;
+    stats.NumCpuBytesUsed = GetNumCpuBytesUsed();
+    stats.CpuBudget = m_CpuBudget;
+    stats.NumEvictedAssets = m_NumEvictedAssets;
+
+    CountResidentAssets(m_Shaders, stats);
+    CountResidentAssets(m_Textures2d, stats);
+    CountResidentAssets(m_SkeletalMeshes, stats);
+    CountResidentAssets(m_StaticMeshes, stats);
+
+    return stats;
+}
+
+void ResourceManagerImpl::WatchAssetDirectory(const std::filesystem::path& directory)
+{
+    m_FileWatchers.emplace_back(std::make_unique<FileWatcher>(directory));
+}
+
+static void ReplaceAsset(Shader& asset, Shader& reloadedAsset)
+{
+    // materials created from shader keep its reflected parameters, so shader with different ones is applied after restart
+    if (!Material::HasSameParameterLayout(asset, reloadedAsset))
+    {
+        THROW_ERROR("Material parameters of shader changed, restart is needed to apply it");
+    }
+
+    asset.Swap(reloadedAsset);
+}
+
+static void ReplaceAsset(Texture2D& asset, Texture2D& reloadedAsset)
+{
+    asset.Swap(reloadedAsset);
+}
+
+static void ReplaceAsset(StaticMesh& asset, StaticMesh& reloadedAsset)
+{
+    asset.SwapGeometry(reloadedAsset);
+}
+
+template <typename T>
+void ResourceManagerImpl::ReloadAsset(const std::string& filePath, const ResidentAsset<T>& residentAsset)
+{
+    ENG_LOG_INFO("Reloading {}", filePath);
+
+    // asset can be evicted while it's reloading, then reloaded data is dropped
+    std::weak_ptr<T> asset = residentAsset.Asset;
+
+    m_LoadingThreads.Enqueue([this, filePath, asset, load = residentAsset.GetLoadFunction()]()
+    {
+        LoadedAssetData<T> loadedData;
+
+        try
+        {
+            loadedData = load();
+        }
+        catch (const std::exception& e)
+        {
+            ENG_LOG_ERROR("Failed to reload {}: {}", filePath, e.what());
+            return;
+        }
+
+        m_UploadQueue.Enqueue([filePath, asset, create = std::move(loadedData.Create)]()
+        {
+            std::shared_ptr<T> existingAsset = asset.lock();
+
+            if (!existingAsset || !create)
+            {
+                return;
+            }
+
+            // file saved in the middle of editing may not compile, then previous version is kept
+            try
+            {
+                std::shared_ptr<T> reloadedAsset = create();
+                ReplaceAsset(*existingAsset, *reloadedAsset);
+            }
+            catch (const std::exception& e)
+            {
+                ENG_LOG_ERROR("Failed to reload {}: {}", filePath, e.what());
+            }
+        }, loadedData.NumBytes);
+    });
+}
+
+template <typename T>
+static bool IsMadeOfFile(const ResidentAsset<T>& residentAsset, const std::string& file)
+{
+    return std::find(residentAsset.SourceFiles.begin(), residentAsset.SourceFiles.end(), file) != residentAsset.SourceFiles.end();
+}
+
+template <typename T>
+void ResourceManagerImpl::ReloadAssetsUsingFile(const ResidentAssetMap<T>& assets, const std::string& changedFile)
+{
+    for (const auto& [path, residentAsset] : assets)
+    {
+        if (residentAsset.CanBeLoadedAgain() && IsMadeOfFile(residentAsset, changedFile))
+        {
+            ReloadAsset(path, residentAsset);
+        }
+    }
+}
+
+void ResourceManagerImpl::ReloadChangedAssets()
+{
+    for (const std::unique_ptr<FileWatcher>& watcher : m_FileWatchers)
+    {
+        for (const std::filesystem::path& changedPath : watcher->GetChangedFiles())
+        {
+            std::string changedFile = NormalizeAssetPath(changedPath);
+
+            std::erase_if(m_ShaderManifests, [&changedFile](const auto& manifest)
+            {
+                const std::vector<std::string>& sourceFiles = manifest.second->SourceFiles;
+                return std::find(sourceFiles.begin(), sourceFiles.end(), changedFile) != sourceFiles.end();
+            });
+
+            // only assets made of changed file are rebuilt, files nothing was loaded from are ignored
+            ReloadAssetsUsingFile(m_Shaders, changedFile);
+            ReloadAssetsUsingFile(m_Textures2d, changedFile);
+            ReloadAssetsUsingFile(m_StaticMeshes, changedFile);
+
+            for (const auto& [path, residentAsset] : m_SkeletalMeshes)
+            {
+                // components keep poses sized for skeleton of mesh, so skeletal mesh can't be swapped under them
+                if (IsMadeOfFile(residentAsset, changedFile))
+                {
+                    ENG_LOG_WARNING("Skeletal mesh {} changed, it's reloaded after restart", path);
+                }
+            }
+        }
+    }
+}
@@ -6,24 +6,88 @@
 #include "StaticMesh.hpp"
 #include "Shader.hpp"
 #include "Texture.hpp"
+#include "TextureCompression.hpp"
 #include "Material.hpp"
+#include "AssetHandle.hpp"
+#include "Duration.hpp"
 
 class ResourceManagerImpl;
+class ThreadPool;
+
+struct ResourceResidencyStats
+{
+    size_t NumGpuBytesUsed{0};
+    size_t GpuBudget{0};
+    size_t NumCpuBytesUsed{0};
+    size_t CpuBudget{0};
+
+    int NumResidentAssets{0};
+
+    // assets held by something besides resource manager, they can't be evicted
+    int NumReferencedAssets{0};
+    int NumEvictedAssets{0};
+};
 
 class ResourceManager
 {
     friend class Level;
     friend class ResourceManagerImpl;
 public:
-    static std::shared_ptr<Shader> GetShader(const std::string& filePath);
+    // Returns variant of shader compiled with keywords defined in addition to keywords listed in manifest.
+    // Keyword is either NAME or NAME=VALUE. Variants are compiled on first use
+    static std::shared_ptr<Shader> GetShader(const std::string& filePath, const std::vector<std::string>& keywords = {});
     static std::shared_ptr<Texture2D> GetTexture2D(const std::string& filePath);
     static void AddTexture2D(const std::string& path, const std::shared_ptr<Texture2D>& texture);
+
+    // Import option that packs texture into array shared with other textures of the same size, format and number
+    // of mips, so materials referencing different textures bind the same one. Arrays stay resident
+    static TextureArrayLayer GetTextureArrayLayer(const std::string& filePath, TextureCompression compression = TextureCompression::None);
     static std::shared_ptr<SkeletalMesh> GetSkeletalMesh(const std::string& filePath);
     static std::shared_ptr<StaticMesh> GetStaticMesh(const std::string& filePath);
 
+    // Async variants return handle immediately. Files are read and decoded on loading threads and GPU objects
+    // are created on main thread in ProcessUploads. Must be called from main thread. Compressed textures are encoded
+    // once and cached on disk. Compression is chosen by the first request of the path
+    static AssetHandle<Texture2D> GetTexture2DAsync(const std::string& filePath, TextureCompression compression = TextureCompression::None);
+    static AssetHandle<StaticMesh> GetStaticMeshAsync(const std::string& filePath);
+
+    // Skeletal mesh has no placeholder, so handle returns nullptr until mesh is loaded
+    static AssetHandle<SkeletalMesh> GetSkeletalMeshAsync(const std::string& filePath);
+
+    // Creates GPU objects of assets loaded in background until byte or time budget is used. Called once per frame
+    static void ProcessUploads(size_t maxBytes, milliseconds_float_t maxTime);
+
+    // Cube drawn in place of static meshes that are still loading
+    static std::shared_ptr<StaticMesh> GetPlaceholderStaticMesh();
+
+    // Returns already registered skeleton with the same hierarchy or registers passed one
+    static std::shared_ptr<Skeleton> FindOrAddSkeleton(const std::shared_ptr<Skeleton>& skeleton);
+
     static std::shared_ptr<Material> GetMaterial(const std::string& materialName);
     static std::shared_ptr<Material> CreateMaterial(const std::string& shaderFilePath, const std::string& materialName);
 
+    // Registers instance of already created material, which can be retrieved by GetMaterial
+    static std::shared_ptr<MaterialInstance> CreateMaterialInstance(const std::string& parentMaterialName, const std::string& instanceName);
+
+    // GPU usage is sum of texture and buffer allocations, CPU usage is sum of CPU data kept by resident assets. Budgets are unlimited by default
+    static void SetMemoryBudget(size_t gpuBudget, size_t cpuBudget);
+
+    // Evicts least recently used shaders, textures and meshes that nothing references until usage fits budget.
+    // Materials and textures added by AddTexture2D can't be loaded again, so they stay resident. When referenced textures
+    // loaded with compression still don't fit GPU budget, they are loaded again without their top mip. Called once per frame
+    static void UpdateResidency();
+    static ResourceResidencyStats GetResidencyStats();
+
+    // Shaders, textures and static meshes loaded from files in directory are loaded again on loading threads when
+    // their files change and swapped into existing objects, so materials and components use them without restart
+    static void WatchAssetDirectory(const std::filesystem::path& directory);
+
+    // Starts reloading assets whose files changed since last call. Called once per frame
+    static void ReloadChangedAssets();
+
+    // Threads decoding assets, other loading work should be queued here instead of starting own threads
+    static ThreadPool& GetLoadingThreadPool();
+
     static void Quit();
 
 private:
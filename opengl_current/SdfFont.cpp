@@ -0,0 +1,258 @@
+#include "SdfFont.hpp"
+#include "SpriteAtlas.hpp"
+#include "ErrorMacros.hpp"
+#include "Logging.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <optional>
+
+// imgui compiles its copy of rasterizer as static, so this file has its own
+#define STBTT_STATIC
+#define STB_TRUETYPE_IMPLEMENTATION
+#include "Imgui/imstb_truetype.h"
+
+// distance field value on glyph edge, shader treats alpha 0.5 as edge
+constexpr unsigned char SdfOnEdgeValue = 128;
+
+SdfFont::SdfFont(const std::filesystem::path& filePath, float pixelHeight, int padding, uint32_t firstCodepoint, uint32_t lastCodepoint) :
+    m_FontFile{filePath},
+    m_FontInfo{std::make_unique<stbtt_fontinfo>()},
+    m_PixelHeight{pixelHeight},
+    m_FirstCodepoint{firstCodepoint}
+{
+    ASSERT(firstCodepoint <= lastCodepoint);
+
+    if (!m_FontFile.IsOpen())
+    {
+        ENG_LOG_ERROR("Failed to open font {}", filePath.string());
+        return;
+    }
+
+    const unsigned char* fontData = reinterpret_cast<const unsigned char*>(m_FontFile.GetData().data());
+
+    if (stbtt_InitFont(m_FontInfo.get(), fontData, stbtt_GetFontOffsetForIndex(fontData, 0)) == 0)
+    {
+        ENG_LOG_ERROR("Font {} is not valid TrueType font", filePath.string());
+        return;
+    }
+
+    m_Scale = stbtt_ScaleForPixelHeight(m_FontInfo.get(), pixelHeight);
+
+    int ascent, descent, lineGap;
+    stbtt_GetFontVMetrics(m_FontInfo.get(), &ascent, &descent, &lineGap);
+    m_Ascent = ascent * m_Scale;
+    m_Descent = descent * m_Scale;
+    m_LineGap = lineGap * m_Scale;
+
+    m_Glyphs.resize(lastCodepoint - firstCodepoint + 1);
+
+    // glyphs are collected first, so page size can be estimated from their total area
+    std::vector<std::pair<uint32_t, ImageRgba>> glyphImages;
+    size_t totalArea = 0;
+
+    for (uint32_t codepoint = firstCodepoint; codepoint <= lastCodepoint; ++codepoint)
+    {
+        int glyphIndex = stbtt_FindGlyphIndex(m_FontInfo.get(), static_cast<int>(codepoint));
+
+        if (glyphIndex == 0)
+        {
+            continue;
+        }
+
+        GlyphInfo& glyph = m_Glyphs[codepoint - firstCodepoint];
+
+        int advance, leftSideBearing;
+        stbtt_GetGlyphHMetrics(m_FontInfo.get(), glyphIndex, &advance, &leftSideBearing);
+        glyph.Advance = advance * m_Scale;
+
+        int width, height, offsetX, offsetY;
+        unsigned char* distanceField = stbtt_GetGlyphSDF(m_FontInfo.get(), m_Scale, glyphIndex, padding, SdfOnEdgeValue,
+            static_cast<float>(SdfOnEdgeValue) / padding, &width, &height, &offsetX, &offsetY);
+
+        // whitespace has no outline
+        if (distanceField == nullptr)
+        {
+            continue;
+        }
+
+        // rows are flipped, so bottom of glyph is at start UV like in other sprites
+        ImageRgba image{width, height};
+        uint8_t* pixels = image.GetRawImageData();
+
+        for (int row = 0; row < height; ++row)
+        {
+            for (int column = 0; column < width; ++column)
+            {
+                uint8_t* pixel = pixels + (static_cast<size_t>(height - 1 - row) * width + column) * 4;
+                pixel[0] = pixel[1] = pixel[2] = 255;
+                pixel[3] = distanceField[row * width + column];
+            }
+        }
+
+        stbtt_FreeSDF(distanceField, nullptr);
+
+        // stb offset points to top left corner and y goes down
+        glyph.Offset = glm::vec2{offsetX, -(offsetY + height)};
+        glyph.Size = glm::vec2{width, height};
+        glyph.bHasQuad = true;
+
+        totalArea += static_cast<size_t>(width + 2) * (height + 2);
+        glyphImages.emplace_back(codepoint, std::move(image));
+    }
+
+    int pageSize = 256;
+
+    while (static_cast<size_t>(pageSize) * pageSize < totalArea * 3 / 2 && pageSize < 4096)
+    {
+        pageSize *= 2;
+    }
+
+    SpriteAtlas atlas{pageSize, 1};
+
+    for (auto& [codepoint, image] : glyphImages)
+    {
+        atlas.AddImage(std::to_string(codepoint), std::move(image));
+    }
+
+    atlas.Build();
+
+    if (atlas.GetPages().empty())
+    {
+        ENG_LOG_ERROR("Font {} has no glyphs in requested range", filePath.string());
+        return;
+    }
+
+    m_Atlas = atlas.GetPages()[0];
+
+    if (atlas.GetPages().size() > 1)
+    {
+        ENG_LOG_WARNING("Glyphs of font {} don't fit into single page, some of them won't be drawn", filePath.string());
+    }
+
+    for (uint32_t codepoint = firstCodepoint; codepoint <= lastCodepoint; ++codepoint)
+    {
+        GlyphInfo& glyph = m_Glyphs[codepoint - firstCodepoint];
+
+        if (!glyph.bHasQuad)
+        {
+            continue;
+        }
+
+        std::optional<AtlasRegion> region = atlas.FindRegion(std::to_string(codepoint));
+        glyph.bHasQuad = region.has_value() && region->Page == m_Atlas;
+
+        if (glyph.bHasQuad)
+        {
+            glyph.UvRect = glm::vec4{region->UvStart, region->UvEnd};
+        }
+    }
+}
+
+SdfFont::~SdfFont() = default;
+
+// Returns codepoint of UTF-8 sequence at start of text and moves past it. Invalid bytes are returned as they are
+static uint32_t DecodeUtf8(std::string_view text, size_t& position)
+{
+    uint32_t lead = static_cast<unsigned char>(text[position++]);
+    int numContinuationBytes = lead >= 0xF0 ? 3 : lead >= 0xE0 ? 2 : lead >= 0xC0 ? 1 : 0;
+
+    if (numContinuationBytes == 0 || position + numContinuationBytes > text.size())
+    {
+        return lead;
+    }
+
+    uint32_t codepoint = lead & (0x3F >> numContinuationBytes);
+
+    for (int i = 0; i < numContinuationBytes; ++i)
+    {
+        codepoint = (codepoint << 6) | (static_cast<unsigned char>(text[position++]) & 0x3F);
+    }
+
+    return codepoint;
+}
+
+TextLayout SdfFont::LayoutText(std::string_view text) const
+{
+    TextLayout layout;
+    layout.Atlas = m_Atlas;
+    layout.PixelHeight = m_PixelHeight;
+
+    ERR_FAIL_EXPECTED_TRUE_V_MSG(IsLoaded(), "Laying out text with font that failed to load", layout);
+
+    layout.Glyphs.reserve(text.size());
+    layout.BoundsMin = glm::vec2{std::numeric_limits<float>::max()};
+    layout.BoundsMax = glm::vec2{std::numeric_limits<float>::lowest()};
+
+    glm::vec2 pen{0, 0};
+    uint32_t previousCodepoint = 0;
+
+    for (size_t position = 0; position < text.size();)
+    {
+        uint32_t codepoint = DecodeUtf8(text, position);
+
+        if (codepoint == '\n')
+        {
+            pen = glm::vec2{0, pen.y - GetLineHeight()};
+            previousCodepoint = 0;
+            continue;
+        }
+
+        const GlyphInfo* glyph = FindGlyph(codepoint);
+
+        if (glyph == nullptr)
+        {
+            continue;
+        }
+
+        if (previousCodepoint != 0)
+        {
+            pen.x += stbtt_GetCodepointKernAdvance(m_FontInfo.get(), static_cast<int>(previousCodepoint), static_cast<int>(codepoint)) * m_Scale;
+        }
+
+        if (glyph->bHasQuad)
+        {
+            GlyphQuad& quad = layout.Glyphs.emplace_back(GlyphQuad{pen + glyph->Offset, glyph->Size, glyph->UvRect});
+            layout.BoundsMin = glm::min(layout.BoundsMin, quad.Position);
+            layout.BoundsMax = glm::max(layout.BoundsMax, quad.Position + quad.Size);
+        }
+
+        pen.x += glyph->Advance;
+        previousCodepoint = codepoint;
+    }
+
+    if (layout.Glyphs.empty())
+    {
+        layout.BoundsMin = layout.BoundsMax = glm::vec2{0, 0};
+    }
+
+    return layout;
+}
+
+const TextLayout& SdfFont::GetCachedLayout(const std::string& text)
+{
+    auto it = m_CachedLayouts.find(text);
+
+    if (it == m_CachedLayouts.end())
+    {
+        it = m_CachedLayouts.emplace(text, LayoutText(text)).first;
+    }
+
+    return it->second;
+}
+
+void SdfFont::ClearLayoutCache()
+{
+    m_CachedLayouts.clear();
+}
+
+const SdfFont::GlyphInfo* SdfFont::FindGlyph(uint32_t codepoint) const
+{
+    if (codepoint < m_FirstCodepoint || codepoint - m_FirstCodepoint >= m_Glyphs.size())
+    {
+        return nullptr;
+    }
+
+    return &m_Glyphs[codepoint - m_FirstCodepoint];
+}
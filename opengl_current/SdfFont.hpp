@@ -0,0 +1,107 @@
+#pragma once
+
+#include "Texture.hpp"
+#include "MappedFile.hpp"
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+struct stbtt_fontinfo;
+
+// Quad of single glyph in text layout. Position is bottom left corner relative to baseline of first line, y goes up
+struct GlyphQuad
+{
+    glm::vec2 Position;
+    glm::vec2 Size;
+
+    // start UV in xy, end UV in zw
+    glm::vec4 UvRect;
+};
+
+// Glyph quads of laid out string in pixels of font atlas. Renderer2D scales them to requested font size,
+// so single layout is drawn in any size
+struct TextLayout
+{
+    std::vector<GlyphQuad> Glyphs;
+    std::shared_ptr<Texture2D> Atlas;
+
+    // pixel height glyphs were rasterized with
+    float PixelHeight{0};
+    glm::vec2 BoundsMin{0, 0};
+    glm::vec2 BoundsMax{0, 0};
+};
+
+// TrueType font rasterized to signed distance field atlas. Distance to glyph edge is stored in alpha channel
+// (0.5 on the edge), so glyphs stay sharp when drawn much larger or smaller than PixelHeight
+class SdfFont
+{
+public:
+    // Rasterizes codepoints in range [firstCodepoint, lastCodepoint]. Padding is width of distance field around glyphs
+    SdfFont(const std::filesystem::path& filePath, float pixelHeight = 48.0f, int padding = 6,
+        uint32_t firstCodepoint = 32, uint32_t lastCodepoint = 126);
+    ~SdfFont();
+
+    SdfFont(const SdfFont&) = delete;
+    SdfFont& operator=(const SdfFont&) = delete;
+
+    bool IsLoaded() const
+    {
+        return m_Atlas != nullptr;
+    }
+
+    // Lays out UTF-8 text, lines are split by '\n'. Codepoints without glyph are skipped
+    TextLayout LayoutText(std::string_view text) const;
+
+    // Layout of static string is computed once, following calls only look it up
+    const TextLayout& GetCachedLayout(const std::string& text);
+    void ClearLayoutCache();
+
+    const std::shared_ptr<Texture2D>& GetAtlas() const
+    {
+        return m_Atlas;
+    }
+
+    float GetPixelHeight() const
+    {
+        return m_PixelHeight;
+    }
+
+    float GetLineHeight() const
+    {
+        return m_Ascent - m_Descent + m_LineGap;
+    }
+
+private:
+    struct GlyphInfo
+    {
+        // bottom left corner relative to pen position on baseline
+        glm::vec2 Offset{0, 0};
+        glm::vec2 Size{0, 0};
+        glm::vec4 UvRect{0, 0, 0, 0};
+        float Advance{0};
+        bool bHasQuad{false};
+    };
+
+    MappedFile m_FontFile;
+    std::unique_ptr<stbtt_fontinfo> m_FontInfo;
+    std::shared_ptr<Texture2D> m_Atlas;
+
+    float m_PixelHeight;
+    float m_Scale{0};
+    float m_Ascent{0};
+    float m_Descent{0};
+    float m_LineGap{0};
+
+    uint32_t m_FirstCodepoint;
+    std::vector<GlyphInfo> m_Glyphs;
+    std::unordered_map<std::string, TextLayout> m_CachedLayouts;
+
+private:
+    const GlyphInfo* FindGlyph(uint32_t codepoint) const;
+};
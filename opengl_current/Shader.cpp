@@ -7,9 +7,11 @@
 #include <array>
 #include <fstream>
 #include <algorithm>
+#include <cstring>
 
 #include "Logging.hpp"
 #include "Texture.hpp"
+#include "DerivedDataCache.hpp"
 
 #include <GL/glew.h>
 #include <string>
@@ -44,6 +46,33 @@ namespace
         UniformType Type;
     };
 
+    UniformType ConvertToUniformType(GLenum glType)
+    {
+        const GLTypeToUniformType GlTypesToUniformTypes[] =
+        {
+            {GL_FLOAT, UniformType::Float},
+            {GL_INT, UniformType::Int},
+            {GL_FLOAT_VEC2, UniformType::Vec2},
+            {GL_FLOAT_VEC3, UniformType::Vec3},
+            {GL_FLOAT_VEC4, UniformType::Vec4},
+            {GL_FLOAT_MAT4, UniformType::Mat4x4},
+            {GL_FLOAT_MAT3, UniformType::Mat3x3},
+            {GL_BOOL, UniformType::Boolean},
+            {GL_INT_VEC2, UniformType::Ivec2},
+            {GL_INT_VEC3, UniformType::Ivec3},
+            {GL_SAMPLER_2D, UniformType::Sampler2D},
+            {GL_SAMPLER_2D_ARRAY, UniformType::Sampler2DArray},
+        };
+
+        auto it = std::find_if(std::begin(GlTypesToUniformTypes), std::end(GlTypesToUniformTypes),
+            [glType](const GLTypeToUniformType& t)
+        {
+            return t.GlUniformType == glType;
+        });
+
+        return it != std::end(GlTypesToUniformTypes) ? it->Type : UniformType::Undefined;
+    }
+
     /* Wraps shader object with RAII object */
     struct ShaderObject
     {
@@ -140,6 +169,15 @@ namespace
         glDeleteProgram(program);
         throw ShaderProgramLinkingFailedException(log.data());
     }
+
+    // Returns -1 when resource isn't active, so setting it does nothing, like for location returned by OpenGL
+    int FindResourceSlot(std::span<const ShaderResourceSlot> slots, UniformHandle handle)
+    {
+        auto it = std::lower_bound(slots.begin(), slots.end(), handle.Hash,
+            [](const ShaderResourceSlot& slot, uint32_t hash) { return slot.Hash < hash; });
+
+        return (it != slots.end() && it->Hash == handle.Hash) ? it->Location : -1;
+    }
 }
 
 Shader::Shader(std::span<const std::string> sources)
@@ -162,45 +200,53 @@ void Shader::StopUsing() const
     glUseProgram(0);
 }
 
-void Shader::SetUniform(const char* name, int value)
+void Shader::Swap(Shader& other)
 {
-    glUniform1i(GetUniformLocation(name), value);
+    std::swap(m_ShaderProgram, other.m_ShaderProgram);
+    std::swap(m_UniformLocations, other.m_UniformLocations);
+    std::swap(m_UniformBlockIndices, other.m_UniformBlockIndices);
+    std::swap(m_StorageBlockIndices, other.m_StorageBlockIndices);
 }
 
-void Shader::SetUniform(const char* name, float value)
+void Shader::SetUniform(UniformHandle uniform, int value)
 {
-    glUniform1f(GetUniformLocation(name), value);
+    glUniform1i(GetUniformLocation(uniform), value);
 }
 
-void Shader::SetUniform(const char* name, glm::vec2 value)
+void Shader::SetUniform(UniformHandle uniform, float value)
 {
-    glUniform2fv(GetUniformLocation(name), 1, glm::value_ptr(value));
+    glUniform1f(GetUniformLocation(uniform), value);
 }
 
-void Shader::SetUniform(const char* name, const glm::vec3& value)
+void Shader::SetUniform(UniformHandle uniform, glm::vec2 value)
 {
-    glUniform3fv(GetUniformLocation(name), 1, glm::value_ptr(value));
+    glUniform2fv(GetUniformLocation(uniform), 1, glm::value_ptr(value));
 }
 
-void Shader::SetUniform(const char* name, const glm::vec4& value)
+void Shader::SetUniform(UniformHandle uniform, const glm::vec3& value)
 {
-    glUniform4fv(GetUniformLocation(name), 1, glm::value_ptr(value));
+    glUniform3fv(GetUniformLocation(uniform), 1, glm::value_ptr(value));
 }
 
-void Shader::SetUniform(const char* name, const glm::mat4& value)
+void Shader::SetUniform(UniformHandle uniform, const glm::vec4& value)
 {
-    glUniformMatrix4fv(GetUniformLocation(name), 1, GL_FALSE, glm::value_ptr(value));
+    glUniform4fv(GetUniformLocation(uniform), 1, glm::value_ptr(value));
 }
 
-void Shader::SetUniformMat4Array(const char* name, std::span<const glm::mat4> values)
+void Shader::SetUniform(UniformHandle uniform, const glm::mat4& value)
 {
-    glUniformMatrix4fv(GetUniformLocation(name),
+    glUniformMatrix4fv(GetUniformLocation(uniform), 1, GL_FALSE, glm::value_ptr(value));
+}
+
+void Shader::SetUniformMat4Array(UniformHandle uniform, std::span<const glm::mat4> values)
+{
+    glUniformMatrix4fv(GetUniformLocation(uniform),
         static_cast<GLsizei>(values.size()), GL_FALSE, glm::value_ptr(values[0]));
 }
 
-void Shader::SetUniform(const char* name, const glm::mat3& value)
+void Shader::SetUniform(UniformHandle uniform, const glm::mat3& value)
 {
-    glUniformMatrix3fv(GetUniformLocation(name), 1, GL_FALSE, glm::value_ptr(value));
+    glUniformMatrix3fv(GetUniformLocation(uniform), 1, GL_FALSE, glm::value_ptr(value));
 }
 
 std::vector<UniformInfo> Shader::GetUniformsInfo() const
@@ -219,13 +265,13 @@ std::vector<UniformInfo> Shader::GetUniformsInfo() const
     return uniformsInfo;
 }
 
-void Shader::SetSamplerUniform(const char* uniformName, const std::shared_ptr<ITexture>& textures, uint32_t startTextureUnit)
+void Shader::SetSamplerUniform(UniformHandle uniform, const std::shared_ptr<ITexture>& textures, uint32_t startTextureUnit)
 {
     ASSERT(startTextureUnit < MinTextureUnits);
-    glUniform1i(GetUniformLocation(uniformName), static_cast<GLint>(startTextureUnit));
+    glUniform1i(GetUniformLocation(uniform), static_cast<GLint>(startTextureUnit));
 }
 
-void Shader::SetSamplersUniform(const char* uniformName, std::span<const std::shared_ptr<ITexture>> textures, uint32_t startTextureUnit)
+void Shader::SetSamplersUniform(UniformHandle uniform, std::span<const std::shared_ptr<ITexture>> textures, uint32_t startTextureUnit)
 {
 
     std::array<int, MinTextureUnits> textureUnits;
@@ -236,7 +282,7 @@ void Shader::SetSamplersUniform(const char* uniformName, std::span<const std::sh
         return last++;
     });
 
-    glUniform1iv(GetUniformLocation(uniformName), static_cast<GLsizei>(textures.size()), textureUnits.data());
+    glUniform1iv(GetUniformLocation(uniform), static_cast<GLsizei>(textures.size()), textureUnits.data());
 }
 
 void Shader::BindUniformBuffer(int blockIndex, const UniformBuffer& buffer)
@@ -245,22 +291,161 @@ void Shader::BindUniformBuffer(int blockIndex, const UniformBuffer& buffer)
     glUniformBlockBinding(m_ShaderProgram, blockIndex, blockIndex);
 }
 
-int Shader::GetUniformBlockIndex(const std::string& name) const
+int Shader::GetUniformBlockIndex(UniformHandle block) const
+{
+    return FindResourceSlot(m_UniformBlockIndices, block);
+}
+
+std::optional<UniformBlockInfo> Shader::GetUniformBlockInfo(UniformHandle block) const
+{
+    int blockIndex = GetUniformBlockIndex(block);
+
+    if (blockIndex < 0)
+    {
+        return std::nullopt;
+    }
+
+    UniformBlockInfo info{blockIndex, 0, {}};
+
+    const GLenum blockProperties[] = {GL_BUFFER_DATA_SIZE, GL_NUM_ACTIVE_VARIABLES};
+    GLint blockValues[2] = {0, 0};
+    glGetProgramResourceiv(m_ShaderProgram, GL_UNIFORM_BLOCK, blockIndex, 2, blockProperties, 2, nullptr, blockValues);
+    info.NumBytes = blockValues[0];
+
+    std::vector<GLint> members(blockValues[1]);
+    const GLenum activeVariables = GL_ACTIVE_VARIABLES;
+    glGetProgramResourceiv(m_ShaderProgram, GL_UNIFORM_BLOCK, blockIndex, 1, &activeVariables,
+        static_cast<GLsizei>(members.size()), nullptr, members.data());
+
+    info.Members.reserve(members.size());
+
+    for (GLint member : members)
+    {
+        const GLenum memberProperties[] = {GL_TYPE, GL_OFFSET, GL_ARRAY_SIZE, GL_NAME_LENGTH};
+        GLint memberValues[4] = {0, 0, 0, 0};
+        glGetProgramResourceiv(m_ShaderProgram, GL_UNIFORM, member, 4, memberProperties, 4, nullptr, memberValues);
+
+        UniformType type = ConvertToUniformType(static_cast<GLenum>(memberValues[0]));
+
+        if (type == UniformType::Undefined)
+        {
+            continue;
+        }
+
+        std::string name(std::max(memberValues[3], 1), '\0');
+        GLsizei nameLength = 0;
+        glGetProgramResourceName(m_ShaderProgram, GL_UNIFORM, member, static_cast<GLsizei>(name.size()), &nameLength, name.data());
+        name.resize(nameLength);
+
+        info.Members.emplace_back(UniformInfo{type, std::move(name), -1, memberValues[2], memberValues[1]});
+    }
+
+    return info;
+}
+
+void Shader::BindShaderStorageBuffer(int blockIndex, const ShaderStorageBuffer& buffer)
+{
+    ERR_FAIL_EXPECTED_FALSE_MSG(blockIndex < 0 || static_cast<GLuint>(blockIndex) == GL_INVALID_INDEX, "Shader has no such storage block");
+
+    // buffer is bound to binding point declared by shader (layout(binding = N)), so blocks of different shaders don't need rebinding
+    auto slot = std::find_if(m_StorageBlockIndices.begin(), m_StorageBlockIndices.end(),
+        [blockIndex](const ShaderResourceSlot& storageBlock) { return storageBlock.Location == blockIndex; });
+    ERR_FAIL_EXPECTED_TRUE_MSG(slot != m_StorageBlockIndices.end(), "Shader has no such storage block");
+
+    buffer.Bind(slot->Binding);
+}
+
+int Shader::GetShaderStorageBlockIndex(UniformHandle block) const
+{
+    return FindResourceSlot(m_StorageBlockIndices, block);
+}
+
+// Increase when layout of cached program binary changes
+constexpr uint32_t ShaderBinaryVersion = 1;
+
+static DerivedDataKey MakeProgramBinaryKey(std::span<std::string_view> sources)
+{
+    // binary is valid only for driver that produced it
+    std::string keySource;
+
+    for (const GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION})
+    {
+        const GLubyte* value = glGetString(name);
+        keySource += value != nullptr ? reinterpret_cast<const char*>(value) : "";
+        keySource += '\0';
+    }
+
+    for (const std::string_view& source : sources)
+    {
+        keySource += source;
+        keySource += '\0';
+    }
+
+    return DerivedDataCache::MakeKey("ShaderProgram", ShaderBinaryVersion, sources.size(), std::as_bytes(std::span{keySource}));
+}
+
+bool Shader::TryLoadProgramBinary(const DerivedDataKey& key)
 {
-    auto it = m_UniformNameToLocation.find(name);
+    MappedFile entry = DerivedDataCache::Load(key);
+    std::span<const std::byte> payload = DerivedDataCache::GetPayload(entry);
+
+    if (payload.size() <= sizeof(uint32_t))
+    {
+        return false;
+    }
+
+    uint32_t binaryFormat;
+    std::memcpy(&binaryFormat, payload.data(), sizeof(binaryFormat));
+    std::span<const std::byte> binary = payload.subspan(sizeof(binaryFormat));
+
+    GLuint program = glCreateProgram();
+    glProgramBinary(program, binaryFormat, binary.data(), static_cast<GLsizei>(binary.size()));
 
-    if (it == m_UniformNameToLocation.end())
+    GLint bLinkedSuccesfully;
+    glGetProgramiv(program, GL_LINK_STATUS, &bLinkedSuccesfully);
+
+    if (bLinkedSuccesfully == GL_FALSE)
     {
-        GLint location = glGetUniformBlockIndex(m_ShaderProgram, name.c_str());
-        m_UniformNameToLocation[name] = location;
-        return location;
+        ENG_LOG_VERBOSE("Cached shader binary {} was rejected by driver", key.Hash);
+        glDeleteProgram(program);
+        return false;
     }
 
-    return it->second;
+    m_ShaderProgram = program;
+    return true;
+}
+
+void Shader::StoreProgramBinary(const DerivedDataKey& key) const
+{
+    GLint binaryLength = 0;
+    glGetProgramiv(m_ShaderProgram, GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+
+    if (binaryLength <= 0)
+    {
+        return;
+    }
+
+    // payload is format of binary followed by binary itself
+    std::vector<std::byte> payload(sizeof(uint32_t) + binaryLength);
+    GLenum binaryFormat = 0;
+    glGetProgramBinary(m_ShaderProgram, binaryLength, &binaryLength, &binaryFormat, payload.data() + sizeof(uint32_t));
+
+    uint32_t storedFormat = binaryFormat;
+    std::memcpy(payload.data(), &storedFormat, sizeof(storedFormat));
+    payload.resize(sizeof(uint32_t) + binaryLength);
+
+    DerivedDataCache::Store(key, payload);
 }
 
 void Shader::GenerateShaders(std::span<std::string_view> sources)
 {
+    DerivedDataKey binaryKey = MakeProgramBinaryKey(sources);
+
+    if (TryLoadProgramBinary(binaryKey))
+    {
+        return;
+    }
+
     GLenum types[ShaderIndex::Count] = {GL_VERTEX_SHADER,
         GL_FRAGMENT_SHADER, GL_GEOMETRY_SHADER, GL_TESS_CONTROL_SHADER, GL_TESS_EVALUATION_SHADER};
 
@@ -280,6 +465,7 @@ void Shader::GenerateShaders(std::span<std::string_view> sources)
         shaders[i].AttachShaderToProgram(m_ShaderProgram);
     }
 
+    glProgramParameteri(m_ShaderProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
     glLinkProgram(m_ShaderProgram);
 
     GLint bLinkedSuccesfully;
@@ -290,6 +476,8 @@ void Shader::GenerateShaders(std::span<std::string_view> sources)
     {
         ThrowLinkingError(m_ShaderProgram);
     }
+
+    StoreProgramBinary(binaryKey);
 }
 
 void Shader::GenerateShaders(std::span<const std::string> sources)
@@ -304,40 +492,85 @@ void Shader::GenerateShaders(std::span<const std::string> sources)
     }
 
     GenerateShaders(std::span<std::string_view>{srcs.begin(), index});
+    ReflectResources();
+}
+
+int Shader::GetUniformLocation(UniformHandle uniform) const
+{
+    return FindResourceSlot(m_UniformLocations, uniform);
 }
 
-int Shader::GetUniformLocation(const char* uniformName) const
+static std::vector<ShaderResourceSlot> ReflectProgramInterface(GLuint program, GLenum programInterface)
 {
-    auto it = m_UniformNameToLocation.find(uniformName);
+    GLint numResources = 0;
+    GLint maxNameLength = 0;
+    glGetProgramInterfaceiv(program, programInterface, GL_ACTIVE_RESOURCES, &numResources);
+    glGetProgramInterfaceiv(program, programInterface, GL_MAX_NAME_LENGTH, &maxNameLength);
+
+    std::vector<ShaderResourceSlot> slots;
+    slots.reserve(numResources);
+    std::vector<GLchar> name(std::max(maxNameLength, 1));
 
-    if (it == m_UniformNameToLocation.end())
+    for (GLint i = 0; i < numResources; ++i)
     {
-        GLint location = glGetUniformLocation(m_ShaderProgram, uniformName);
-        m_UniformNameToLocation[uniformName] = location;
+        GLsizei nameLength = 0;
+        glGetProgramResourceName(program, programInterface, i, maxNameLength, &nameLength, name.data());
+        std::string_view resourceName{name.data(), static_cast<size_t>(nameLength)};
+
+        GLint location = i;
+        GLint binding = -1;
+
+        if (programInterface == GL_SHADER_STORAGE_BLOCK)
+        {
+            // binding is fixed after linking, so it's read once instead of on every bind
+            const GLenum property = GL_BUFFER_BINDING;
+            glGetProgramResourceiv(program, programInterface, i, 1, &property, 1, nullptr, &binding);
+        }
+        else if (programInterface == GL_UNIFORM)
+        {
+            const GLenum property = GL_LOCATION;
+            glGetProgramResourceiv(program, programInterface, i, 1, &property, 1, nullptr, &location);
 
-        return location;
+            // members of uniform blocks have no location, they are set through buffer
+            if (location < 0)
+            {
+                continue;
+            }
+        }
+
+        slots.emplace_back(ShaderResourceSlot{UniformHandle::FromName(resourceName).Hash, location, binding});
     }
 
-    return it->second;
+    std::sort(slots.begin(), slots.end(), [](const ShaderResourceSlot& a, const ShaderResourceSlot& b) { return a.Hash < b.Hash; });
+
+    auto duplicate = std::adjacent_find(slots.begin(), slots.end(),
+        [](const ShaderResourceSlot& a, const ShaderResourceSlot& b) { return a.Hash == b.Hash; });
+
+    if (duplicate != slots.end())
+    {
+        ENG_LOG_WARNING("Two names of shader resources have the same hash {}, rename one of them", duplicate->Hash);
+    }
+
+    return slots;
+}
+
+void Shader::ReflectResources()
+{
+    m_UniformLocations = ReflectProgramInterface(m_ShaderProgram, GL_UNIFORM);
+    m_UniformBlockIndices = ReflectProgramInterface(m_ShaderProgram, GL_UNIFORM_BLOCK);
+    m_StorageBlockIndices = ReflectProgramInterface(m_ShaderProgram, GL_SHADER_STORAGE_BLOCK);
+
+    int materialBlockIndex = GetUniformBlockIndex(MaterialUniformBlock);
+
+    if (materialBlockIndex >= 0)
+    {
+        glUniformBlockBinding(m_ShaderProgram, static_cast<GLuint>(materialBlockIndex), MaterialUniformBlockBinding);
+    }
 }
 
 void Shader::AddNewUniformInfo(std::vector<UniformInfo>& outUniformsInfo, int location) const
 {
     const int MaxNameLength = 96;
-    const GLTypeToUniformType GlTypesToUniformTypes[] =
-    {
-        {GL_FLOAT, UniformType::Float},
-        {GL_INT, UniformType::Int},
-        {GL_FLOAT_VEC2, UniformType::Vec2},
-        {GL_FLOAT_VEC3, UniformType::Vec3},
-        {GL_FLOAT_VEC4, UniformType::Vec4},
-        {GL_FLOAT_MAT4, UniformType::Mat4x4},
-        {GL_FLOAT_MAT3, UniformType::Mat3x3},
-        {GL_BOOL, UniformType::Boolean},
-        {GL_INT_VEC2, UniformType::Ivec2},
-        {GL_INT_VEC3, UniformType::Ivec3},
-        {GL_SAMPLER_2D, UniformType::Sampler2D},
-    };
 
     GLchar name[MaxNameLength]; // variable name in GLSL
     GLsizei nameLength; // name length
@@ -345,15 +578,11 @@ void Shader::AddNewUniformInfo(std::vector<UniformInfo>& outUniformsInfo, int lo
     GLenum type; // type of the variable (float, vec3 or mat4, etc)
 
     glGetActiveUniform(m_ShaderProgram, static_cast<GLuint>(location), MaxNameLength, &nameLength, &size, &type, name);
-    auto it = std::find_if(std::begin(GlTypesToUniformTypes), std::end(GlTypesToUniformTypes),
-        [&](const GLTypeToUniformType& t)
-    {
-        return t.GlUniformType == type;
-    });
+    UniformType uniformType = ConvertToUniformType(type);
 
-    if (it != std::end(GlTypesToUniformTypes))
+    if (uniformType != UniformType::Undefined)
     {
-        outUniformsInfo.emplace_back(UniformInfo{it->Type, name, location, static_cast<int>(size)});
+        outUniformsInfo.emplace_back(UniformInfo{uniformType, name, location, static_cast<int>(size)});
     }
 }
 
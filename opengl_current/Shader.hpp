@@ -4,6 +4,8 @@
 
 #include <cstdint>
 #include <string>
+#include <string_view>
+#include <vector>
 #include <optional>
 
 #include <unordered_map>
@@ -15,6 +17,8 @@
 #include <array>
 
 #include "UniformBuffer.hpp"
+#include "ShaderStorageBuffer.hpp"
+#include "DerivedDataCache.hpp"
 
 enum class UniformType : uint8_t
 {
@@ -30,6 +34,7 @@ enum class UniformType : uint8_t
     Mat3x3,
     Boolean,
     Sampler2D,
+    Sampler2DArray,
 };
 
 struct UniformInfo
@@ -38,6 +43,17 @@ struct UniformInfo
     std::string Name;
     int Location;
     int ArraySize{1};
+
+    // byte offset of member of uniform block, -1 for uniforms outside blocks
+    int BlockOffset{-1};
+};
+
+// Layout of uniform block reported by driver, members are in std140 layout
+struct UniformBlockInfo
+{
+    int Index{-1};
+    int NumBytes{0};
+    std::vector<UniformInfo> Members;
 };
 
 struct ShaderCompilationFailedException : public std::runtime_error
@@ -67,6 +83,63 @@ class ITexture;
 
 static constexpr int MinTextureUnits = 32;
 
+// Identifies uniform, uniform block or shader storage block by FNV-1a hash of its name. String literals are hashed
+// at compile time, names known only at runtime are hashed once by FromName
+struct UniformHandle
+{
+    uint32_t Hash{0};
+
+    constexpr UniformHandle() = default;
+
+    consteval UniformHandle(const char* name) :
+        Hash{HashName(name)}
+    {
+    }
+
+    static constexpr UniformHandle FromName(std::string_view name)
+    {
+        UniformHandle handle;
+        handle.Hash = HashName(name);
+        return handle;
+    }
+
+    static constexpr uint32_t HashName(std::string_view name)
+    {
+        // array and its first element are the same uniform
+        if (name.ends_with("[0]"))
+        {
+            name.remove_suffix(3);
+        }
+
+        uint32_t hash = 2166136261u;
+
+        for (char character : name)
+        {
+            hash ^= static_cast<uint8_t>(character);
+            hash *= 16777619u;
+        }
+
+        return hash;
+    }
+
+    bool operator==(const UniformHandle& other) const = default;
+};
+
+// Block with scalar and vector parameters of material. Its binding point is assigned when program is linked,
+// so material binds its buffer without asking shader for index of block
+inline constexpr UniformHandle MaterialUniformBlock{"MaterialParameters"};
+inline constexpr int MaterialUniformBlockBinding = 8;
+
+// Location of uniform or index of block found by reflection when program is linked
+struct ShaderResourceSlot
+{
+    uint32_t Hash;
+    int Location;
+
+    // binding point declared by storage block, -1 for other resources
+    int Binding;
+};
+
 class Shader
 {
 public:
@@ -77,31 +150,45 @@ public:
     void Use() const;
     void StopUsing() const;
 
-    void SetUniform(const char* name, int value);
-    void SetUniform(const char* name, float value);
-    void SetUniform(const char* name, glm::vec2 value);
-    void SetUniform(const char* name, const glm::vec3& value);
-    void SetUniform(const char* name, const glm::vec4& value);
+    void SetUniform(UniformHandle uniform, int value);
+    void SetUniform(UniformHandle uniform, float value);
+    void SetUniform(UniformHandle uniform, glm::vec2 value);
+    void SetUniform(UniformHandle uniform, const glm::vec3& value);
+    void SetUniform(UniformHandle uniform, const glm::vec4& value);
 
-    void SetUniform(const char* name, const glm::mat4& value);
-    void SetUniformMat4Array(const char* name, std::span<const glm::mat4> values);
-    void SetUniform(const char* name, const glm::mat3& value);
+    void SetUniform(UniformHandle uniform, const glm::mat4& value);
+    void SetUniformMat4Array(UniformHandle uniform, std::span<const glm::mat4> values);
+    void SetUniform(UniformHandle uniform, const glm::mat3& value);
 
     std::vector<UniformInfo> GetUniformsInfo() const;
-    void SetSamplerUniform(const char* uniformName, const std::shared_ptr<ITexture>& textures, uint32_t startTextureUnit = 0);
-    void SetSamplersUniform(const char* uniformName, std::span<const std::shared_ptr<ITexture>> textures, uint32_t startTextureUnit = 0);
+    void SetSamplerUniform(UniformHandle uniform, const std::shared_ptr<ITexture>& textures, uint32_t startTextureUnit = 0);
+    void SetSamplersUniform(UniformHandle uniform, std::span<const std::shared_ptr<ITexture>> textures, uint32_t startTextureUnit = 0);
 
     void BindUniformBuffer(int blockIndex, const UniformBuffer& buffer);
-    int GetUniformBlockIndex(const std::string& name) const;
+    int GetUniformBlockIndex(UniformHandle block) const;
+
+    // Returns nullopt when shader has no such block
+    std::optional<UniformBlockInfo> GetUniformBlockInfo(UniformHandle block) const;
+
+    // Binds buffer to binding point declared by block, block index must come from GetShaderStorageBlockIndex
+    void BindShaderStorageBuffer(int blockIndex, const ShaderStorageBuffer& buffer);
+    int GetShaderStorageBlockIndex(UniformHandle block) const;
 
     uint32_t GetOpenGlIdentifier() const
     {
         return m_ShaderProgram;
     }
 
+    // Exchanges program with other shader, so recompiled shader is used by materials holding this one
+    void Swap(Shader& other);
+
 private:
     uint32_t m_ShaderProgram{0};
-    mutable std::unordered_map<std::string, int> m_UniformNameToLocation;
+
+    // sorted by hash, uniforms, uniform blocks and storage blocks have separate names
+    std::vector<ShaderResourceSlot> m_UniformLocations;
+    std::vector<ShaderResourceSlot> m_UniformBlockIndices;
+    std::vector<ShaderResourceSlot> m_StorageBlockIndices;
 
 private:
     Shader() = default;
@@ -110,7 +197,15 @@ private:
     void GenerateShaders(std::span<std::string_view> sources);
     void GenerateShaders(std::span<const std::string> sources);
 
-    int GetUniformLocation(const char* uniformName) const;
+    // Linked programs are stored in derived data cache, so shaders aren't compiled on each start.
+    // Driver rejects binaries of other driver versions, then program is compiled again
+    bool TryLoadProgramBinary(const DerivedDataKey& key);
+    void StoreProgramBinary(const DerivedDataKey& key) const;
+
+    // Queries all active uniforms and blocks once, so drawing doesn't ask driver for locations
+    void ReflectResources();
+
+    int GetUniformLocation(UniformHandle uniform) const;
     void AddNewUniformInfo(std::vector<UniformInfo>& outUniformsInfo, int location) const;
 };
 
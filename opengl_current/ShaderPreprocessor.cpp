@@ -0,0 +1,132 @@
+#include "ShaderPreprocessor.hpp"
+#include "Core.hpp"
+#include "ErrorMacros.hpp"
+
+#include <algorithm>
+#include <sstream>
+
+static constexpr std::string_view IncludeDirective = "#include";
+static constexpr std::string_view VersionDirective = "#version";
+
+static std::string_view TrimLeft(std::string_view line)
+{
+    size_t start = line.find_first_not_of(" \t");
+    return start == std::string_view::npos ? std::string_view{} : line.substr(start);
+}
+
+// Returns path between quotes of #include directive or empty string when line isn't #include directive
+static std::string_view GetIncludedPath(std::string_view line)
+{
+    line = TrimLeft(line);
+
+    if (!line.starts_with(IncludeDirective))
+    {
+        return {};
+    }
+
+    size_t pathStart = line.find('"');
+    size_t pathEnd = pathStart != std::string_view::npos ? line.find('"', pathStart + 1) : std::string_view::npos;
+
+    if (pathEnd == std::string_view::npos)
+    {
+        return {};
+    }
+
+    return line.substr(pathStart + 1, pathEnd - pathStart - 1);
+}
+
+static void ExpandFile(const std::filesystem::path& filePath, ExpandedShaderSource& expandedSource, int depth)
+{
+    constexpr int MaxIncludeDepth = 32;
+    ERR_FAIL_EXPECTED_TRUE_MSG(depth < MaxIncludeDepth, "Shader includes are nested too deep");
+
+    int fileIndex = static_cast<int>(expandedSource.Files.size());
+    expandedSource.Files.emplace_back(filePath.lexically_normal());
+
+    std::istringstream stream{LoadFileContent(filePath)};
+    std::string line;
+    int lineNumber = 0;
+
+    while (std::getline(stream, line))
+    {
+        ++lineNumber;
+        std::string_view includedPath = GetIncludedPath(line);
+
+        if (includedPath.empty())
+        {
+            expandedSource.Source += line;
+            expandedSource.Source += '\n';
+            continue;
+        }
+
+        std::filesystem::path includedFile = (filePath.parent_path() / includedPath).lexically_normal();
+
+        if (std::find(expandedSource.Files.begin(), expandedSource.Files.end(), includedFile) == expandedSource.Files.end())
+        {
+            expandedSource.Source += "#line 1 " + std::to_string(expandedSource.Files.size()) + "\n";
+            ExpandFile(includedFile, expandedSource, depth + 1);
+        }
+
+        expandedSource.Source += "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(fileIndex) + "\n";
+    }
+}
+
+ExpandedShaderSource ExpandShaderIncludes(const std::filesystem::path& filePath)
+{
+    ExpandedShaderSource expandedSource;
+    ExpandFile(filePath, expandedSource, 0);
+
+    return expandedSource;
+}
+
+std::string ApplyShaderKeywords(std::string_view source, std::span<const std::string> keywords)
+{
+    if (keywords.empty())
+    {
+        return std::string{source};
+    }
+
+    // #version must stay first directive, so defines go right after it
+    size_t versionStart = source.find(VersionDirective);
+    size_t insertPosition = 0;
+    int lineNumber = 1;
+
+    if (versionStart != std::string_view::npos)
+    {
+        size_t versionEnd = source.find('\n', versionStart);
+        insertPosition = versionEnd != std::string_view::npos ? versionEnd + 1 : source.size();
+        lineNumber = static_cast<int>(std::count(source.begin(), source.begin() + insertPosition, '\n')) + 1;
+    }
+
+    std::string defines;
+
+    for (const std::string& keyword : keywords)
+    {
+        size_t separator = keyword.find('=');
+
+        if (separator == std::string::npos)
+        {
+            defines += "#define " + keyword + " 1\n";
+        }
+        else
+        {
+            defines += "#define " + keyword.substr(0, separator) + " " + keyword.substr(separator + 1) + "\n";
+        }
+    }
+
+    // keeps line numbers in compiler errors the same as in file
+    defines += "#line " + std::to_string(lineNumber) + " 0\n";
+
+    std::string result{source};
+    result.insert(insertPosition, defines);
+
+    return result;
+}
+
+std::vector<std::string> NormalizeShaderKeywords(std::vector<std::string> keywords)
+{
+    std::sort(keywords.begin(), keywords.end());
+    keywords.erase(std::unique(keywords.begin(), keywords.end()), keywords.end());
+
+    return keywords;
+}
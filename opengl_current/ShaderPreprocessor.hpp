@@ -0,0 +1,27 @@
+#pragma once
+
+#include <filesystem>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Source of shader stage with #include directives replaced by content of included files
+struct ExpandedShaderSource
+{
+    std::string Source;
+
+    // stage file first, then included files. Index in this array is source string number in #line directives,
+    // so compiler errors point to file and line the error is in
+    std::vector<std::filesystem::path> Files;
+};
+
+// Replaces #include "file" directives with content of file, paths are relative to including file.
+// Each file is included once, so included files need no include guards. Throws when file can't be read
+ExpandedShaderSource ExpandShaderIncludes(const std::filesystem::path& filePath);
+
+// Adds #define for each keyword after #version directive. Keyword is either NAME or NAME=VALUE
+std::string ApplyShaderKeywords(std::string_view source, std::span<const std::string> keywords);
+
+// Sorts keywords and removes duplicates, so keyword order doesn't create another variant
+std::vector<std::string> NormalizeShaderKeywords(std::vector<std::string> keywords);
@@ -0,0 +1,76 @@
+#include "ShaderStorageBuffer.hpp"
+
+#include "ErrorMacros.hpp"
+
+#include <GL/glew.h>
+#include <algorithm>
+#include <utility>
+
+ShaderStorageBuffer::ShaderStorageBuffer(int maxSize) :
+    m_MaxSize(maxSize)
+{
+    glGenBuffers(1, &m_RendererId);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_RendererId);
+
+    glBufferData(GL_SHADER_STORAGE_BUFFER, maxSize, nullptr, GL_DYNAMIC_DRAW);
+    s_NumBytesAllocated += maxSize;
+}
+
+ShaderStorageBuffer::~ShaderStorageBuffer()
+{
+    glDeleteBuffers(1, &m_RendererId);
+    s_NumBytesAllocated -= m_MaxSize;
+}
+
+ShaderStorageBuffer::ShaderStorageBuffer(ShaderStorageBuffer&& other) noexcept
+{
+    *this = std::move(other);
+}
+
+ShaderStorageBuffer& ShaderStorageBuffer::operator=(ShaderStorageBuffer&& other) noexcept
+{
+    if (this != &other)
+    {
+        glDeleteBuffers(1, &m_RendererId);
+        s_NumBytesAllocated -= m_MaxSize;
+
+        m_RendererId = std::exchange(other.m_RendererId, 0);
+        m_MaxSize = std::exchange(other.m_MaxSize, 0);
+    }
+
+    return *this;
+}
+
+void ShaderStorageBuffer::UpdateBuffer(const void* data, int sizeBytes)
+{
+    UpdateBuffer(data, sizeBytes, 0);
+}
+
+void ShaderStorageBuffer::UpdateBuffer(const void* data, int sizeBytes, int offset)
+{
+    ASSERT(offset + sizeBytes <= m_MaxSize);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_RendererId);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, offset, sizeBytes, data);
+}
+
+void ShaderStorageBuffer::Reserve(int sizeBytes)
+{
+    if (sizeBytes <= m_MaxSize)
+    {
+        return;
+    }
+
+    // grow geometrically, so crowd growing each frame doesn't reallocate every time
+    int newSize = std::max(sizeBytes, m_MaxSize * 2);
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_RendererId);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, newSize, nullptr, GL_DYNAMIC_DRAW);
+
+    s_NumBytesAllocated += newSize - m_MaxSize;
+    m_MaxSize = newSize;
+}
+
+void ShaderStorageBuffer::Bind(int bindingId) const
+{
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, bindingId, m_RendererId);
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include "Core.hpp"
+
+// GPU buffer accessible from shaders as std430 buffer block. Unlike UniformBuffer it's size
+// isn't limited by GL_MAX_UNIFORM_BLOCK_SIZE, so it can hold whole bone palettes
+class ShaderStorageBuffer {
+public:
+    ShaderStorageBuffer(int maxSize);
+    ~ShaderStorageBuffer();
+
+    ShaderStorageBuffer(const ShaderStorageBuffer&) = delete;
+    ShaderStorageBuffer& operator=(const ShaderStorageBuffer&) = delete;
+
+    ShaderStorageBuffer(ShaderStorageBuffer&& other) noexcept;
+    ShaderStorageBuffer& operator=(ShaderStorageBuffer&& other) noexcept;
+
+    void UpdateBuffer(const void* data, int sizeBytes);
+    void UpdateBuffer(const void* data, int sizeBytes, int offset);
+
+    template <typename T>
+    void UpdateRange(std::span<const T> values, int startIndex)
+    {
+        UpdateBuffer(values.data(), GetTotalSizeOf(values), startIndex * sizeof(T));
+    }
+
+    // Makes sure buffer can hold at least sizeBytes. Content of buffer is discarded when it's reallocated
+    void Reserve(int sizeBytes);
+
+    void Bind(int bindingId) const;
+
+    int GetMaxSize() const
+    {
+        return m_MaxSize;
+    }
+
+    static inline size_t s_NumBytesAllocated = 0;
+
+private:
+    uint32_t m_RendererId{0};
+    int m_MaxSize{0};
+};
@@ -9,22 +9,21 @@
 #include "ResourceManager.hpp"
 #include "Logging.hpp"
 
-static void FindAabCollision(std::span<const SkeletonMeshVertex> vertices, glm::vec3& outBoxMin, glm::vec3& outBoxMax);
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
-glm::mat4 SkeletalAnimation::GetBoneTransformOrRelative(const Bone& bone, float animationTime) const
-{
-    auto it = BoneNameToTracks.find(bone.Name);
+static void FindAabCollision(std::span<const SkeletonMeshVertex> vertices, glm::vec3& outBoxMin, glm::vec3& outBoxMax);
 
-    if (it == BoneNameToTracks.end())
-    {
-        // track for this bone could not be found, so take default relative_transform_matrix
-        return bone.RelativeTransformMatrix;
-    }
+// Leaf bones which influence vertices in box smaller than this fraction of mesh size are collapsed at given lod
+static constexpr float LodBoneCollapseSizes[] = {0.0f, 0.1f, 0.25f};
+static constexpr int NumGeneratedLods = static_cast<int>(std::size(LodBoneCollapseSizes));
 
-    const BoneAnimationTrack& track = it->second;
-    glm::vec3 position = track.Interpolate<glm::vec3>(animationTime);
-    glm::quat rotation = track.Interpolate<glm::quat>(animationTime);
-    return glm::translate(position) * glm::mat4_cast(rotation);
+// Skinning kernel writes bone transforms by these indices without checking them, so they're validated once at load
+static bool AreBoneTransformIndicesValid(std::span<const int> boneTransformIndices, uint32_t numBones)
+{
+    return std::all_of(boneTransformIndices.begin(), boneTransformIndices.end(),
+        [numBones](int index) { return index >= 0 && index < static_cast<int>(numBones); });
 }
 
 bool Bone::AssignHierarchy(const aiNode* node, const std::unordered_map<std::string, BoneInfo>& bonesInfo)
@@ -44,8 +43,12 @@ bool Bone::AssignHierarchy(const aiNode* node, const std::unordered_map<std::str
         for (uint32_t i = 0; i < node->mNumChildren; i++)
         {
             Bone child;
-            child.AssignHierarchy(node->mChildren[i], bonesInfo);
-            Children.emplace_back(child);
+
+            // skip end nodes that aren't bones, otherwise they would overwrite transform 0
+            if (child.AssignHierarchy(node->mChildren[i], bonesInfo))
+            {
+                Children.emplace_back(child);
+            }
         }
 
         return true;
@@ -73,6 +76,37 @@ SkeletonMeshVertex::SkeletonMeshVertex(const glm::vec3& position, const glm::vec
 {
 }
 
+static void CollapseBoneWeights(SkeletonMeshVertex& vertex, std::span<const int> boneRemap)
+{
+    SkeletonMeshVertex collapsed = vertex;
+    std::fill(std::begin(collapsed.BoneWeights), std::end(collapsed.BoneWeights), 0.0f);
+    std::fill(std::begin(collapsed.BoneIds), std::end(collapsed.BoneIds), 0);
+
+    for (int i = 0; i < NumBonesPerVertex; ++i)
+    {
+        if (vertex.BoneWeights[i] == 0.0f)
+        {
+            continue;
+        }
+
+        // bones collapsed into the same parent merge their weights
+        int boneId = boneRemap[vertex.BoneIds[i]];
+        auto it = std::find(std::begin(collapsed.BoneIds), std::end(collapsed.BoneIds), boneId);
+        ptrdiff_t index = std::distance(std::begin(collapsed.BoneIds), it);
+
+        if (it != std::end(collapsed.BoneIds) && collapsed.BoneWeights[index] > 0.0f)
+        {
+            collapsed.BoneWeights[index] += vertex.BoneWeights[i];
+        }
+        else
+        {
+            collapsed.AddBoneData(boneId, vertex.BoneWeights[i]);
+        }
+    }
+
+    vertex = collapsed;
+}
+
 bool SkeletonMeshVertex::AddBoneData(int boneId, float weight)
 {
     // find first empty slot
@@ -90,15 +124,425 @@ bool SkeletonMeshVertex::AddBoneData(int boneId, float weight)
     return false;
 }
 
-SkeletalMesh::SkeletalMesh(const std::filesystem::path& path, const std::shared_ptr<Material>& material) :
+static std::unique_ptr<VertexArray> CreateLodVertexArray(std::span<const SkeletonMeshVertex> lodVertices, const std::shared_ptr<IndexBuffer>& indexBuffer)
+{
+    std::unique_ptr<VertexArray> vertexArray = std::make_unique<VertexArray>();
+    vertexArray->AddVertexBuffer(std::make_shared<VertexBuffer>(lodVertices.data(), GetTotalSizeOf(lodVertices)), SkeletonMeshVertex::DataFormat);
+    vertexArray->SetIndexBuffer(indexBuffer);
+
+    return vertexArray;
+}
+
+SkeletalMesh::SkeletalMesh(const std::filesystem::path& path, const std::shared_ptr<Material>& material, GpuUploadMode uploadMode) :
     MainMaterial{material},
     m_NumBones{0},
-    m_VertexArray{},
-    m_Path(path.string())
+    m_Path(path.string()),
+    m_PendingUpload{std::make_unique<SkeletalMeshPendingUpload>()}
+{
+    // full import is slow, so it's done only once and result is cooked for next runs
+    if (!LoadCooked(path))
+    {
+        Import(path);
+    }
+
+    if (uploadMode == GpuUploadMode::Immediate)
+    {
+        FinishLoading();
+    }
+}
+
+void SkeletalMesh::FinishLoading()
+{
+    ERR_FAIL_NULL_MSG(m_PendingUpload, "Skeletal mesh wasn't loaded with deferred upload or it's already uploaded");
+
+    AddDecodedTextures(m_PendingUpload->Textures, TextureNames);
+
+    // generated lods share geometry with lod 0, they differ only by bones vertices are skinned to
+    std::shared_ptr<IndexBuffer> indexBuffer = std::make_shared<IndexBuffer>(m_PendingUpload->Indices);
+
+    for (int lod = 0; lod < GetNumLods(); ++lod)
+    {
+        m_Lods[lod].LodVertexArray = CreateLodVertexArray(m_PendingUpload->LodVertices[lod], indexBuffer);
+    }
+
+    m_PendingUpload.reset();
+
+    // meshes rigged to the same hierarchy share skeleton together with it's animations
+    std::shared_ptr<Skeleton> sharedSkeleton = ResourceManager::FindOrAddSkeleton(m_Skeleton);
+
+    if (sharedSkeleton != m_Skeleton)
+    {
+        for (const std::string& animationName : m_Skeleton->GetAnimationNames())
+        {
+            if (sharedSkeleton->HasAnimation(animationName))
+            {
+                // shared skeleton keeps it's own version of animation, so bounds are calculated again for it
+                m_AnimationBounds.erase(animationName);
+                continue;
+            }
+
+            sharedSkeleton->AddAnimation(animationName, m_Skeleton->GetAnimation(animationName));
+        }
+
+        m_Skeleton = sharedSkeleton;
+    }
+
+    ENG_LOG_VERBOSE("Loaded skeletal mesh {}, skeleton has {} animations", m_Path, m_Skeleton->GetAnimationNames().size());
+
+    // precalculate bounds of animations known at this point, rest is calculated on first use
+    for (const std::string& animationName : m_Skeleton->GetAnimationNames())
+    {
+        if (!m_AnimationBounds.contains(animationName))
+        {
+            m_AnimationBounds[animationName] = CalculateAnimationBounds(animationName);
+        }
+    }
+}
+
+size_t SkeletalMesh::GetNumPendingBytes() const
+{
+    return m_PendingUpload ? m_PendingUpload->GetNumBytes() : 0;
+}
+
+size_t SkeletalMesh::GetNumCpuBytes() const
+{
+    size_t numBytes = GetNumPendingBytes() + m_BoneBounds.size() * sizeof(Box) + m_JointCollapseLods.size() * sizeof(int);
+
+    for (const SkeletalMeshLod& lod : m_Lods)
+    {
+        numBytes += lod.Joints.ParentIndices.size() * sizeof(int) + lod.Joints.RestLocalTransforms.size() * sizeof(Affine3x4) +
+            lod.Binding.BoneTransformIndices.size() * sizeof(int) + lod.Binding.BoneOffsets.size() * sizeof(Affine3x4) +
+            lod.SourceJointIndices.size() * sizeof(int);
+    }
+
+    return numBytes;
+}
+
+void SkeletalMesh::Import(const std::filesystem::path& path)
 {
     // maps bone name to boneID
     std::unordered_map<std::string, int> boneNameToIndex;
 
+    Assimp::Importer importer;
+
+    std::string filePath = path.string();
+    const aiScene* scene = importer.ReadFile(filePath, AssimpImportFlags);
+    ENG_LOG_VERBOSE("Loading {} skeletal mesh", filePath);
+    CRASH_EXPECTED_NOT_NULL(scene);
+
+    *m_PendingUpload = SkeletalMeshPendingUpload{};
+    std::vector<EmbeddedTextureData> embeddedTextures;
+
+    for (uint32_t i = 0; i < scene->mNumMaterials; ++i)
+    {
+        LoadTexturesFromMaterial(scene, i, embeddedTextures);
+    }
+
+    // packed all vertices of all meshes in aiScene
+    std::vector<SkeletonMeshVertex> vertices;
+    std::vector<uint32_t>& indices = m_PendingUpload->ImportedIndices;
+    std::unordered_map<std::string, BoneInfo> bonesInfo;
+
+    LoadGeometry(scene, boneNameToIndex, vertices, indices, bonesInfo);
+
+    // meshes may share bones, so count unique ones
+    m_NumBones = static_cast<uint32_t>(boneNameToIndex.size());
+
+    m_RootBone.AssignHierarchy(scene->mRootNode, bonesInfo);
+
+    FlatSkeleton joints;
+    SkinBinding binding;
+    FlattenSkeleton(m_RootBone, -1, joints, binding);
+    CRASH_EXPECTED_TRUE_MSG(AreBoneTransformIndicesValid(binding.BoneTransformIndices, m_NumBones), "Skeleton references bone outside of mesh bones");
+
+    // skeleton is shared with other meshes when loading finishes on main thread
+    m_Skeleton = std::make_shared<Skeleton>(std::move(joints));
+    std::vector<std::string> animationNames = m_Skeleton->LoadAnimations(scene);
+
+    // find global transform for converting from bone space back to local space
+    m_GlobalInverseTransform = glm::inverse(ToGlm(scene->mRootNode->mTransformation));
+
+    FindAabCollision(vertices, m_BoundingBox.MinBounds, m_BoundingBox.MaxBounds);
+    CalculateBoneBounds(vertices);
+    CalculateJointCollapseLods(binding);
+
+    std::vector<std::vector<SkeletonMeshVertex>>& lodVertices = m_PendingUpload->ImportedLodVertices;
+
+    for (int lod = 0; lod < NumGeneratedLods; ++lod)
+    {
+        lodVertices.emplace_back(CollapseLodVertices(lod, binding, vertices));
+        m_Lods.emplace_back(CreateLod(lod, binding));
+        ENG_LOG_VERBOSE("Skeletal mesh {} lod {} evaluates {} joints", filePath, lod, GetNumJoints(lod));
+    }
+
+    for (const std::string& animationName : animationNames)
+    {
+        m_AnimationBounds[animationName] = CalculateAnimationBounds(animationName);
+    }
+
+    // data is written in the same order as LoadCooked reads it
+    const FlatSkeleton& skeletonJoints = m_Skeleton->GetJoints();
+    BinaryWriter writer;
+    writer.Write(CookedMeshHeader::Create(CookedMeshType::Skeletal, sizeof(SkeletonMeshVertex)));
+    WriteEmbeddedTextures(writer, embeddedTextures);
+
+    writer.Write(m_NumBones);
+    writer.Write(m_GlobalInverseTransform);
+    writer.Write(m_BoundingBox);
+    writer.WriteArray(std::span<const Box>{m_BoneBounds});
+
+    writer.Write(static_cast<uint32_t>(skeletonJoints.GetNumJoints()));
+
+    for (const std::string& jointName : skeletonJoints.JointNames)
+    {
+        writer.WriteString(jointName);
+    }
+
+    writer.WriteArray(std::span<const int>{skeletonJoints.ParentIndices});
+    writer.WriteArray(std::span<const Affine3x4>{skeletonJoints.RestLocalTransforms});
+    writer.WriteArray(std::span<const int>{binding.BoneTransformIndices});
+    writer.WriteArray(std::span<const Affine3x4>{binding.BoneOffsets});
+    writer.WriteArray(std::span<const int>{m_JointCollapseLods});
+
+    writer.WriteArray(std::span<const uint32_t>{indices});
+    writer.Write(static_cast<uint32_t>(lodVertices.size()));
+
+    for (const std::vector<SkeletonMeshVertex>& meshLodVertices : lodVertices)
+    {
+        writer.WriteArray(std::span<const SkeletonMeshVertex>{meshLodVertices});
+    }
+
+    writer.Write(static_cast<uint32_t>(animationNames.size()));
+
+    for (const std::string& animationName : animationNames)
+    {
+        const SkeletalAnimation& animation = m_Skeleton->GetAnimation(animationName);
+
+        writer.WriteString(animationName);
+        writer.Write(animation.Duration);
+        writer.Write(animation.TicksPerSecond);
+        writer.Write(m_AnimationBounds[animationName]);
+
+        for (const BoneAnimationTrack& track : animation.JointTracks)
+        {
+            writer.WriteArray(track.GetPositionKeys());
+            writer.WriteArray(track.GetRotationKeys());
+        }
+    }
+
+    if (std::optional<DerivedDataKey> key = MakeCookedMeshKey(path, CookedMeshType::Skeletal))
+    {
+        DerivedDataCache::Store(*key, writer.GetData());
+    }
+
+    m_PendingUpload->LodVertices.assign(lodVertices.begin(), lodVertices.end());
+    m_PendingUpload->Indices = indices;
+}
+
+// Rebuilds bone tree used by recursive animation path from flattened skeleton
+static void BuildBoneHierarchy(Bone& bone, int joint, const FlatSkeleton& joints, std::span<const int> boneTransformIndices,
+    std::span<const Affine3x4> boneOffsets)
+{
+    bone.Name = joints.JointNames[joint];
+    bone.JointIndex = joint;
+    bone.BoneTransformIndex = boneTransformIndices[joint];
+    bone.RelativeTransformMatrix = joints.RestLocalTransforms[joint].ToMat4();
+    bone.BoneOffset = boneOffsets[joint].ToMat4();
+
+    // children are after parent, so visiting them in order keeps the same depth first numbering
+    for (int child = joint + 1; child < joints.GetNumJoints(); ++child)
+    {
+        if (joints.ParentIndices[child] == joint)
+        {
+            BuildBoneHierarchy(bone.Children.emplace_back(), child, joints, boneTransformIndices, boneOffsets);
+        }
+    }
+}
+
+bool SkeletalMesh::LoadCooked(const std::filesystem::path& path)
+{
+    std::optional<DerivedDataKey> key = MakeCookedMeshKey(path, CookedMeshType::Skeletal);
+
+    if (!key)
+    {
+        return false;
+    }
+
+    MappedFile cookedFile = DerivedDataCache::Load(*key);
+
+    if (!cookedFile.IsOpen())
+    {
+        return false;
+    }
+
+    BinaryReader reader{DerivedDataCache::GetPayload(cookedFile)};
+    CookedMeshHeader header = reader.Read<CookedMeshHeader>();
+
+    if (!header.IsValid(CookedMeshHeader::Create(CookedMeshType::Skeletal, sizeof(SkeletonMeshVertex))))
+    {
+        ENG_LOG_INFO("Cooked mesh of {} has different layout", path.string());
+        return false;
+    }
+
+    std::vector<DecodedTexture> textures;
+    ReadEmbeddedTextures(reader, textures);
+
+    uint32_t numBones = reader.Read<uint32_t>();
+    glm::mat4 globalInverseTransform = reader.Read<glm::mat4>();
+    Box boundingBox = reader.Read<Box>();
+    std::span<const Box> boneBounds = reader.ReadArray<Box>();
+
+    FlatSkeleton joints;
+    uint32_t numJoints = reader.Read<uint32_t>();
+
+    for (uint32_t i = 0; i < numJoints && !reader.HasFailed(); ++i)
+    {
+        joints.JointNames.emplace_back(reader.ReadString());
+    }
+
+    std::span<const int> parentIndices = reader.ReadArray<int>();
+    std::span<const Affine3x4> restLocalTransforms = reader.ReadArray<Affine3x4>();
+    joints.ParentIndices.assign(parentIndices.begin(), parentIndices.end());
+    joints.RestLocalTransforms.assign(restLocalTransforms.begin(), restLocalTransforms.end());
+
+    std::span<const int> boneTransformIndices = reader.ReadArray<int>();
+    std::span<const Affine3x4> boneOffsets = reader.ReadArray<Affine3x4>();
+    std::span<const int> jointCollapseLods = reader.ReadArray<int>();
+
+    std::span<const uint32_t> indices = reader.ReadArray<uint32_t>();
+    uint32_t numLods = reader.Read<uint32_t>();
+    std::vector<std::span<const SkeletonMeshVertex>> lodVertices;
+
+    for (uint32_t i = 0; i < numLods && !reader.HasFailed(); ++i)
+    {
+        lodVertices.emplace_back(reader.ReadArray<SkeletonMeshVertex>());
+    }
+
+    uint32_t numAnimations = reader.Read<uint32_t>();
+    std::vector<std::pair<std::string, SkeletalAnimation>> animations;
+    std::vector<Box> animationBounds;
+
+    for (uint32_t i = 0; i < numAnimations && !reader.HasFailed(); ++i)
+    {
+        auto& [name, animation] = animations.emplace_back();
+        name = reader.ReadString();
+        animation.Duration = reader.Read<float>();
+        animation.TicksPerSecond = reader.Read<float>();
+        animationBounds.emplace_back(reader.Read<Box>());
+        animation.JointTracks.resize(numJoints);
+
+        for (BoneAnimationTrack& track : animation.JointTracks)
+        {
+            std::span<const VectorProperty> positionKeys = reader.ReadArray<VectorProperty>();
+            std::span<const QuatProperty> rotationKeys = reader.ReadArray<QuatProperty>();
+            track.SetKeys(positionKeys, rotationKeys);
+        }
+    }
+
+    bool bValid = !reader.HasFailed() && numJoints > 0 && numLods > 0 && numLods <= NumGeneratedLods && boneBounds.size() == numBones &&
+        parentIndices.size() == numJoints && restLocalTransforms.size() == numJoints && boneTransformIndices.size() == numJoints &&
+        boneOffsets.size() == numJoints && jointCollapseLods.size() == numJoints && AreBoneTransformIndicesValid(boneTransformIndices, numBones);
+
+    for (uint32_t joint = 0; bValid && joint < numJoints; ++joint)
+    {
+        bValid = parentIndices[joint] < static_cast<int>(joint) && (parentIndices[joint] >= 0 || joint == 0);
+    }
+
+    // root is never collapsed, otherwise finding kept ancestor would walk past it
+    bValid = bValid && jointCollapseLods[0] >= NumGeneratedLods &&
+        std::all_of(jointCollapseLods.begin(), jointCollapseLods.end(), [](int lod) { return lod > 0; });
+
+    // lods share index buffer, so indices must point into vertices of each of them
+    if (bValid)
+    {
+        size_t minNumVertices = std::min_element(lodVertices.begin(), lodVertices.end(),
+            [](const auto& a, const auto& b) { return a.size() < b.size(); })->size();
+        bValid = std::all_of(indices.begin(), indices.end(), [minNumVertices](uint32_t index) { return index < minNumVertices; });
+    }
+
+    if (!bValid)
+    {
+        ENG_LOG_WARNING("Cooked mesh of {} is corrupted", path.string());
+        return false;
+    }
+
+    // file is valid, so mesh can be filled without leaving it half loaded
+    m_NumBones = numBones;
+    m_GlobalInverseTransform = globalInverseTransform;
+    m_BoundingBox = boundingBox;
+    m_BoneBounds.assign(boneBounds.begin(), boneBounds.end());
+    m_JointCollapseLods.assign(jointCollapseLods.begin(), jointCollapseLods.end());
+
+    BuildBoneHierarchy(m_RootBone, 0, joints, boneTransformIndices, boneOffsets);
+    m_Skeleton = std::make_shared<Skeleton>(std::move(joints));
+
+    for (size_t i = 0; i < animations.size(); ++i)
+    {
+        auto& [name, animation] = animations[i];
+        m_AnimationBounds[name] = animationBounds[i];
+        m_Skeleton->AddAnimation(name, std::move(animation));
+    }
+
+    SkinBinding binding{std::vector<int>(boneTransformIndices.begin(), boneTransformIndices.end()),
+        std::vector<Affine3x4>(boneOffsets.begin(), boneOffsets.end())};
+
+    for (int lod = 0; lod < GetContainerSizeInt(lodVertices); ++lod)
+    {
+        m_Lods.emplace_back(CreateLod(lod, binding));
+    }
+
+    // vertices are uploaded straight from mapped file, so it's kept open until then
+    m_PendingUpload->Textures = std::move(textures);
+    m_PendingUpload->LodVertices = std::move(lodVertices);
+    m_PendingUpload->Indices = indices;
+    m_PendingUpload->CookedFile = std::move(cookedFile);
+
+    return true;
+}
+
+void SkeletalMesh::LoadLod(const std::filesystem::path& path, int lod)
+{
+    ERR_FAIL_EXPECTED_TRUE_MSG(lod > 0 && lod <= GetNumLods(), "Lod 0 is loaded together with skeletal mesh, other lods must be loaded in order");
+
+    Assimp::Importer importer;
+    const aiScene* scene = importer.ReadFile(path.string(), AssimpImportFlags);
+    ERR_FAIL_NULL_MSG(scene, "Failed to load skeletal mesh lod");
+
+    // lod must use bone ids of lod 0, so vertices are skinned by the same bone transforms
+    const SkeletalMeshLod& baseLod = m_Lods[0];
+    std::unordered_map<std::string, int> boneNameToIndex;
+
+    for (int joint = 0; joint < baseLod.Joints.GetNumJoints(); ++joint)
+    {
+        boneNameToIndex[baseLod.Joints.JointNames[joint]] = baseLod.Binding.BoneTransformIndices[joint];
+    }
+
+    std::vector<SkeletonMeshVertex> vertices;
+    std::vector<uint32_t> indices;
+    std::unordered_map<std::string, BoneInfo> bonesInfo;
+
+    LoadGeometry(scene, boneNameToIndex, vertices, indices, bonesInfo);
+    ERR_FAIL_EXPECTED_TRUE_MSG(boneNameToIndex.size() == m_NumBones, "Skeletal mesh lod uses bones that aren't part of skeleton");
+
+    std::vector<SkeletonMeshVertex> lodVertices = CollapseLodVertices(lod, baseLod.Binding, vertices);
+    SkeletalMeshLod loadedLod = CreateLod(lod, baseLod.Binding);
+    loadedLod.LodVertexArray = CreateLodVertexArray(lodVertices, std::make_shared<IndexBuffer>(indices));
+
+    if (lod == GetNumLods())
+    {
+        m_Lods.emplace_back(std::move(loadedLod));
+    }
+    else
+    {
+        m_Lods[lod] = std::move(loadedLod);
+    }
+
+    ENG_LOG_VERBOSE("Loaded skeletal mesh {} with lod={}", path.string(), lod);
+}
+
+void SkeletalMesh::LoadGeometry(const aiScene* scene, std::unordered_map<std::string, int>& boneNameToIndex, std::vector<SkeletonMeshVertex>& outVertices,
+    std::vector<uint32_t>& outIndices, std::unordered_map<std::string, BoneInfo>& outBonesInfo)
+{
     auto getBoneId = [&boneNameToIndex](const aiBone* bone)
     {
         int boneId = 0;
@@ -124,28 +568,10 @@ SkeletalMesh::SkeletalMesh(const std::filesystem::path& path, const std::shared_
     int totalVertices = 0;
     int totalIndices = 0;
 
-    Assimp::Importer importer;
-
-    std::string filePath = path.string();
-    const aiScene* scene = importer.ReadFile(filePath, AssimpImportFlags);
-    ENG_LOG_VERBOSE("Loading {} skeletal mesh", filePath);
-    CRASH_EXPECTED_NOT_NULL(scene);
-
     // used for reserve enough indices to decrease allocating overhead
     int startNumIndices = scene->mMeshes[0]->mNumFaces * 3;
-
-    // packed all vertices of all meshes in aiScene
-    std::vector<SkeletonMeshVertex> vertices;
-    std::vector<uint32_t> indices;
-    vertices.reserve(scene->mMeshes[0]->mNumVertices);
-    indices.reserve(startNumIndices);
-
-    for (uint32_t i = 0; i < scene->mNumMaterials; ++i)
-    {
-        LoadTexturesFromMaterial(scene, i);
-    }
-
-    std::unordered_map<std::string, BoneInfo> bonesInfo;
+    outVertices.reserve(scene->mMeshes[0]->mNumVertices);
+    outIndices.reserve(startNumIndices);
 
     for (uint32_t i = 0; i < scene->mNumMeshes; ++i)
     {
@@ -157,8 +583,8 @@ SkeletalMesh::SkeletalMesh(const std::filesystem::path& path, const std::shared_
             const aiVector3D& normal = mesh->mNormals[j];
             const aiVector3D& textureCoords = mesh->mTextureCoords[0][j];
 
-            vertices.emplace_back(ToGlm(pos), ToGlm(normal), ToGlm(textureCoords));
-            vertices.back().TextureId = mesh->mMaterialIndex;
+            outVertices.emplace_back(ToGlm(pos), ToGlm(normal), ToGlm(textureCoords));
+            outVertices.back().TextureId = mesh->mMaterialIndex;
         }
 
         for (uint32_t j = 0; j < mesh->mNumFaces; ++j)
@@ -168,7 +594,7 @@ SkeletalMesh::SkeletalMesh(const std::filesystem::path& path, const std::shared_
 
             for (uint32_t k = 0; k < face.mNumIndices; ++k)
             {
-                indices.emplace_back(face.mIndices[k] + totalIndices);
+                outIndices.emplace_back(face.mIndices[k] + totalVertices);
             }
         }
 
@@ -178,8 +604,7 @@ SkeletalMesh::SkeletalMesh(const std::filesystem::path& path, const std::shared_
             int boneId = getBoneId(bone);
 
             glm::mat4 offsetMatrix = ToGlm(bone->mOffsetMatrix);
-            bonesInfo[bone->mName.C_Str()] = BoneInfo{static_cast<int>(bone_index), offsetMatrix};
-            std::string s{bone->mName.C_Str()};
+            outBonesInfo[bone->mName.C_Str()] = BoneInfo{boneId, offsetMatrix};
 
             for (uint32_t j = 0; j < bone->mNumWeights; j++)
             {
@@ -187,7 +612,7 @@ SkeletalMesh::SkeletalMesh(const std::filesystem::path& path, const std::shared_
                 uint32_t id = bone->mWeights[j].mVertexId + totalVertices;
                 float weight = bone->mWeights[j].mWeight;
 
-                if (!vertices[id].AddBoneData(boneId, weight))
+                if (!outVertices[id].AddBoneData(boneId, weight))
                 {
                     break;
                 }
@@ -196,109 +621,268 @@ SkeletalMesh::SkeletalMesh(const std::filesystem::path& path, const std::shared_
 
         totalVertices += mesh->mNumVertices;
         totalIndices += mesh->mNumFaces * 3;
-        m_NumBones += mesh->mNumBones;
     }
+}
+
+std::vector<std::string> SkeletalMesh::GetAnimationNames() const
+{
+    return m_Skeleton->GetAnimationNames();
+}
+
+float SkeletalMesh::GetAnimationDuration(const std::string& animationName) const
+{
+    const SkeletalAnimation& animation = m_Skeleton->GetAnimation(animationName);
+    return animation.Duration / animation.TicksPerSecond;
+}
+
+void SkeletalMesh::GetAnimationFrames(const AnimationUpdateArgs& updateArgs) const
+{
+    ASSERT(updateArgs.Transforms.size() >= m_NumBones);
+    UpdateAnimation(updateArgs);
+}
+
+PoseEvaluationJob SkeletalMesh::CreatePoseEvaluationJob(const AnimationUpdateArgs& updateArgs) const
+{
+    ASSERT(updateArgs.Transforms.size() >= m_NumBones);
+    const SkeletalAnimation& animation = m_Skeleton->GetAnimation(updateArgs.AnimationName);
+    const SkeletalMeshLod& lod = m_Lods[ClampLod(updateArgs.Lod)];
+
+    return PoseEvaluationJob{&lod.Joints, &lod.Binding, animation.JointTracks, lod.SourceJointIndices,
+        GetAnimationTimeInTicks(animation, updateArgs.ElapsedTime), updateArgs.Transforms};
+}
+
+void SkeletalMesh::UpdateAnimation(const AnimationUpdateArgs& updateArgs) const
+{
+    const SkeletalAnimation& animation = m_Skeleton->GetAnimation(updateArgs.AnimationName);
+    float animationTime = GetAnimationTimeInTicks(animation, updateArgs.ElapsedTime);
 
-    for (uint32_t i = 0; i < scene->mNumAnimations; ++i)
+    if (s_bUseAnimationKernels)
     {
-        LoadAnimation(scene, i);
+        // animations are updated from worker threads, each needs own scratch buffers
+        thread_local SkeletonPoseEvaluator evaluator;
+        evaluator.Evaluate(CreatePoseEvaluationJob(updateArgs));
+        return;
     }
 
-    // define Tpose animation dummy values
-    m_Animations[DefaultAnimationName] = SkeletalAnimation{};
-    m_Animations[DefaultAnimationName].TicksPerSecond = 30;
-    m_Animations[DefaultAnimationName].Duration = 10;
+    // run transform update chain starting from root joint
+    CalculateTransform(BoneAnimationUpdateArgs{&animation, animationTime, &m_RootBone, updateArgs.Transforms, glm::mat4{1.0f}, ClampLod(updateArgs.Lod)});
+}
 
-    ENG_LOG_VERBOSE("Loaded skeletal mesh {0}, got anims: ", filePath);
+Box SkeletalMesh::GetAnimationBounds(const std::string& animationName) const
+{
+    std::lock_guard lock{m_AnimationBoundsMutex};
+    auto it = m_AnimationBounds.find(animationName);
 
-    for (auto& [name, animation] : m_Animations)
+    if (it == m_AnimationBounds.end())
     {
-        ENG_LOG_VERBOSE("Animation {} [Duration: {}, TicksPerSecond: {}, NumTracks: {}]", name.c_str(), animation.Duration, animation.TicksPerSecond,
-            (int)animation.BoneNameToTracks.size());
+        it = m_AnimationBounds.try_emplace(animationName, CalculateAnimationBounds(animationName)).first;
     }
 
-    m_RootBone.AssignHierarchy(scene->mRootNode, bonesInfo);
-    m_VertexArray.AddVertexBuffer(std::make_shared<VertexBuffer>(vertices.data(), static_cast<int>(vertices.size() * sizeof(SkeletonMeshVertex))), SkeletonMeshVertex::DataFormat);
-    m_VertexArray.SetIndexBuffer(std::make_shared<IndexBuffer>(indices));
-
-    // find global transform for converting from bone space back to local space
-    m_GlobalInverseTransform = glm::inverse(ToGlm(scene->mRootNode->mTransformation));
+    return it->second;
+}
 
-    FindAabCollision(vertices, m_BoundingBox.MinBounds, m_BoundingBox.MaxBounds);
-    m_BoundingBox.MinBounds *= 0.01f;
-    m_BoundingBox.MaxBounds *= 0.01f;
+void SkeletalMesh::CalculateBoneBounds(std::span<const SkeletonMeshVertex> vertices)
+{
+    Box emptyBox{glm::vec3{std::numeric_limits<float>::max()}, glm::vec3{std::numeric_limits<float>::lowest()}};
+    m_BoneBounds.assign(m_NumBones, emptyBox);
 
-    m_BoundingBox.MinBounds.x *= 0.2f;
-    m_BoundingBox.MaxBounds.x *= 0.2f;
+    for (const SkeletonMeshVertex& vertex : vertices)
+    {
+        for (int i = 0; i < NumBonesPerVertex; ++i)
+        {
+            if (vertex.BoneWeights[i] > 0.0f)
+            {
+                m_BoneBounds[vertex.BoneIds[i]].Encapsulate(Box{vertex.Position, vertex.Position});
+            }
+        }
+    }
 }
 
-void SkeletalMesh::LoadAnimation(const aiScene* scene, int animationIndex)
+Box SkeletalMesh::CalculateAnimationBounds(const std::string& animationName) const
 {
-    const aiAnimation* anim = scene->mAnimations[animationIndex];
-    SkeletalAnimation animation{};
+    constexpr int MaxNumSamples = 120;
+
+    const SkeletalAnimation& animation = m_Skeleton->GetAnimation(animationName);
+    std::vector<glm::mat4> transforms(m_NumBones, glm::mat4{1.0f});
+
+    // sample each tick of animation (limited for very long animations)
+    int numSamples = std::clamp(static_cast<int>(std::ceil(animation.Duration)), 1, MaxNumSamples);
+    float tickStep = animation.Duration / numSamples;
 
-    if (anim->mTicksPerSecond != 0.0f)
+    Box bounds{glm::vec3{std::numeric_limits<float>::max()}, glm::vec3{std::numeric_limits<float>::lowest()}};
+    bool bAnyBoneBounds = false;
+
+    for (int sample = 0; sample < numSamples; ++sample)
     {
-        animation.TicksPerSecond = static_cast<float>(anim->mTicksPerSecond);
+        float elapsedTime = sample * tickStep / animation.TicksPerSecond;
+        UpdateAnimation(AnimationUpdateArgs{elapsedTime, animationName, transforms});
+
+        // skinned vertex is blend of vertex transformed by it's bones, so it lies inside union of transformed bone bounds
+        for (uint32_t bone = 0; bone < m_NumBones; ++bone)
+        {
+            const Box& boneBounds = m_BoneBounds[bone];
+
+            if (boneBounds.MinBounds.x > boneBounds.MaxBounds.x)
+            {
+                // bone doesn't influence any vertex
+                continue;
+            }
+
+            bounds.Encapsulate(boneBounds.TransformedBy(transforms[bone]));
+            bAnyBoneBounds = true;
+        }
     }
-    else
+
+    return bAnyBoneBounds ? bounds : m_BoundingBox;
+}
+
+float SkeletalMesh::GetAnimationTimeInTicks(const SkeletalAnimation& animation, float elapsedTime) const
+{
+    float timeInTicks = elapsedTime * animation.TicksPerSecond;
+    return fmod(timeInTicks, animation.Duration);
+}
+
+void SkeletalMesh::FlattenSkeleton(Bone& bone, int parentIndex, FlatSkeleton& outJoints, SkinBinding& outBinding)
+{
+    int jointIndex = outJoints.GetNumJoints();
+    bone.JointIndex = jointIndex;
+
+    outJoints.JointNames.emplace_back(bone.Name);
+    outJoints.ParentIndices.emplace_back(parentIndex);
+    outJoints.RestLocalTransforms.emplace_back(Affine3x4::FromMat4(bone.RelativeTransformMatrix));
+
+    outBinding.BoneTransformIndices.emplace_back(bone.BoneTransformIndex);
+    outBinding.BoneOffsets.emplace_back(Affine3x4::FromMat4(bone.BoneOffset));
+
+    // depth first order keeps parent before it's children
+    for (Bone& child : bone.Children)
     {
-        animation.TicksPerSecond = 1.0f;
+        FlattenSkeleton(child, jointIndex, outJoints, outBinding);
     }
+}
+
+void SkeletalMesh::CalculateJointCollapseLods(const SkinBinding& binding)
+{
+    const FlatSkeleton& joints = m_Skeleton->GetJoints();
+    int numJoints = joints.GetNumJoints();
+    float meshSize = glm::length(m_BoundingBox.MaxBounds - m_BoundingBox.MinBounds);
 
-    animation.Duration = static_cast<float>(anim->mDuration);
+    m_JointCollapseLods.assign(numJoints, std::numeric_limits<int>::max());
 
-    for (uint32_t i = 0; i < anim->mNumChannels; i++)
+    auto getBoneSize = [this, &binding](int joint)
     {
-        const aiNodeAnim* channel = anim->mChannels[i];
-        BoneAnimationTrack track;
+        const Box& bounds = m_BoneBounds[binding.BoneTransformIndices[joint]];
+        return bounds.MinBounds.x > bounds.MaxBounds.x ? 0.0f : glm::length(bounds.MaxBounds - bounds.MinBounds);
+    };
 
-        for (uint32_t j = 0; j < channel->mNumPositionKeys; j++)
-        {
-            track.AddNewPositionTimestamp(ToGlm(channel->mPositionKeys[j].mValue),
-                static_cast<float>(channel->mPositionKeys[j].mTime));
-        }
-        for (uint32_t j = 0; j < channel->mNumRotationKeys; j++)
+    for (int lod = 1; lod < NumGeneratedLods; ++lod)
+    {
+        float maxCollapsedSize = meshSize * LodBoneCollapseSizes[lod];
+        std::vector<int> numKeptChildren(numJoints, 0);
+
+        // children are placed after parents, so going backwards visits whole subtree before joint itself.
+        // This way chains of small bones (like fingers) collapse up to the first bigger bone
+        for (int joint = numJoints - 1; joint >= 0; --joint)
         {
-            track.AddNewRotationTimestamp(ToGlm(channel->mRotationKeys[j].mValue),
-                static_cast<float>(channel->mRotationKeys[j].mTime));
+            int parent = joints.ParentIndices[joint];
+
+            if (parent < 0)
+            {
+                continue;
+            }
+
+            bool bCollapsed = m_JointCollapseLods[joint] <= lod;
+
+            if (!bCollapsed && numKeptChildren[joint] == 0 && getBoneSize(joint) <= maxCollapsedSize)
+            {
+                m_JointCollapseLods[joint] = lod;
+                bCollapsed = true;
+            }
+
+            if (!bCollapsed)
+            {
+                numKeptChildren[parent]++;
+            }
         }
+    }
+}
 
-        // skip scale tracks, as it's not common to use scaling tracks of bones
+int SkeletalMesh::FindKeptJoint(int joint, int lod) const
+{
+    const FlatSkeleton& joints = m_Skeleton->GetJoints();
 
-        std::string name = channel->mNodeName.C_Str();
-        animation.BoneNameToTracks[name] = track;
+    // collapsed joint is replaced by the nearest ancestor that is kept at this lod
+    while (m_JointCollapseLods[joint] <= lod)
+    {
+        joint = joints.ParentIndices[joint];
     }
 
-    std::string animationName = anim->mName.C_Str();
-    animationName = SplitString(animationName, "|").back();
-    m_Animations[animationName] = animation;
+    return joint;
 }
 
-std::vector<std::string> SkeletalMesh::GetAnimationNames() const
+std::vector<SkeletonMeshVertex> SkeletalMesh::CollapseLodVertices(int lod, const SkinBinding& binding, std::span<const SkeletonMeshVertex> vertices) const
 {
-    std::vector<std::string> names;
+    std::vector<SkeletonMeshVertex> lodVertices(vertices.begin(), vertices.end());
+
+    if (lod == 0)
+    {
+        return lodVertices;
+    }
+
+    std::vector<int> boneRemap(m_NumBones);
+
+    for (uint32_t bone = 0; bone < m_NumBones; ++bone)
+    {
+        boneRemap[bone] = static_cast<int>(bone);
+    }
 
-    names.reserve(m_Animations.size());
+    for (int joint = 0; joint < GetContainerSizeInt(binding.BoneTransformIndices); ++joint)
+    {
+        boneRemap[binding.BoneTransformIndices[joint]] = binding.BoneTransformIndices[FindKeptJoint(joint, lod)];
+    }
 
-    for (auto& [name, animation] : m_Animations)
+    for (SkeletonMeshVertex& vertex : lodVertices)
     {
-        names.emplace_back(name);
+        CollapseBoneWeights(vertex, boneRemap);
     }
 
-    return names;
+    return lodVertices;
 }
 
-void SkeletalMesh::GetAnimationFrames(const AnimationUpdateArgs& updateArgs) const
+SkeletalMeshLod SkeletalMesh::CreateLod(int lod, const SkinBinding& binding) const
 {
-    ASSERT(updateArgs.Transforms.size() >= m_NumBones);
-    UpdateAnimation(updateArgs);
+    const FlatSkeleton& joints = m_Skeleton->GetJoints();
+    int numJoints = joints.GetNumJoints();
+
+    SkeletalMeshLod meshLod;
+    std::vector<int> lodJointIndices(numJoints, -1);
+
+    for (int joint = 0; joint < numJoints; ++joint)
+    {
+        if (FindKeptJoint(joint, lod) != joint)
+        {
+            continue;
+        }
+
+        // parent is always kept when child is, so it already has index in lod
+        int parent = joints.ParentIndices[joint];
+        lodJointIndices[joint] = meshLod.Joints.GetNumJoints();
+
+        meshLod.Joints.JointNames.emplace_back(joints.JointNames[joint]);
+        meshLod.Joints.ParentIndices.emplace_back(parent < 0 ? -1 : lodJointIndices[parent]);
+        meshLod.Joints.RestLocalTransforms.emplace_back(joints.RestLocalTransforms[joint]);
+        meshLod.Binding.BoneTransformIndices.emplace_back(binding.BoneTransformIndices[joint]);
+        meshLod.Binding.BoneOffsets.emplace_back(binding.BoneOffsets[joint]);
+        meshLod.SourceJointIndices.emplace_back(joint);
+    }
+
+    return meshLod;
 }
 
 void SkeletalMesh::CalculateTransform(const BoneAnimationUpdateArgs& updateArgs) const
 {
     const Bone& bone = *updateArgs.TargetBone;
-    glm::mat4 transform = updateArgs->GetBoneTransformOrRelative(bone, updateArgs.AnimationTime);
+    glm::mat4 transform = updateArgs->GetJointTransformOrRelative(bone.JointIndex, bone.RelativeTransformMatrix, updateArgs.AnimationTime);
 
     int index = bone.BoneTransformIndex;
     glm::mat4 globalTransform = updateArgs.ParentTransform * transform;
@@ -307,6 +891,12 @@ void SkeletalMesh::CalculateTransform(const BoneAnimationUpdateArgs& updateArgs)
     // run chain to update other joint transforms
     for (const Bone& child : bone.Children)
     {
+        if (m_JointCollapseLods[child.JointIndex] <= updateArgs.Lod)
+        {
+            // whole subtree of collapsed joint is collapsed too
+            continue;
+        }
+
         BoneAnimationUpdateArgs newUpdateArgs = updateArgs;
         newUpdateArgs.TargetBone = &child;
         newUpdateArgs.ParentTransform = globalTransform;
@@ -315,7 +905,7 @@ void SkeletalMesh::CalculateTransform(const BoneAnimationUpdateArgs& updateArgs)
     }
 }
 
-std::shared_ptr<Texture2D> SkeletalMesh::LoadTexturesFromMaterial(const aiScene* scene, int materialIndex)
+void SkeletalMesh::LoadTexturesFromMaterial(const aiScene* scene, int materialIndex, std::vector<EmbeddedTextureData>& outEmbeddedTextures)
 {
     aiString texturePaths;
 
@@ -327,32 +917,22 @@ std::shared_ptr<Texture2D> SkeletalMesh::LoadTexturesFromMaterial(const aiScene*
         if (texture != nullptr)
         {
             bool bCompressed = texture->mHeight == 0;
+            uint32_t length = bCompressed ? texture->mWidth : texture->mWidth * texture->mHeight;
 
-            if (bCompressed)
-            {
-                ResourceManager::AddTexture2D(texturePaths.C_Str(),
-                    std::make_shared<Texture2D>(LoadRgbaImageFromMemory(texture->pcData, texture->mWidth)));
-            }
-            else
-            {
-                ResourceManager::AddTexture2D(texturePaths.C_Str(), std::make_shared<Texture2D>(
-                    LoadRgbaImageFromMemory(texture->pcData, texture->mWidth * texture->mHeight)));
-            }
-
-            TextureNames.emplace_back(texturePaths.C_Str());
+            outEmbeddedTextures.emplace_back(EmbeddedTextureData{texturePaths.C_Str(),
+                std::span<const std::byte>{reinterpret_cast<const std::byte*>(texture->pcData), length}});
 
-            return ResourceManager::GetTexture2D(texturePaths.C_Str());
+            // texture is decoded here, but GPU texture is created when loading finishes
+            m_PendingUpload->Textures.emplace_back(DecodeEmbeddedTexture(outEmbeddedTextures.back()));
         }
     }
-
-    return nullptr;
 }
 
 void FindAabCollision(std::span<const SkeletonMeshVertex> vertices, glm::vec3& outBoxMin, glm::vec3& outBoxMax)
 {
     // assume mesh has infinite bounds
     outBoxMin = glm::vec3{std::numeric_limits<float>::max()};
-    outBoxMax = glm::vec3{std::numeric_limits<float>::min()};
+    outBoxMax = glm::vec3{std::numeric_limits<float>::lowest()};
 
     for (std::size_t i = 0; i < vertices.size(); ++i)
     {
@@ -385,3 +965,20 @@ void FindAabCollision(std::span<const SkeletonMeshVertex> vertices, glm::vec3& o
         }
     }
 }
+
+size_t SkeletalMeshPendingUpload::GetNumBytes() const
+{
+    size_t numBytes = Indices.size_bytes();
+
+    for (std::span<const SkeletonMeshVertex> lodVertices : LodVertices)
+    {
+        numBytes += lodVertices.size_bytes();
+    }
+
+    for (const DecodedTexture& texture : Textures)
+    {
+        numBytes += texture.Image.GetSizeInBytes();
+    }
+
+    return numBytes;
+}
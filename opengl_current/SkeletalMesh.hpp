@@ -6,8 +6,12 @@
 #include "Material.hpp"
 
 #include "Box.hpp"
+#include "Skeleton.hpp"
+#include "CookedMesh.hpp"
+#include "GpuUploadQueue.hpp"
 
 #include <glm/glm.hpp>
+#include <algorithm>
 #include <span>
 #include <string>
 
@@ -20,9 +24,9 @@
 #include <unordered_map>
 
 #include <chrono>
+#include <mutex>
 
 inline constexpr int NumBonesPerVertex = 4;
-inline constexpr const char* DefaultAnimationName = "TPose";
 
 struct SkeletonMeshVertex
 {
@@ -50,39 +54,6 @@ struct SkeletonMeshVertex
     bool AddBoneData(int boneId, float weight);
 };
 
-template <typename T>
-struct KeyProperty
-{
-    T Property;
-    float Timestamp;
-};
-
-using VectorProperty = KeyProperty<glm::vec3>;
-using QuatProperty = KeyProperty<glm::quat>;
-
-class BoneAnimationTrack
-{
-public:
-    void AddNewPositionTimestamp(glm::vec3 position, float timestamp);
-    void AddNewRotationTimestamp(glm::quat rotation, float timestamp);
-
-    template <typename T>
-    T Interpolate(float animationTime) const;
-
-    template<>
-    glm::vec3 Interpolate<glm::vec3>(float animationTime) const;
-
-    template<>
-    glm::quat Interpolate<glm::quat>(float animationTime) const;
-
-private:
-    std::vector<VectorProperty> m_PositionKeys;
-    std::vector<QuatProperty> m_RotationKeys;
-
-    template <typename T>
-    size_t GetIndex(float animationTime, const std::vector<KeyProperty<T>>& timestamps) const;
-};
-
 
 struct BoneInfo
 {
@@ -103,6 +74,9 @@ struct Bone
 {
     std::vector<Bone> Children;
 
+    /* Index of joint in shared skeleton */
+    int JointIndex{0};
+
     /* Index in bone_transform_ array */
     int BoneTransformIndex{0};
 
@@ -116,18 +90,6 @@ struct Bone
     bool AssignHierarchy(const aiNode* node, const std::unordered_map<std::string, BoneInfo>& bonesInfo);
 };
 
-struct SkeletalAnimation
-{
-    // Duration in ticks
-    float Duration{0.0f};
-    float TicksPerSecond{0.0f};
-
-    // bone name mapped to animation track
-    std::unordered_map<std::string, BoneAnimationTrack> BoneNameToTracks;
-
-    glm::mat4 GetBoneTransformOrRelative(const Bone& bone, float animationTime) const;
-};
-
 struct aiScene;
 
 struct BoneAnimationUpdateArgs
@@ -137,6 +99,7 @@ struct BoneAnimationUpdateArgs
     const Bone* TargetBone;
     std::span<glm::mat4> BoneTransforms;
     glm::mat4 ParentTransform{1.0f};
+    int Lod{0};
 
     const SkeletalAnimation* operator->() const;
     void UpdateTransformAt(int index, const glm::mat4& transform) const;
@@ -147,6 +110,39 @@ struct AnimationUpdateArgs
     float ElapsedTime;
     std::string AnimationName;
     std::span<glm::mat4> Transforms;
+
+    // lod of mesh. Only bones used by that lod are evaluated
+    int Lod{0};
+};
+
+// Geometry of single lod of skeletal mesh together with joints it's skinned to.
+// Distant lods collapse small leaf bones (fingers, face) into parents, so they evaluate less joints
+struct SkeletalMeshLod
+{
+    // created on main thread, so it's empty until mesh finishes loading
+    std::unique_ptr<VertexArray> LodVertexArray;
+
+    // joints evaluated at this lod in parent before child order
+    FlatSkeleton Joints;
+    SkinBinding Binding;
+
+    // index of each joint in shared skeleton, used to find it's animation track
+    std::vector<int> SourceJointIndices;
+};
+
+// CPU data of skeletal mesh kept until FinishLoading creates GPU objects from it. Spans point
+// either into mapped cooked file or into imported arrays
+struct SkeletalMeshPendingUpload
+{
+    std::vector<DecodedTexture> Textures;
+    std::vector<std::span<const SkeletonMeshVertex>> LodVertices;
+    std::span<const uint32_t> Indices;
+
+    MappedFile CookedFile;
+    std::vector<std::vector<SkeletonMeshVertex>> ImportedLodVertices;
+    std::vector<uint32_t> ImportedIndices;
+
+    size_t GetNumBytes() const;
 };
 
 class SkeletalMesh
@@ -154,12 +150,59 @@ class SkeletalMesh
     friend struct SkeletalMeshComponent;
 
 public:
-    SkeletalMesh(const std::filesystem::path& path, const std::shared_ptr<Material>& material);
+    // With Deferred mode skeleton is not shared with other meshes and GPU objects aren't created
+    // until FinishLoading is called, so mesh can be loaded on loading thread
+    SkeletalMesh(const std::filesystem::path& path, const std::shared_ptr<Material>& material, GpuUploadMode uploadMode = GpuUploadMode::Immediate);
+
+    // Creates GPU objects and shares skeleton with meshes rigged to the same hierarchy. Must be called on main thread
+    void FinishLoading();
+
+    // Size of data waiting for FinishLoading
+    size_t GetNumPendingBytes() const;
+
+    // Size of data kept in CPU memory, including data waiting for FinishLoading. Skeleton and its animations
+    // are shared with other meshes, so they aren't counted
+    size_t GetNumCpuBytes() const;
+
+    // Replaces geometry of lod with mesh from file. File must be rigged to the same skeleton.
+    // Passing lod equal to GetNumLods() adds new lod
+    void LoadLod(const std::filesystem::path& path, int lod);
+
+    int GetNumLods() const
+    {
+        return GetContainerSizeInt(m_Lods);
+    }
+
+    // Lods above last one use last lod
+    int ClampLod(int lod) const
+    {
+        return std::clamp(lod, 0, GetNumLods() - 1);
+    }
+
+    // Number of joints evaluated when animating given lod
+    int GetNumJoints(int lod) const
+    {
+        return m_Lods[ClampLod(lod)].Joints.GetNumJoints();
+    }
 
     std::vector<std::string> GetAnimationNames() const;
 
+    // Returns duration of animation in seconds
+    float GetAnimationDuration(const std::string& animationName) const;
+
     void GetAnimationFrames(const AnimationUpdateArgs& updateArgs) const;
 
+    // Creates job for SkeletonPoseEvaluator, so poses of many meshes can be evaluated in one batch
+    PoseEvaluationJob CreatePoseEvaluationJob(const AnimationUpdateArgs& updateArgs) const;
+
+    const std::shared_ptr<Skeleton>& GetSkeleton() const
+    {
+        return m_Skeleton;
+    }
+
+    // When set, poses are evaluated with SIMD kernels instead of recursive glm path
+    static inline bool s_bUseAnimationKernels = true;
+
     const glm::vec3& GetBboxMin() const;
     const glm::vec3& GetBboxMax() const;
 
@@ -169,11 +212,19 @@ public:
 
     std::shared_ptr<Material> MainMaterial;
 
+    // Material used when drawing all instances of this mesh at once (see InstancedSkeletalMesh).
+    // When not set each component is drawn separately with MainMaterial
+    std::shared_ptr<Material> InstancedMaterial;
+
+    // Bounds of mesh in bind pose
     Box GetBoundingBox() const
     {
         return m_BoundingBox;
     }
 
+    // Conservative bounds of mesh during whole animation, calculated once by sampling animation
+    Box GetAnimationBounds(const std::string& animationName) const;
+
     std::vector<std::string> TextureNames;
     const std::string& GetPath() const
     {
@@ -181,102 +232,77 @@ public:
     }
 
 public:
-    const VertexArray& GetVertexArray() const
+    const VertexArray& GetVertexArray(int lod = 0) const
     {
-        return m_VertexArray;
+        return *m_Lods[ClampLod(lod)].LodVertexArray;
     }
 
 private:
-    VertexArray m_VertexArray;
+    std::vector<SkeletalMeshLod> m_Lods;
     Bone m_RootBone;
-    std::unordered_map<std::string, SkeletalAnimation> m_Animations;
+    std::shared_ptr<Skeleton> m_Skeleton;
+
+    // first lod at which joint is collapsed into it's parent
+    std::vector<int> m_JointCollapseLods;
     glm::mat4 m_GlobalInverseTransform;
     uint32_t m_NumBones;
     std::string m_Path;
     Box m_BoundingBox;
 
+    // bounds of vertices influenced by each bone (in mesh space), indexed by bone transform index
+    std::vector<Box> m_BoneBounds;
+
+    mutable std::unordered_map<std::string, Box> m_AnimationBounds;
+    mutable std::mutex m_AnimationBoundsMutex;
+
+    std::unique_ptr<SkeletalMeshPendingUpload> m_PendingUpload;
+
 private:
     void UpdateAnimation(const AnimationUpdateArgs& updateArgs) const;
     void CalculateTransform(const BoneAnimationUpdateArgs& updateArgs) const;
-    std::shared_ptr<Texture2D> LoadTexturesFromMaterial(const aiScene* scene, int materialIndex);
-    void LoadAnimation(const aiScene* scene, int animationIndex);
+    void LoadTexturesFromMaterial(const aiScene* scene, int materialIndex, std::vector<EmbeddedTextureData>& outEmbeddedTextures);
+
+    // Loads mesh from cooked .mesh file. Returns false when cooked file is missing, stale or corrupted
+    bool LoadCooked(const std::filesystem::path& path);
+
+    // Imports mesh with Assimp and cooks it, so next time it's loaded from cooked file
+    void Import(const std::filesystem::path& path);
+    void FlattenSkeleton(Bone& bone, int parentIndex, FlatSkeleton& outJoints, SkinBinding& outBinding);
+    void LoadGeometry(const aiScene* scene, std::unordered_map<std::string, int>& boneNameToIndex, std::vector<SkeletonMeshVertex>& outVertices,
+        std::vector<uint32_t>& outIndices, std::unordered_map<std::string, BoneInfo>& outBonesInfo);
+    void CalculateJointCollapseLods(const SkinBinding& binding);
+    int FindKeptJoint(int joint, int lod) const;
+
+    // Remaps weights of bones collapsed at lod to their kept ancestors
+    std::vector<SkeletonMeshVertex> CollapseLodVertices(int lod, const SkinBinding& binding, std::span<const SkeletonMeshVertex> vertices) const;
+    SkeletalMeshLod CreateLod(int lod, const SkinBinding& binding) const;
+    float GetAnimationTimeInTicks(const SkeletalAnimation& animation, float elapsedTime) const;
+    void CalculateBoneBounds(std::span<const SkeletonMeshVertex> vertices);
+    Box CalculateAnimationBounds(const std::string& animationName) const;
 };
 
-template<>
-inline glm::vec3 BoneAnimationTrack::Interpolate(float animationTime) const
+struct SkeletalMeshKey
 {
-    if (m_PositionKeys.size() == 1)
-    {
-        return m_PositionKeys[0].Property;
-    }
-    else if (!m_PositionKeys.empty())
-    {
-        size_t positionIndex = GetIndex(animationTime, m_PositionKeys);
-        size_t nextPositionIndex = positionIndex + 1;
-
-        float deltaTime = m_PositionKeys[nextPositionIndex].Timestamp - m_PositionKeys[positionIndex].Timestamp;
-        float factor = (animationTime - m_PositionKeys[positionIndex].Timestamp) / deltaTime;
-        ASSERT(factor >= 0 && factor <= 1);
-
-        return glm::mix(m_PositionKeys[positionIndex].Property, m_PositionKeys[nextPositionIndex].Property, factor);
-    }
-    else
-    {
-        return glm::vec3{0, 0, 0};
-    }
-}
+    std::shared_ptr<SkeletalMesh> Mesh;
+    int Lod{0};
 
-template<>
-inline glm::quat BoneAnimationTrack::Interpolate(float animationTime) const
-{
-    if (m_RotationKeys.size() == 1)
+    bool operator==(const SkeletalMeshKey& other) const
     {
-        // not enough keys, use first key as base
-        return m_RotationKeys[0].Property;
+        return other.Mesh == Mesh && other.Lod == Lod;
     }
-    else if (!m_RotationKeys.empty())
-    {
-        // find time range based on animationTime
-        size_t rotationIndex = GetIndex(animationTime, m_RotationKeys);
-        size_t nextRotationIndex = rotationIndex + 1;
-
-        float deltaTime = m_RotationKeys[nextRotationIndex].Timestamp - m_RotationKeys[rotationIndex].Timestamp;
-        float factor = (animationTime - m_RotationKeys[rotationIndex].Timestamp) / deltaTime;
-        ASSERT(factor >= 0 && factor <= 1);
-        return glm::mix(m_RotationKeys[rotationIndex].Property, m_RotationKeys[nextRotationIndex].Property, factor);
-    }
-
-    return glm::quat{glm::vec3{0, 0, 0}};
-}
-
+};
 
-template <typename T>
-inline size_t BoneAnimationTrack::GetIndex(float animationTime, const std::vector<KeyProperty<T>>& keys) const
+namespace std
 {
-    ASSERT(keys.size() > 0 && "Called BoneAnimationTrack::GetIndex with track without keys");
-
-    // run binary search to find first timestamp that is greater than animationTime (max in time range)
-    auto it = std::lower_bound(keys.begin(), keys.end(), animationTime, [](const KeyProperty<T>& k, float time)
-    {
-        return time > k.Timestamp;
-    });
-
-    bool bLastAnimTimestamp = it == keys.end();
-    if (bLastAnimTimestamp)
-    {
-        return keys.size() > 2 ? static_cast<uint32_t>(keys.size() - 2) : 0;
-    }
-
-    size_t leftSideRange = static_cast<size_t>(std::distance(keys.begin(), it));
-
-    if (leftSideRange != 0)
+    template<>
+    struct hash<::SkeletalMeshKey>
     {
-        // if it's not a first frame of animation, adjust that i now defines left side of range
-        // otherwise it's just range {0, 1}
-        --leftSideRange;
-    }
-
-    return leftSideRange;
+        size_t operator()(const SkeletalMeshKey& key) const
+        {
+            size_t seed = hash<std::shared_ptr<SkeletalMesh>>{}(key.Mesh);
+            return seed ^ (hash<int>{}(key.Lod) + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+        }
+    };
 }
 
 inline BoneInfo::BoneInfo(int boneTransformIndex, const glm::mat4& offsetMatrix) :
@@ -285,28 +311,8 @@ inline BoneInfo::BoneInfo(int boneTransformIndex, const glm::mat4& offsetMatrix)
 {
 }
 
-inline void SkeletalMesh::UpdateAnimation(const AnimationUpdateArgs& updateArgs) const
-{
-    const SkeletalAnimation& animation = m_Animations.at(updateArgs.AnimationName);
-
-    // precalculate animation time to
-    float timeInTicks = updateArgs.ElapsedTime * animation.TicksPerSecond;
-    float animationTime = fmod(timeInTicks, animation.Duration);
-
-    // run transform update chain starting from root joint
-    CalculateTransform(BoneAnimationUpdateArgs{&animation, animationTime, &m_RootBone, updateArgs.Transforms});
-}
 
 
-inline void BoneAnimationTrack::AddNewPositionTimestamp(glm::vec3 position, float timestamp)
-{
-    m_PositionKeys.emplace_back(VectorProperty{position, timestamp});
-}
-
-inline void BoneAnimationTrack::AddNewRotationTimestamp(glm::quat Rotation, float timestamp)
-{
-    m_RotationKeys.emplace_back(QuatProperty{Rotation, timestamp});
-}
 
 FORCE_INLINE const SkeletalAnimation* BoneAnimationUpdateArgs::operator->() const
 {
@@ -2,6 +2,8 @@
 
 #include "Renderer.hpp"
 
+#include <algorithm>
+
 SkeletalMeshComponent::SkeletalMeshComponent(const std::shared_ptr<SkeletalMesh>& mesh) :
     TargetSkeletalMesh{mesh}
 {
@@ -13,12 +15,29 @@ SkeletalMeshComponent::SkeletalMeshComponent(const std::shared_ptr<SkeletalMesh>
 void SkeletalMeshComponent::UpdateAnimation(float deltaSeconds, const Transform& transform)
 {
     AnimationTime += deltaSeconds;
+    SharedBoneTransforms.reset();
+    bPoseOutdated = false;
+    Lod = 0;
     TargetSkeletalMesh->GetAnimationFrames(AnimationUpdateArgs{AnimationTime, AnimationName, BoneTransforms});
 }
 
+void SkeletalMeshComponent::UpdateAnimation(float deltaSeconds, AnimationPoseCache& poseCache, int lod)
+{
+    AnimationTime += deltaSeconds;
+    SharedBoneTransforms = poseCache.FindOrEvaluatePose(*TargetSkeletalMesh, AnimationName, AnimationTime, lod);
+    bPoseOutdated = false;
+    Lod = std::min(lod, TargetSkeletalMesh->GetNumLods() - 1);
+}
+
+void SkeletalMeshComponent::AdvanceAnimationTime(float deltaSeconds)
+{
+    AnimationTime += deltaSeconds;
+    bPoseOutdated = true;
+}
+
 void SkeletalMeshComponent::Draw(const glm::mat4& worldTransform) const
 {
-    Renderer::SubmitSkeleton(*TargetSkeletalMesh, worldTransform, BoneTransforms);
+    Renderer::SubmitSkeleton(*TargetSkeletalMesh, worldTransform, GetBoneTransforms(), Lod);
 }
 
 Datapack SkeletalMeshComponent::Archived() const
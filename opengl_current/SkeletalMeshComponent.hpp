@@ -1,6 +1,7 @@
 #pragma once
 
 #include "SkeletalMesh.hpp"
+#include "AnimationPoseCache.hpp"
 #include "Transform.hpp"
 #include "Datapack.hpp"
 
@@ -13,14 +14,49 @@ struct SkeletalMeshComponent
     std::shared_ptr<SkeletalMesh> TargetSkeletalMesh;
     float AnimationTime{0.0f};
 
+    // Pose shared with other components by AnimationPoseCache. When set it's used instead of BoneTransforms
+    SharedPose SharedBoneTransforms;
+
+    // Set when only time was advanced (mesh was offscreen), so pose must be evaluated before draw
+    bool bPoseOutdated{false};
+
+    // Lod of mesh that pose was evaluated for
+    int Lod{0};
+
     SkeletalMeshComponent() = default;
     SkeletalMeshComponent(const std::shared_ptr<SkeletalMesh>& mesh);
 
     void UpdateAnimation(float deltaSeconds, const Transform& transform);
+
+    // Updates animation using pose from cache, evaluated only by first component with the same state
+    void UpdateAnimation(float deltaSeconds, AnimationPoseCache& poseCache, int lod);
+
+    // Advances animation without evaluating pose. Used for meshes that are not visible
+    void AdvanceAnimationTime(float deltaSeconds);
+
+    std::span<const glm::mat4> GetBoneTransforms() const;
+
+    // Local space bounds that contain mesh in every frame of current animation
+    Box GetAnimationBounds() const;
     void Draw(const glm::mat4& worldTransform) const;
 
     Datapack Archived() const;
 };
 
+FORCE_INLINE std::span<const glm::mat4> SkeletalMeshComponent::GetBoneTransforms() const
+{
+    if (SharedBoneTransforms)
+    {
+        return *SharedBoneTransforms;
+    }
+
+    return BoneTransforms;
+}
+
+FORCE_INLINE Box SkeletalMeshComponent::GetAnimationBounds() const
+{
+    return TargetSkeletalMesh->GetAnimationBounds(AnimationName);
+}
+
 
 
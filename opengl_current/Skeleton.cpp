@@ -0,0 +1,177 @@
+#include "Skeleton.hpp"
+#include "AssimpUtils.hpp"
+#include "Logging.hpp"
+
+Skeleton::Skeleton(FlatSkeleton joints) :
+    m_Joints{std::move(joints)},
+    m_HierarchyHash{CalculateHierarchyHash(m_Joints)}
+{
+    for (int i = 0; i < m_Joints.GetNumJoints(); ++i)
+    {
+        m_JointNameToIndex[m_Joints.JointNames[i]] = i;
+    }
+
+    // define Tpose animation dummy values
+    SkeletalAnimation tpose{};
+    tpose.TicksPerSecond = 30;
+    tpose.Duration = 10;
+    tpose.JointTracks.resize(m_Joints.GetNumJoints());
+    m_Animations[DefaultAnimationName] = std::move(tpose);
+}
+
+uint64_t Skeleton::CalculateHierarchyHash(const FlatSkeleton& joints)
+{
+    // FNV-1a over joint names and parent indices
+    constexpr uint64_t FnvOffsetBasis = 14695981039346656037ull;
+    constexpr uint64_t FnvPrime = 1099511628211ull;
+
+    uint64_t hash = FnvOffsetBasis;
+
+    auto hashBytes = [&hash](const void* data, size_t numBytes)
+    {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+
+        for (size_t i = 0; i < numBytes; ++i)
+        {
+            hash ^= bytes[i];
+            hash *= FnvPrime;
+        }
+    };
+
+    for (int i = 0; i < joints.GetNumJoints(); ++i)
+    {
+        const std::string& name = joints.JointNames[i];
+        hashBytes(name.data(), name.size() + 1);
+        hashBytes(&joints.ParentIndices[i], sizeof(int));
+    }
+
+    return hash;
+}
+
+int Skeleton::FindJointIndex(const std::string& name) const
+{
+    auto it = m_JointNameToIndex.find(name);
+    return it != m_JointNameToIndex.end() ? it->second : -1;
+}
+
+bool Skeleton::HasAnimation(const std::string& name) const
+{
+    return m_Animations.contains(name);
+}
+
+const SkeletalAnimation& Skeleton::GetAnimation(const std::string& name) const
+{
+    return m_Animations.at(name);
+}
+
+std::vector<std::string> Skeleton::GetAnimationNames() const
+{
+    std::vector<std::string> names;
+
+    names.reserve(m_Animations.size());
+
+    for (auto& [name, animation] : m_Animations)
+    {
+        names.emplace_back(name);
+    }
+
+    return names;
+}
+
+std::vector<std::string> Skeleton::LoadAnimations(const aiScene* scene)
+{
+    std::vector<std::string> animationNames;
+    animationNames.reserve(scene->mNumAnimations);
+
+    for (uint32_t i = 0; i < scene->mNumAnimations; ++i)
+    {
+        animationNames.emplace_back(LoadAnimation(scene, i));
+    }
+
+    return animationNames;
+}
+
+void Skeleton::LoadAnimations(const std::filesystem::path& path)
+{
+    std::string filePath = path.string();
+
+    if (m_LoadedAnimationFiles.contains(filePath))
+    {
+        return;
+    }
+
+    Assimp::Importer importer;
+    const aiScene* scene = importer.ReadFile(filePath, AssimpImportFlags);
+    ERR_FAIL_NULL_MSG(scene, "Failed to load animations");
+
+    ENG_LOG_VERBOSE("Loading animations from {}", filePath);
+    LoadAnimations(scene);
+    m_LoadedAnimationFiles.insert(filePath);
+}
+
+void Skeleton::AddAnimation(const std::string& name, SkeletalAnimation animation)
+{
+    ERR_FAIL_EXPECTED_TRUE_MSG(GetContainerSizeInt(animation.JointTracks) == m_Joints.GetNumJoints(), "Animation isn't bound to this skeleton");
+    m_Animations.try_emplace(name, std::move(animation));
+}
+
+std::string Skeleton::LoadAnimation(const aiScene* scene, int animationIndex)
+{
+    const aiAnimation* anim = scene->mAnimations[animationIndex];
+
+    std::string animationName = anim->mName.C_Str();
+    animationName = SplitString(animationName, "|").back();
+
+    if (HasAnimation(animationName))
+    {
+        // already loaded by other mesh using this skeleton
+        return animationName;
+    }
+
+    SkeletalAnimation animation{};
+
+    if (anim->mTicksPerSecond != 0.0f)
+    {
+        animation.TicksPerSecond = static_cast<float>(anim->mTicksPerSecond);
+    }
+    else
+    {
+        animation.TicksPerSecond = 1.0f;
+    }
+
+    animation.Duration = static_cast<float>(anim->mDuration);
+    animation.JointTracks.resize(m_Joints.GetNumJoints());
+
+    for (uint32_t i = 0; i < anim->mNumChannels; i++)
+    {
+        const aiNodeAnim* channel = anim->mChannels[i];
+        int jointIndex = FindJointIndex(channel->mNodeName.C_Str());
+
+        if (jointIndex == -1)
+        {
+            // channel animates node that isn't bone
+            continue;
+        }
+
+        BoneAnimationTrack& track = animation.JointTracks[jointIndex];
+
+        for (uint32_t j = 0; j < channel->mNumPositionKeys; j++)
+        {
+            track.AddNewPositionTimestamp(ToGlm(channel->mPositionKeys[j].mValue),
+                static_cast<float>(channel->mPositionKeys[j].mTime));
+        }
+        for (uint32_t j = 0; j < channel->mNumRotationKeys; j++)
+        {
+            track.AddNewRotationTimestamp(ToGlm(channel->mRotationKeys[j].mValue),
+                static_cast<float>(channel->mRotationKeys[j].mTime));
+        }
+
+        // skip scale tracks, as it's not common to use scaling tracks of bones
+    }
+
+    ENG_LOG_VERBOSE("Animation {} [Duration: {}, TicksPerSecond: {}, NumChannels: {}]", animationName, animation.Duration, animation.TicksPerSecond,
+        anim->mNumChannels);
+
+    m_Animations[animationName] = std::move(animation);
+    return animationName;
+}
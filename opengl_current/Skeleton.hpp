@@ -0,0 +1,66 @@
+#pragma once
+
+#include "AnimationKernels.hpp"
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <filesystem>
+
+inline constexpr const char* DefaultAnimationName = "TPose";
+
+struct aiScene;
+
+// Bone hierarchy shared by all meshes rigged to it, together with animations that can be played on it.
+// Animations are loaded once and their tracks are bound by joint index, so variants of character
+// don't keep own copies of the same clips
+class Skeleton
+{
+public:
+    Skeleton(FlatSkeleton joints);
+
+    // Hash of joint names and hierarchy. Meshes with same hash are rigged to the same skeleton
+    static uint64_t CalculateHierarchyHash(const FlatSkeleton& joints);
+
+    uint64_t GetHierarchyHash() const
+    {
+        return m_HierarchyHash;
+    }
+
+    const FlatSkeleton& GetJoints() const
+    {
+        return m_Joints;
+    }
+
+    int GetNumJoints() const
+    {
+        return m_Joints.GetNumJoints();
+    }
+
+    // Returns -1 if joint is not part of skeleton
+    int FindJointIndex(const std::string& name) const;
+
+    bool HasAnimation(const std::string& name) const;
+    const SkeletalAnimation& GetAnimation(const std::string& name) const;
+    std::vector<std::string> GetAnimationNames() const;
+
+    // Loads animations from scene that weren't loaded yet. Returns names of all animations in scene
+    std::vector<std::string> LoadAnimations(const aiScene* scene);
+
+    // Loads animations from file containing only animations, file is loaded only once
+    void LoadAnimations(const std::filesystem::path& path);
+
+    // Adds animation with tracks already bound to joints of this skeleton. Does nothing if animation is already loaded
+    void AddAnimation(const std::string& name, SkeletalAnimation animation);
+
+private:
+    FlatSkeleton m_Joints;
+    uint64_t m_HierarchyHash;
+    std::unordered_map<std::string, int> m_JointNameToIndex;
+    std::unordered_map<std::string, SkeletalAnimation> m_Animations;
+    std::unordered_set<std::string> m_LoadedAnimationFiles;
+
+private:
+    std::string LoadAnimation(const aiScene* scene, int animationIndex);
+};
@@ -10,6 +10,17 @@ SpriteSheetData::SpriteSheetData(glm::uvec2 numFrames, glm::vec2 margin, glm::ve
     ASSERT(m_SpriteSheetSize.x <= m_Texture->GetWidth() && m_SpriteSheetSize.y <= m_Texture->GetHeight());
 }
 
+SpriteSheetData::SpriteSheetData(glm::uvec2 numFrames, glm::vec2 margin, const AtlasRegion& region) :
+    m_NumFrames(numFrames),
+    m_Margin(margin),
+    m_SpriteSheetSize(region.Size),
+    m_Texture(region.Page),
+    m_UvOffset(region.UvStart),
+    m_UvScale(region.UvEnd - region.UvStart)
+{
+    ASSERT(m_Texture);
+}
+
 glm::vec2 SpriteSheetData::GetStartUvCoordinate(glm::uvec2 frameCoords) const
 {
     glm::vec2 start((float)frameCoords.x / m_NumFrames.x, (float)frameCoords.y / m_NumFrames.y);
@@ -17,7 +28,7 @@ glm::vec2 SpriteSheetData::GetStartUvCoordinate(glm::uvec2 frameCoords) const
     start.x = start.x + m_Margin.x / m_SpriteSheetSize.x;
     start.y = start.y + m_Margin.y / m_SpriteSheetSize.y;
 
-    return start;
+    return m_UvOffset + start * m_UvScale;
 }
 
 glm::vec2 SpriteSheetData::GetEndUvCoordinate(glm::uvec2 frameCoords) const
@@ -27,7 +38,7 @@ glm::vec2 SpriteSheetData::GetEndUvCoordinate(glm::uvec2 frameCoords) const
     end.x = end.x - m_Margin.x / m_SpriteSheetSize.x;
     end.y = end.y - m_Margin.y / m_SpriteSheetSize.y;
 
-    return end;
+    return m_UvOffset + end * m_UvScale;
 }
 
 Sprite2D::Sprite2D(glm::vec2 position, glm::vec2 size, int textureId, const SpriteSheetData& spriteSheetData, glm::uvec2 animationFrame, RgbaColor tint) :
@@ -3,18 +3,27 @@
 #include "Texture.hpp"
 #include "Transform2D.hpp"
 #include "RenderCommand.hpp"
+#include "SpriteAtlas.hpp"
 
 class SpriteSheetData
 {
 public:
     SpriteSheetData() = default;
     SpriteSheetData(glm::uvec2 numFrames, glm::vec2 margin, glm::vec2 spriteSheetSize, const std::shared_ptr<Texture2D>& texture);
+
+    // Sprite sheet packed in atlas, UVs of frames are remapped to its region of page
+    SpriteSheetData(glm::uvec2 numFrames, glm::vec2 margin, const AtlasRegion& region);
     SpriteSheetData(const SpriteSheetData& data) = default;
     SpriteSheetData& operator=(const SpriteSheetData& data) = default;
 
     glm::vec2 GetStartUvCoordinate(glm::uvec2 frameCoords) const;
     glm::vec2 GetEndUvCoordinate(glm::uvec2 frameCoords) const;
 
+    const std::shared_ptr<Texture2D>& GetTexture() const
+    {
+        return m_Texture;
+    }
+
 private:
     // Max num frames in texture (MaxNumColumns, MaxNumRows)
     glm::uvec2 m_NumFrames{1, 1};
@@ -22,6 +31,10 @@ private:
     glm::vec2 m_Margin = glm::vec2{0, 0};
     glm::vec2 m_SpriteSheetSize{1, 1};
     std::shared_ptr<Texture2D> m_Texture;
+
+    // region of texture taken by sprite sheet in UV space
+    glm::vec2 m_UvOffset{0, 0};
+    glm::vec2 m_UvScale{1, 1};
 };
 
 struct Sprite2D
@@ -30,6 +43,9 @@ struct Sprite2D
     RgbaColor Tint;
     int TextureId{0};
 
+    // Sprites on higher layer are drawn over lower ones when Renderer2D sorts sprites. Range of int16_t
+    int Layer{0};
+
     // Current frame (Column, Row)
     glm::uvec2 AnimationFrame{0, 0};
 
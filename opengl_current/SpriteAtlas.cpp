@@ -0,0 +1,130 @@
+#include "SpriteAtlas.hpp"
+#include "ErrorMacros.hpp"
+#include "Logging.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+// imgui compiles its copy of packer as static, so this file has its own
+#define STBRP_STATIC
+#define STB_RECT_PACK_IMPLEMENTATION
+#include "Imgui/imstb_rectpack.h"
+
+SpriteAtlas::SpriteAtlas(int pageSize, int padding) :
+    m_PageSize{pageSize},
+    m_Padding{padding}
+{
+    ASSERT(pageSize > 2 * padding);
+}
+
+void SpriteAtlas::AddImage(const std::string& name, ImageRgba&& image)
+{
+    m_PendingImages.emplace_back(PendingImage{name, std::move(image)});
+}
+
+void SpriteAtlas::AddImageFromFile(const std::filesystem::path& filePath)
+{
+    AddImage(filePath.string(), LoadRgbaImageFromFile(filePath));
+}
+
+void SpriteAtlas::Build()
+{
+    std::vector<stbrp_rect> remainingRects;
+    remainingRects.reserve(m_PendingImages.size());
+
+    for (int i = 0; i < static_cast<int>(m_PendingImages.size()); ++i)
+    {
+        const ImageRgba& image = m_PendingImages[i].Image;
+        stbrp_rect rect{};
+        rect.id = i;
+        rect.w = image.GetWidth() + 2 * m_Padding;
+        rect.h = image.GetHeight() + 2 * m_Padding;
+
+        if (rect.w > m_PageSize || rect.h > m_PageSize)
+        {
+            ENG_LOG_WARNING("Sprite {} is larger than atlas page, it won't be packed", m_PendingImages[i].Name);
+            continue;
+        }
+
+        remainingRects.emplace_back(rect);
+    }
+
+    std::vector<stbrp_node> nodes(m_PageSize);
+
+    // each pass fills one page, rectangles that didn't fit are packed to next one
+    while (!remainingRects.empty())
+    {
+        stbrp_context context;
+        stbrp_init_target(&context, m_PageSize, m_PageSize, nodes.data(), static_cast<int>(nodes.size()));
+        stbrp_pack_rects(&context, remainingRects.data(), static_cast<int>(remainingRects.size()));
+
+        ImageRgba pageImage{m_PageSize, m_PageSize};
+        std::memset(pageImage.GetRawImageData(), 0, pageImage.GetSizeInBytes());
+
+        for (const stbrp_rect& rect : remainingRects)
+        {
+            if (rect.was_packed)
+            {
+                CopyToPage(m_PendingImages[rect.id].Image, pageImage, rect.x, rect.y);
+            }
+        }
+
+        std::shared_ptr<Texture2D> page = std::make_shared<Texture2D>(pageImage);
+        m_Pages.emplace_back(page);
+
+        for (const stbrp_rect& rect : remainingRects)
+        {
+            if (!rect.was_packed)
+            {
+                continue;
+            }
+
+            const ImageRgba& image = m_PendingImages[rect.id].Image;
+            glm::vec2 start{rect.x + m_Padding, rect.y + m_Padding};
+            glm::vec2 size{image.GetWidth(), image.GetHeight()};
+
+            m_Regions[m_PendingImages[rect.id].Name] = AtlasRegion{page, start / static_cast<float>(m_PageSize),
+                (start + size) / static_cast<float>(m_PageSize), glm::ivec2{image.GetWidth(), image.GetHeight()}};
+        }
+
+        auto packedRects = std::remove_if(remainingRects.begin(), remainingRects.end(), [](const stbrp_rect& rect) { return rect.was_packed != 0; });
+        ERR_FAIL_EXPECTED_TRUE_MSG(packedRects != remainingRects.end(), "Atlas page couldn't fit any sprite");
+        remainingRects.erase(packedRects, remainingRects.end());
+    }
+
+    ENG_LOG_VERBOSE("Packed {} sprites into {} atlas pages", m_Regions.size(), m_Pages.size());
+    m_PendingImages.clear();
+}
+
+std::optional<AtlasRegion> SpriteAtlas::FindRegion(const std::string& name) const
+{
+    auto it = m_Regions.find(name);
+
+    if (it == m_Regions.end())
+    {
+        return std::nullopt;
+    }
+
+    return it->second;
+}
+
+void SpriteAtlas::CopyToPage(const ImageRgba& image, ImageRgba& page, int x, int y) const
+{
+    const uint32_t* source = reinterpret_cast<const uint32_t*>(image.GetRawImageData());
+    uint32_t* destination = reinterpret_cast<uint32_t*>(page.GetRawImageData());
+
+    int width = image.GetWidth();
+    int height = image.GetHeight();
+
+    // padding repeats edge pixels of image
+    for (int row = -m_Padding; row < height + m_Padding; ++row)
+    {
+        const uint32_t* sourceRow = source + static_cast<size_t>(std::clamp(row, 0, height - 1)) * width;
+        uint32_t* destinationRow = destination + static_cast<size_t>(y + m_Padding + row) * m_PageSize + x + m_Padding;
+
+        for (int column = -m_Padding; column < width + m_Padding; ++column)
+        {
+            destinationRow[column] = sourceRow[std::clamp(column, 0, width - 1)];
+        }
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Texture.hpp"
+#include "ImageRgba.hpp"
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// Part of atlas page where single source texture was packed
+struct AtlasRegion
+{
+    std::shared_ptr<Texture2D> Page;
+    glm::vec2 UvStart{0, 0};
+    glm::vec2 UvEnd{1, 1};
+
+    // size of source texture in pixels
+    glm::ivec2 Size{0, 0};
+};
+
+// Packs many small sprite textures into few large pages, so sprites using them share texture and are drawn
+// in single batch. Images are collected first and packed together by Build, which packs them tighter than adding
+// them one by one. Each image is surrounded by copy of its edge pixels, so linear filtering doesn't blend neighbours
+class SpriteAtlas
+{
+public:
+    SpriteAtlas(int pageSize = 2048, int padding = 2);
+
+    // Image larger than page stays unpacked, FindRegion returns nullopt for it
+    void AddImage(const std::string& name, ImageRgba&& image);
+    void AddImageFromFile(const std::filesystem::path& filePath);
+
+    // Packs all added images into pages and uploads them. Images are released after upload
+    void Build();
+
+    std::optional<AtlasRegion> FindRegion(const std::string& name) const;
+
+    const std::vector<std::shared_ptr<Texture2D>>& GetPages() const
+    {
+        return m_Pages;
+    }
+
+private:
+    struct PendingImage
+    {
+        std::string Name;
+        ImageRgba Image;
+    };
+
+    int m_PageSize;
+    int m_Padding;
+    std::vector<PendingImage> m_PendingImages;
+    std::vector<std::shared_ptr<Texture2D>> m_Pages;
+    std::unordered_map<std::string, AtlasRegion> m_Regions;
+
+private:
+    void CopyToPage(const ImageRgba& image, ImageRgba& page, int x, int y) const;
+};
@@ -1,4 +1,7 @@
 #include "SpriteBatch.hpp"
+#include "ErrorMacros.hpp"
+
+#include <algorithm>
 
 static const std::array<VertexAttribute, 4> SpriteVertexAttributes{
     VertexAttribute{2, PrimitiveVertexType::Float},
@@ -7,6 +10,21 @@ static const std::array<VertexAttribute, 4> SpriteVertexAttributes{
     VertexAttribute{1, PrimitiveVertexType::UnsignedInt}
 };
 
+static const std::array<VertexAttribute, 7> SpriteInstanceAttributes{
+    VertexAttribute{2, PrimitiveVertexType::Float},
+    VertexAttribute{2, PrimitiveVertexType::Float},
+    VertexAttribute{2, PrimitiveVertexType::Float},
+    VertexAttribute{1, PrimitiveVertexType::Float},
+    VertexAttribute{4, PrimitiveVertexType::Float},
+    VertexAttribute{1, PrimitiveVertexType::Int},
+    VertexAttribute{1, PrimitiveVertexType::UnsignedInt}
+};
+
+// attributes are tightly packed, so record can't have padding
+static_assert(sizeof(SpriteInstance) == 13 * sizeof(float));
+
+constexpr std::array<uint32_t, 6> BaseQuatIndices = {0, 1, 2, 0, 2, 3};
+
 struct DepthTestDisabler
 {
     DepthTestDisabler()
@@ -20,24 +38,37 @@ struct DepthTestDisabler
     }
 };
 
-SpriteBatch::SpriteBatch(std::shared_ptr<Material> material, const glm::mat4& projectionCopy) :
+SpriteBatch::SpriteBatch(std::shared_ptr<Material> material, const glm::mat4& projectionCopy, SpriteBatchMode mode) :
+    m_Mode(mode),
     m_Material2d(material),
     m_ProjectionCopy(projectionCopy)
 {
     material->bCullFaces = false;
-    m_Sprites.reserve(MaxSpritesDisplayed * NumQuadVertices);
+
+    if (m_Mode == SpriteBatchMode::Instanced)
+    {
+        CreateInstancedVertexArray();
+    }
+    else
+    {
+        CreateVertexArray();
+    }
+}
+
+void SpriteBatch::CreateVertexArray()
+{
+    m_Sprites.reserve(MaxSpritesPerDraw * NumQuadVertices);
     std::shared_ptr<VertexBuffer> buffer = std::make_shared<VertexBuffer>(static_cast<int>(m_Sprites.capacity() * sizeof(SpriteVertex)));
 
     m_SpriteVertexArray.AddVertexBuffer(buffer, SpriteVertexAttributes);
 
     uint32_t startIndex = 0;
-    constexpr std::array<uint32_t, 6> BaseQuatIndices = {0, 1, 2, 0, 2, 3};
 
     std::vector<uint32_t> batchedIndices;
 
-    batchedIndices.reserve(BaseQuatIndices.size() * MaxSpritesDisplayed);
+    batchedIndices.reserve(BaseQuatIndices.size() * MaxSpritesPerDraw);
 
-    for (uint32_t i = 0; i < MaxSpritesDisplayed; ++i)
+    for (uint32_t i = 0; i < MaxSpritesPerDraw; ++i)
     {
         for (uint32_t index : BaseQuatIndices)
         {
@@ -51,6 +82,17 @@ SpriteBatch::SpriteBatch(std::shared_ptr<Material> material, const glm::mat4& pr
     m_SpriteVertexArray.SetIndexBuffer(indexBuffer);
 }
 
+void SpriteBatch::CreateInstancedVertexArray()
+{
+    m_SpriteInstances.reserve(MaxSpritesPerDraw);
+    std::shared_ptr<VertexBuffer> buffer = std::make_shared<VertexBuffer>(static_cast<int>(m_SpriteInstances.capacity() * sizeof(SpriteInstance)));
+
+    m_SpriteVertexArray.AddVertexBuffer(buffer, SpriteInstanceAttributes, 1);
+
+    // quad has no vertex data, corners are selected by gl_VertexID
+    m_SpriteVertexArray.SetIndexBuffer(std::make_shared<IndexBuffer>(std::span<const uint32_t>{BaseQuatIndices}));
+}
+
 void SpriteBatch::FlushDraw(const glm::mat4& projection)
 {
     std::shared_ptr<Shader> shader = m_Material2d->GetShader();
@@ -60,20 +102,47 @@ void SpriteBatch::FlushDraw(const glm::mat4& projection)
     DepthTestDisabler depthTestDisabler{};
 
     BindSpriteUniforms(projection);
-
-    std::shared_ptr<VertexBuffer> vertexBuffer = m_SpriteVertexArray.GetVertexBufferAt(0);
-
     m_SpriteVertexArray.Bind();
-    vertexBuffer->Update(m_Sprites);
 
-    RenderCommand::DrawIndexed(m_SpriteVertexArray, m_NumIndicesToDraw);
+    if (m_Mode == SpriteBatchMode::Instanced)
+    {
+        DrawInPages(m_SpriteInstances, MaxSpritesPerDraw, [this](int numInstances)
+        {
+            RenderCommand::DrawIndexedInstanced(m_SpriteVertexArray, numInstances);
+        });
+    }
+    else
+    {
+        DrawInPages(m_Sprites, MaxSpritesPerDraw * NumQuadVertices, [this](int numVertices)
+        {
+            RenderCommand::DrawIndexed(m_SpriteVertexArray, numVertices / NumQuadVertices * static_cast<int>(BaseQuatIndices.size()));
+        });
+    }
+
     Reset();
 
     m_ProjectionCopy = projection;
 }
 
+template <typename T, typename DrawFunction>
+void SpriteBatch::DrawInPages(const std::vector<T>& records, int maxRecordsPerDraw, DrawFunction draw)
+{
+    std::shared_ptr<VertexBuffer> vertexBuffer = m_SpriteVertexArray.GetVertexBufferAt(0);
+    const int numRecords = GetContainerSizeInt(records);
+
+    for (int firstRecord = 0; firstRecord < numRecords; firstRecord += maxRecordsPerDraw)
+    {
+        int numPageRecords = std::min(maxRecordsPerDraw, numRecords - firstRecord);
+
+        vertexBuffer->Orphan();
+        vertexBuffer->UpdateVertices(records.data() + firstRecord, 0, numPageRecords * static_cast<int>(sizeof(T)));
+        draw(numPageRecords);
+    }
+}
+
 void SpriteBatch::AddSpriteInstance(const std::array<SpriteVertex, NumQuadVertices>& definition, const Transform2D& transform)
 {
+    ASSERT(m_Mode == SpriteBatchMode::Vertices);
     glm::mat4 transformMatrix = transform.GetTransformMatrix();
 
     for (const SpriteVertex& sprite_vertex : definition)
@@ -82,19 +151,32 @@ void SpriteBatch::AddSpriteInstance(const std::array<SpriteVertex, NumQuadVertic
         vertex.Position = transformMatrix * glm::vec4(vertex.Position, 0.5f, 1);
         m_Sprites.emplace_back(vertex);
     }
+}
 
-    m_NumIndicesToDraw += 6;
+void SpriteBatch::AddSpriteInstance(const SpriteInstance& instance)
+{
+    ASSERT(m_Mode == SpriteBatchMode::Instanced);
+    m_SpriteInstances.emplace_back(instance);
 }
 
-void SpriteBatch::BindNewTexture(std::shared_ptr<ITexture> texture)
+int SpriteBatch::BindNewTexture(std::shared_ptr<ITexture> texture)
 {
+    auto boundTexturesEnd = m_BindTextures.begin() + m_NumBindedTextures;
+    auto it = std::find(m_BindTextures.begin(), boundTexturesEnd, texture);
+
+    if (it != boundTexturesEnd)
+    {
+        return static_cast<int>(it - m_BindTextures.begin());
+    }
+
     if (m_NumBindedTextures >= MinTextureUnits)
     {
         FlushDraw(m_ProjectionCopy);
         m_NumBindedTextures = 0;
     }
 
-    m_BindTextures[m_NumBindedTextures++] = texture;
+    m_BindTextures[m_NumBindedTextures] = texture;
+    return m_NumBindedTextures++;
 }
 
 int SpriteBatch::GetNumBindedTextures() const
@@ -122,6 +204,6 @@ void SpriteBatch::Reset()
 {
     m_LastIndex = 0;
     m_NumBindedTextures = 0;
-    m_NumIndicesToDraw = 0;
     m_Sprites.clear();
+    m_SpriteInstances.clear();
 }
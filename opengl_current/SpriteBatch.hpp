@@ -5,7 +5,10 @@
 #include "Renderer2D.hpp"
 
 constexpr int NumQuadVertices = 4;
-constexpr int MaxSpritesDisplayed = 400;
+// Sprites above this number are drawn in following draws of the same flush
+constexpr int MaxSpritesPerDraw = 4096;
+// Set in texture id of sprite which texture stores signed distance field in alpha (see SdfFont), texture slot is in lower bits
+constexpr int SdfTextureFlag = 1 << 8;
 
 struct SpriteVertex
 {
@@ -15,33 +18,64 @@ struct SpriteVertex
     RgbaColor Tint;
 };
 
+// Record of single sprite in instanced mode. Vertex shader expands it to quad, so transform isn't computed on CPU
+struct SpriteInstance
+{
+    glm::vec2 Position;
+    glm::vec2 Size;
+    glm::vec2 Origin;
+
+    // in degrees, like Transform2D
+    float Rotation;
+
+    // start UV in xy, end UV in zw
+    glm::vec4 UvRect;
+    int TextureId;
+    RgbaColor Tint;
+};
+
 class SpriteBatch
 {
 public:
-    SpriteBatch(std::shared_ptr<Material> material, const glm::mat4& projectionCopy);
+    SpriteBatch(std::shared_ptr<Material> material, const glm::mat4& projectionCopy, SpriteBatchMode mode = SpriteBatchMode::Vertices);
 
     void FlushDraw(const glm::mat4& projection);
 
     void AddSpriteInstance(const std::array<SpriteVertex, NumQuadVertices>& definition, const Transform2D& transform);
-    void BindNewTexture(std::shared_ptr<ITexture> texture);
+    void AddSpriteInstance(const SpriteInstance& instance);
+
+    SpriteBatchMode GetMode() const
+    {
+        return m_Mode;
+    }
+
+    // Returns texture slot used by sprites. Texture already bound shares its slot, batch is flushed when all slots are used
+    int BindNewTexture(std::shared_ptr<ITexture> texture);
 
     int GetNumBindedTextures() const;
 
 private:
     VertexArray m_SpriteVertexArray;
     std::vector<SpriteVertex> m_Sprites;
+    std::vector<SpriteInstance> m_SpriteInstances;
+    SpriteBatchMode m_Mode;
 
     std::array<std::shared_ptr<ITexture>, MinTextureUnits> m_BindTextures;
     int m_NumBindedTextures = 0;
 
     int m_LastIndex = 0;
-    int m_NumIndicesToDraw = 0;
     std::shared_ptr<Material> m_Material2d;
     glm::mat4 m_ProjectionCopy;
 
 private:
 
     void BindSpriteUniforms(const glm::mat4& projection);
+    void CreateVertexArray();
+    void CreateInstancedVertexArray();
+
+    // Uploads records in pages of buffer size, each page orphans buffer, so upload doesn't wait for previous draw
+    template <typename T, typename DrawFunction>
+    void DrawInPages(const std::vector<T>& records, int maxRecordsPerDraw, DrawFunction draw);
     void Reset();
 };
 
@@ -4,6 +4,7 @@
 
 #include "ResourceManager.hpp"
 #include "Logging.hpp"
+#include "CookedMesh.hpp"
 
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtx/matrix_decompose.hpp>
@@ -13,7 +14,7 @@ static void FindAabCollision(std::span<const StaticMeshVertex> vertices, glm::ve
 {
     // assume mesh has infinite bounds
     outBoxMin = glm::vec3{std::numeric_limits<float>::max()};
-    outBoxMax = glm::vec3{std::numeric_limits<float>::min()};
+    outBoxMax = glm::vec3{std::numeric_limits<float>::lowest()};
 
     for (std::size_t i = 0; i < vertices.size(); ++i)
     {
@@ -47,16 +48,117 @@ static void FindAabCollision(std::span<const StaticMeshVertex> vertices, glm::ve
     }
 }
 
-StaticMesh::StaticMesh(const std::filesystem::path& filePath, const std::shared_ptr<Material>& material) :
+StaticMesh::StaticMesh(const std::filesystem::path& filePath, const std::shared_ptr<Material>& material, GpuUploadMode uploadMode) :
+    m_Path{filePath.string()},
     m_MainMaterial{material}
 {
-    LoadLod(filePath.string(), 0);
+    if (uploadMode == GpuUploadMode::Deferred)
+    {
+        m_PendingLod = std::make_unique<StaticMeshLodData>(LoadLodData(filePath));
+        return;
+    }
+
+    LoadLod(m_Path, 0);
+}
+
+StaticMesh::StaticMesh(const std::string& name, std::span<const StaticMeshVertex> vertices, std::span<const uint32_t> indices, const std::shared_ptr<Material>& material) :
+    m_MeshName{name},
+    m_Path{name},
+    m_MainMaterial{material}
+{
+    SetLodGeometry(0, vertices, indices);
+}
+
+void StaticMesh::FinishLoading()
+{
+    ERR_FAIL_NULL_MSG(m_PendingLod, "Static mesh wasn't loaded with deferred upload or it's already uploaded");
+
+    SetLodData(0, *m_PendingLod);
+    m_PendingLod.reset();
+}
+
+size_t StaticMesh::GetNumPendingBytes() const
+{
+    return m_PendingLod ? m_PendingLod->GetNumBytes() : 0;
+}
+
+void StaticMesh::SwapGeometry(StaticMesh& other)
+{
+    std::swap(m_Entries, other.m_Entries);
+    std::swap(m_BoundingBox, other.m_BoundingBox);
+    std::swap(m_MeshName, other.m_MeshName);
+    std::swap(TextureNames, other.TextureNames);
+
+    SetMaterial(m_MainMaterial);
+    other.SetMaterial(other.m_MainMaterial);
 }
 
 void StaticMesh::LoadLod(const std::string& filePath, int lod)
+{
+    SetLodData(lod, LoadLodData(filePath));
+}
+
+StaticMeshLodData StaticMesh::LoadLodData(const std::filesystem::path& filePath)
+{
+    StaticMeshLodData data;
+
+    // full import is slow, so it's done only once and result is cooked for next runs
+    if (!ReadCookedLod(filePath, data))
+    {
+        data = StaticMeshLodData{};
+        ImportLod(filePath, data);
+    }
+
+    return data;
+}
+
+bool StaticMesh::ReadCookedLod(const std::filesystem::path& filePath, StaticMeshLodData& outData)
+{
+    std::optional<DerivedDataKey> key = MakeCookedMeshKey(filePath, CookedMeshType::Static);
+
+    if (!key)
+    {
+        return false;
+    }
+
+    outData.CookedFile = DerivedDataCache::Load(*key);
+
+    if (!outData.CookedFile.IsOpen())
+    {
+        return false;
+    }
+
+    BinaryReader reader{DerivedDataCache::GetPayload(outData.CookedFile)};
+    CookedMeshHeader header = reader.Read<CookedMeshHeader>();
+
+    if (!header.IsValid(CookedMeshHeader::Create(CookedMeshType::Static, sizeof(StaticMeshVertex))))
+    {
+        ENG_LOG_INFO("Cooked mesh of {} has different layout", filePath.string());
+        return false;
+    }
+
+    outData.MeshName = reader.ReadString();
+    ReadEmbeddedTextures(reader, outData.Textures);
+
+    // static mesh source file always contains single lod
+    uint32_t numLods = reader.Read<uint32_t>();
+    outData.Vertices = reader.ReadArray<StaticMeshVertex>();
+    outData.Indices = reader.ReadArray<uint32_t>();
+
+    if (reader.HasFailed() || numLods != 1)
+    {
+        ENG_LOG_WARNING("Cooked mesh of {} is corrupted", filePath.string());
+        return false;
+    }
+
+    ENG_LOG_VERBOSE("Loaded cooked static mesh {}", filePath.string());
+    return true;
+}
+
+void StaticMesh::ImportLod(const std::filesystem::path& filePath, StaticMeshLodData& outData)
 {
     Assimp::Importer importer;
-    const aiScene* scene = importer.ReadFile(filePath, AssimpImportFlags);
+    const aiScene* scene = importer.ReadFile(filePath.string(), AssimpImportFlags);
 
     if (scene == nullptr)
     {
@@ -64,15 +166,16 @@ void StaticMesh::LoadLod(const std::string& filePath, int lod)
     }
 
     int totalVertices = 0;
-    int totalIndices = 0;
 
-    std::vector<StaticMeshVertex> vertices;
+    std::vector<StaticMeshVertex>& vertices = outData.ImportedVertices;
     vertices.reserve(scene->mMeshes[0]->mNumVertices);
 
     int startNumIndices = scene->mMeshes[0]->mNumFaces * 3;
-    std::vector<uint32_t> indices;
+    std::vector<uint32_t>& indices = outData.ImportedIndices;
     indices.reserve(startNumIndices);
 
+    std::vector<EmbeddedTextureData> embeddedTextures;
+
     for (uint32_t i = 0; i < scene->mNumMaterials; ++i)
     {
         aiString texturePaths;
@@ -90,10 +193,9 @@ void StaticMesh::LoadLod(const std::string& filePath, int lod)
                 length *= texture->mHeight;
             }
 
-            ResourceManager::AddTexture2D(texturePaths.C_Str(), std::make_shared<Texture2D>(
-                LoadRgbaImageFromMemory(texture->pcData, length)));
-
-            TextureNames.push_back(texturePaths.C_Str());
+            embeddedTextures.emplace_back(EmbeddedTextureData{texturePaths.C_Str(),
+                std::span<const std::byte>{reinterpret_cast<const std::byte*>(texture->pcData), static_cast<size_t>(length)}});
+            outData.Textures.emplace_back(DecodeEmbeddedTexture(embeddedTextures.back()));
         }
     }
 
@@ -117,19 +219,49 @@ void StaticMesh::LoadLod(const std::string& filePath, int lod)
 
             for (uint32_t k = 0; k < face.mNumIndices; ++k)
             {
-                indices.emplace_back(face.mIndices[k] + totalIndices);
+                indices.emplace_back(face.mIndices[k] + totalVertices);
             }
         }
 
         totalVertices += mesh->mNumVertices;
-        totalIndices += mesh->mNumFaces * 3;
     }
 
+    outData.MeshName = scene->mName.C_Str();
+    outData.Vertices = vertices;
+    outData.Indices = indices;
+    ENG_LOG_VERBOSE("Imported static mesh {}", filePath.string());
+
+    BinaryWriter writer;
+    writer.Write(CookedMeshHeader::Create(CookedMeshType::Static, sizeof(StaticMeshVertex)));
+    writer.WriteString(scene->mName.C_Str());
+    WriteEmbeddedTextures(writer, embeddedTextures);
+    writer.Write(static_cast<uint32_t>(1));
+    writer.WriteArray(std::span<const StaticMeshVertex>{vertices});
+    writer.WriteArray(std::span<const uint32_t>{indices});
+
+    if (std::optional<DerivedDataKey> key = MakeCookedMeshKey(filePath, CookedMeshType::Static))
+    {
+        DerivedDataCache::Store(*key, writer.GetData());
+    }
+}
+
+void StaticMesh::SetLodData(int lod, const StaticMeshLodData& data)
+{
+    if (m_Entries.empty())
+    {
+        m_MeshName = data.MeshName;
+    }
+
+    AddDecodedTextures(data.Textures, TextureNames);
+    SetLodGeometry(lod, data.Vertices, data.Indices);
+    ENG_LOG_VERBOSE("Loaded static mesh {} with lod={}", m_Path, lod);
+}
+
+void StaticMesh::SetLodGeometry(int lod, std::span<const StaticMeshVertex> vertices, std::span<const uint32_t> indices)
+{
     if (m_Entries.empty())
     {
-        m_MeshName = scene->mName.C_Str();
         FindAabCollision(vertices, m_BoundingBox.MinBounds, m_BoundingBox.MaxBounds);
-        m_Path = filePath;
     }
 
     if (m_Entries.size() == lod)
@@ -140,23 +272,32 @@ void StaticMesh::LoadLod(const std::string& filePath, int lod)
     {
         m_Entries[lod] = StaticMeshEntry(vertices, indices, m_MainMaterial);
     }
-
-    ENG_LOG_VERBOSE("Loaded static mesh {} with lod={}", filePath.c_str(), lod);
 }
 
-StaticMeshEntry::StaticMeshEntry(const std::vector<StaticMeshVertex>& vertices, const std::vector<uint32_t>& indices, const std::shared_ptr<Material>& material) :
+StaticMeshEntry::StaticMeshEntry(std::span<const StaticMeshVertex> vertices, std::span<const uint32_t> indices, const std::shared_ptr<Material>& material) :
     m_VertexArray(),
-    Vertices(vertices),
-    Indices(indices),
     m_Material(material)
 {
-    std::shared_ptr<IndexBuffer> indexBuffer = std::make_shared<IndexBuffer>(Indices);
+    std::shared_ptr<IndexBuffer> indexBuffer = std::make_shared<IndexBuffer>(indices);
 
-    std::shared_ptr<VertexBuffer> vertexBuffer = std::make_shared<VertexBuffer>(Vertices.data(),
-        GetTotalSizeOf(Vertices));
+    std::shared_ptr<VertexBuffer> vertexBuffer = std::make_shared<VertexBuffer>(vertices.data(),
+        GetTotalSizeOf(vertices));
 
     m_VertexArray.AddVertexBuffer(vertexBuffer, StaticMeshVertex::DataFormat);
     m_VertexArray.SetIndexBuffer(indexBuffer);
 
-    m_NumTriangles = GetContainerSizeInt(Indices) / 3;
+    m_NumIndices = GetContainerSizeInt(indices);
+    m_NumTriangles = m_NumIndices / 3;
+}
+
+size_t StaticMeshLodData::GetNumBytes() const
+{
+    size_t numBytes = Vertices.size_bytes() + Indices.size_bytes();
+
+    for (const DecodedTexture& texture : Textures)
+    {
+        numBytes += texture.Image.GetSizeInBytes();
+    }
+
+    return numBytes;
 }
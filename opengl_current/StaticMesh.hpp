@@ -5,6 +5,8 @@
 #include "Material.hpp"
 
 #include "Box.hpp"
+#include "CookedMesh.hpp"
+#include "GpuUploadQueue.hpp"
 
 #include <filesystem>
 #include <memory>
@@ -28,17 +30,14 @@ struct StaticMeshVertex
     StaticMeshVertex& operator=(const StaticMeshVertex&) = default;
 };
 
-/* Entry for one LOD for mesh. This class must be copy-constructible */
+/* Entry for one LOD for mesh. Geometry is uploaded to GPU only, vertices can come directly from mapped cooked file */
 class StaticMeshEntry
 {
     friend class InstancedMesh;
 public:
-    StaticMeshEntry(const std::vector<StaticMeshVertex>& vertices, const std::vector<uint32_t>& indices, const std::shared_ptr<Material>& material);
+    StaticMeshEntry(std::span<const StaticMeshVertex> vertices, std::span<const uint32_t> indices, const std::shared_ptr<Material>& material);
 
 public:
-    std::vector<StaticMeshVertex> Vertices;
-    std::vector<uint32_t> Indices;
-
     const VertexArray& GetVertexArray() const
     {
         return m_VertexArray;
@@ -46,7 +45,7 @@ public:
 
     int GetNumIndices() const
     {
-        return static_cast<int>(Indices.size());
+        return m_NumIndices;
     }
 
     const Material& GetMaterial() const
@@ -62,14 +61,40 @@ public:
 private:
     VertexArray m_VertexArray;
     std::shared_ptr<Material> m_Material;
+    int m_NumIndices;
     int m_NumTriangles;
 };
 
+// Geometry of single lod read from cooked file or imported from source file. Spans point either into
+// mapped cooked file or into imported arrays, so data is kept together until GPU buffers are created
+struct StaticMeshLodData
+{
+    std::string MeshName;
+    std::vector<DecodedTexture> Textures;
+    std::span<const StaticMeshVertex> Vertices;
+    std::span<const uint32_t> Indices;
+
+    MappedFile CookedFile;
+    std::vector<StaticMeshVertex> ImportedVertices;
+    std::vector<uint32_t> ImportedIndices;
+
+    size_t GetNumBytes() const;
+};
+
 class StaticMesh
 {
     friend class InstancedMesh;
 public:
-    StaticMesh(const std::filesystem::path& filePath, const std::shared_ptr<Material>& material);
+    StaticMesh(const std::filesystem::path& filePath, const std::shared_ptr<Material>& material, GpuUploadMode uploadMode = GpuUploadMode::Immediate);
+
+    // Creates mesh from geometry in memory, name is used as path of mesh
+    StaticMesh(const std::string& name, std::span<const StaticMeshVertex> vertices, std::span<const uint32_t> indices, const std::shared_ptr<Material>& material);
+
+    // Creates GPU buffers of mesh loaded with Deferred mode. Must be called on main thread
+    void FinishLoading();
+
+    // Size of data waiting for FinishLoading
+    size_t GetNumPendingBytes() const;
 
 public:
     const glm::vec3& GetBBoxMin() const;
@@ -91,6 +116,10 @@ public:
     void LoadLod(const std::string& filePath, int lod);
 
     void SetMaterial(std::shared_ptr<Material> material);
+
+    // Exchanges geometry with other mesh, material stays the same. Used when source file of mesh is reimported
+    void SwapGeometry(StaticMesh& other);
+
     const std::string& GetPath() const
     {
         return m_Path;
@@ -102,6 +131,19 @@ private:
     std::string m_MeshName;
     std::string m_Path;
     std::shared_ptr<Material> m_MainMaterial;
+    std::unique_ptr<StaticMeshLodData> m_PendingLod;
+
+private:
+    // Reads lod from cooked .mesh file, or imports and cooks source file when cooked file is missing or stale.
+    // Touches only CPU data, so it can be run on loading threads
+    static StaticMeshLodData LoadLodData(const std::filesystem::path& filePath);
+
+    // Returns false when cooked file is missing or stale
+    static bool ReadCookedLod(const std::filesystem::path& filePath, StaticMeshLodData& outData);
+    static void ImportLod(const std::filesystem::path& filePath, StaticMeshLodData& outData);
+
+    void SetLodData(int lod, const StaticMeshLodData& data);
+    void SetLodGeometry(int lod, std::span<const StaticMeshVertex> vertices, std::span<const uint32_t> indices);
 };
 
 struct MeshKey
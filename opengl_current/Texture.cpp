@@ -3,8 +3,13 @@
 #include "ErrorMacros.hpp"
 #include "Logging.hpp"
 #include "RendererApi.hpp"
+#include "Renderer.hpp"
+#include "TextureCompression.hpp"
+#include "ResourceManager.hpp"
+#include "ThreadPool.hpp"
 
 #include <GL/glew.h>
+#include <cstring>
 #include <iostream>
 
 #define STB_IMAGE_IMPLEMENTATION // Ensure that stb_image implementation is included in one source file
@@ -72,6 +77,12 @@ static GLenum ConvertTextureFormatToDataFormat(TextureFormat format)
         return GL_RGB;
     case TextureFormat::Rgba:
         return GL_RGBA;
+    case TextureFormat::Bc1:
+        return GL_RGB;
+    case TextureFormat::Bc3:
+        return GL_RGBA;
+    case TextureFormat::Bc5:
+        return GL_RG;
     }
 
     return 0;
@@ -85,17 +96,24 @@ static GLenum ConvertTextureFormatToInternalFormat(TextureFormat format)
         return GL_RGB8;
     case TextureFormat::Rgba:
         return GL_RGBA8;
+    case TextureFormat::Bc1:
+        return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    case TextureFormat::Bc3:
+        return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    case TextureFormat::Bc5:
+        return GL_COMPRESSED_RG_RGTC2;
     }
 
     return 0;
 }
 
-static StbiImageUniquePtr MakeImageUniquePtrFromMemory(const void* data, int length, StbiImageData& outImageData);
+static StbiImageUniquePtr MakeImageUniquePtrFromMemory(const void* data, int length, StbiImageData& outImageData, int desiredNumComps = 0);
 
-static StbiImageUniquePtr LoadImageFromFilePath(const std::string& filePath, StbiImageData& outImageData)
+// when desiredNumComps is set, decoder converts image to that number of components
+static StbiImageUniquePtr LoadImageFromFilePath(const std::string& filePath, StbiImageData& outImageData, int desiredNumComps = 0)
 {
     uint8_t* image = stbi_load(filePath.c_str(), &outImageData.Width, &outImageData.Height,
-        &outImageData.NumComps, 0);
+        &outImageData.NumComps, desiredNumComps);
 
     if (image == nullptr)
     {
@@ -121,14 +139,17 @@ Texture2D::Texture2D(const std::filesystem::path& filePath)
 
     m_InternalDataFormat = imageData.GetInternalFormat();
     m_DataFormat = imageData.GetDataFormat();
+    m_Format = imageData.IsRgb() ? TextureFormat::Rgb : TextureFormat::Rgba;
 
     GenerateTexture2D(data.get());
 }
 
 Texture2D::Texture2D(const void* data, const TextureSpecification& specification) :
     m_Width{specification.Width},
-    m_Height{specification.Height}
+    m_Height{specification.Height},
+    m_Format{specification.Format}
 {
+    ASSERT(!IsCompressedTextureFormat(specification.Format));
 
     m_InternalDataFormat = ConvertTextureFormatToInternalFormat(specification.Format);
     m_DataFormat = ConvertTextureFormatToDataFormat(specification.Format);
@@ -141,6 +162,17 @@ Texture2D::Texture2D(const ImageRgba& image) :
 {
 }
 
+Texture2D::Texture2D(const CompressedImage& image, int numDroppedMips) :
+    m_Width{image.Width},
+    m_Height{image.Height},
+    m_Format{image.Format}
+{
+    m_InternalDataFormat = ConvertTextureFormatToInternalFormat(image.Format);
+    m_DataFormat = ConvertTextureFormatToDataFormat(image.Format);
+
+    GenerateCompressedTexture2D(image, numDroppedMips);
+}
+
 Texture2D::Texture2D(const TextureSpecification& specification) :
     Texture2D(nullptr, specification)
 {
@@ -148,14 +180,7 @@ Texture2D::Texture2D(const TextureSpecification& specification) :
 
 Texture2D::~Texture2D()
 {
-    int numComponents = 3;
-
-    if (m_DataFormat == GL_RGBA)
-    {
-        numComponents = 4;
-    }
-
-    s_NumTextureVramUsed -= m_Width * m_Height * numComponents;
+    s_NumTextureVramUsed -= m_NumBytesInVram;
     glDeleteTextures(1, &m_RendererId);
 }
 
@@ -186,25 +211,44 @@ bool Texture2D::IsMipmapped() const
 
 bool Texture2D::IsTranslucent() const
 {
-    return GetTextureFormat() == TextureFormat::Rgba;
+    return m_bHasTranslucentPixels;
 }
 
 void Texture2D::GenerateMipmaps()
 {
-    glGenerateMipmap(m_RendererId);
-    m_bHasMipmaps = true;
+    // compressed formats can't be filtered on GPU, their mips are cooked with texture
+    if (IsCompressedTextureFormat(m_Format))
+    {
+        ERR_FAIL_EXPECTED_TRUE_MSG(m_NumMips > 1, "Compressed texture without cooked mip chain can't generate mipmaps");
+        return;
+    }
+
+    // uncompressed texture is created with single level, glGenerateTextureMipmap fills only allocated levels
+    if (m_NumMips == 1)
+    {
+        AllocateMipChain();
+    }
+
+    glGenerateTextureMipmap(m_RendererId);
+    m_bHasMipmaps = m_NumMips > 1;
+    SetFilteringType(m_FilteringType);
 }
 
 TextureFormat Texture2D::GetTextureFormat() const
 {
-    return m_DataFormat == GL_RGB ? TextureFormat::Rgb : TextureFormat::Rgba;
+    return m_Format;
 }
 
 static GLenum FilteringTypes[] = {GL_LINEAR, GL_NEAREST};
 
+static GLenum MipmapFilteringTypes[] = {GL_LINEAR_MIPMAP_LINEAR, GL_NEAREST_MIPMAP_NEAREST};
+
 void Texture2D::SetFilteringType(FilteringType filteringType)
 {
-    glTextureParameteri(m_RendererId, GL_TEXTURE_MIN_FILTER, FilteringTypes[(size_t)filteringType]);
+    m_FilteringType = filteringType;
+
+    GLenum minFilter = m_bHasMipmaps ? MipmapFilteringTypes[(size_t)filteringType] : FilteringTypes[(size_t)filteringType];
+    glTextureParameteri(m_RendererId, GL_TEXTURE_MIN_FILTER, minFilter);
     glTextureParameteri(m_RendererId, GL_TEXTURE_MAG_FILTER, FilteringTypes[(size_t)filteringType]);
 }
 
@@ -213,6 +257,91 @@ const char* Texture2D::GetName() const
     return m_LoadPath.c_str();
 }
 
+void Texture2D::Swap(Texture2D& other)
+{
+    std::swap(m_RendererId, other.m_RendererId);
+    std::swap(m_Width, other.m_Width);
+    std::swap(m_Height, other.m_Height);
+    std::swap(m_DataFormat, other.m_DataFormat);
+    std::swap(m_InternalDataFormat, other.m_InternalDataFormat);
+    std::swap(m_Format, other.m_Format);
+    std::swap(m_NumBytesInVram, other.m_NumBytesInVram);
+    std::swap(m_NumMips, other.m_NumMips);
+    std::swap(m_NumDroppedMips, other.m_NumDroppedMips);
+    std::swap(m_FilteringType, other.m_FilteringType);
+    std::swap(m_LoadPath, other.m_LoadPath);
+
+    // bit field can't be bound to reference
+    bool bHasMipmaps = m_bHasMipmaps;
+    m_bHasMipmaps = other.m_bHasMipmaps;
+    other.m_bHasMipmaps = bHasMipmaps;
+
+    bool bHasTranslucentPixels = m_bHasTranslucentPixels;
+    m_bHasTranslucentPixels = other.m_bHasTranslucentPixels;
+    other.m_bHasTranslucentPixels = bHasTranslucentPixels;
+}
+
+static bool HasTranslucentPixels(std::span<const std::byte> rgbaPixels)
+{
+    for (size_t i = 3; i < rgbaPixels.size(); i += 4)
+    {
+        if (rgbaPixels[i] != std::byte{255})
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// BC3 block starts with 2 alpha endpoints and 16 3 bit indices into palette derived from them
+static bool HasTranslucentBc3Blocks(std::span<const std::byte> blocks)
+{
+    constexpr size_t NumBytesPerBlock = 16;
+
+    for (size_t offset = 0; offset + NumBytesPerBlock <= blocks.size(); offset += NumBytesPerBlock)
+    {
+        uint32_t alpha0 = static_cast<uint32_t>(blocks[offset]);
+        uint32_t alpha1 = static_cast<uint32_t>(blocks[offset + 1]);
+        uint32_t palette[8] = {alpha0, alpha1};
+
+        if (alpha0 > alpha1)
+        {
+            for (uint32_t i = 2; i < 8; ++i)
+            {
+                palette[i] = ((8 - i) * alpha0 + (i - 1) * alpha1) / 7;
+            }
+        }
+        else
+        {
+            for (uint32_t i = 2; i < 6; ++i)
+            {
+                palette[i] = ((6 - i) * alpha0 + (i - 1) * alpha1) / 5;
+            }
+
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+
+        uint64_t indices = 0;
+
+        for (size_t i = 0; i < 6; ++i)
+        {
+            indices |= static_cast<uint64_t>(blocks[offset + 2 + i]) << (8 * i);
+        }
+
+        for (int pixel = 0; pixel < 16; ++pixel)
+        {
+            if (palette[(indices >> (3 * pixel)) & 0x7] != 255)
+            {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
 void Texture2D::GenerateTexture2D(const void* data)
 {
     glCreateTextures(GL_TEXTURE_2D, 1, &m_RendererId);
@@ -221,10 +350,11 @@ void Texture2D::GenerateTexture2D(const void* data)
 
     glTextureStorage2D(m_RendererId, 1, m_InternalDataFormat, m_Width, m_Height);
 
+    // content of empty texture isn't known, so it's translucent when it can be
+    m_bHasTranslucentPixels = m_DataFormat == GL_RGBA;
+
     if (data != nullptr)
     {
-        glTextureSubImage2D(m_RendererId, 0, 0, 0, m_Width, m_Height, m_DataFormat, GL_UNSIGNED_BYTE, data);
-
         int numComponents = 3;
 
         if (m_DataFormat == GL_RGBA)
@@ -232,10 +362,92 @@ void Texture2D::GenerateTexture2D(const void* data)
             numComponents = 4;
         }
 
-        s_NumTextureVramUsed += m_Width * m_Height * numComponents;
+        size_t numBytes = static_cast<size_t>(m_Width) * m_Height * numComponents;
+        std::span<const std::byte> pixels{static_cast<const std::byte*>(data), numBytes};
+        Renderer::UploadTexturePixels(TextureUploadRegion{m_RendererId, m_Width, m_Height, -1, m_DataFormat}, pixels);
+        m_bHasTranslucentPixels = numComponents == 4 && HasTranslucentPixels(pixels);
+
+        m_NumBytesInVram = numBytes;
+        s_NumTextureVramUsed += m_NumBytesInVram;
     }
 }
 
+void Texture2D::GenerateCompressedTexture2D(const CompressedImage& image, int numDroppedMips)
+{
+    glCreateTextures(GL_TEXTURE_2D, 1, &m_RendererId);
+
+    SetStandardTextureOptions();
+
+    if (image.MipLevels.empty())
+    {
+        glTextureStorage2D(m_RendererId, 1, m_InternalDataFormat, m_Width, m_Height);
+        m_bHasTranslucentPixels = m_Format == TextureFormat::Bc3;
+        return;
+    }
+
+    // top levels are skipped, the smallest level is always kept
+    m_NumDroppedMips = std::clamp(numDroppedMips, 0, image.GetNumMips() - 1);
+    m_NumMips = image.GetNumMips() - m_NumDroppedMips;
+    m_Width = GetMipSize(image.Width, m_NumDroppedMips);
+    m_Height = GetMipSize(image.Height, m_NumDroppedMips);
+
+    glTextureStorage2D(m_RendererId, m_NumMips, m_InternalDataFormat, m_Width, m_Height);
+
+    // BC1 is sampled as RGB and BC5 has no alpha, smaller mips are averaged from the first level so only it is checked
+    m_bHasTranslucentPixels = m_Format == TextureFormat::Bc3 && HasTranslucentBc3Blocks(image.MipLevels[m_NumDroppedMips]);
+
+    // only uploaded levels are counted in VRAM
+    for (int level = 0; level < m_NumMips; ++level)
+    {
+        std::span<const std::byte> blocks = image.MipLevels[m_NumDroppedMips + level];
+        Renderer::UploadTexturePixels(TextureUploadRegion{m_RendererId, GetMipSize(m_Width, level), GetMipSize(m_Height, level),
+            -1, m_DataFormat, m_InternalDataFormat, level}, blocks);
+
+        // blocks are stored in VRAM as they are, so compressed size is what texture takes
+        m_NumBytesInVram += blocks.size();
+    }
+
+    s_NumTextureVramUsed += m_NumBytesInVram;
+
+    if (m_NumMips > 1)
+    {
+        m_bHasMipmaps = true;
+        glTextureParameteri(m_RendererId, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    }
+}
+
+void Texture2D::AllocateMipChain()
+{
+    int numMips = GetNumMipLevels(m_Width, m_Height);
+
+    if (numMips == m_NumMips)
+    {
+        return;
+    }
+
+    uint32_t rendererId = 0;
+    glCreateTextures(GL_TEXTURE_2D, 1, &rendererId);
+    glTextureStorage2D(rendererId, numMips, m_InternalDataFormat, m_Width, m_Height);
+
+    // storage is immutable, so base level is copied on GPU to new texture with full chain
+    glCopyImageSubData(m_RendererId, GL_TEXTURE_2D, 0, 0, 0, 0, rendererId, GL_TEXTURE_2D, 0, 0, 0, 0, m_Width, m_Height, 1);
+    glDeleteTextures(1, &m_RendererId);
+
+    m_RendererId = rendererId;
+    SetStandardTextureOptions();
+
+    size_t numBytesPerPixel = m_DataFormat == GL_RGBA ? 4 : 3;
+
+    for (int level = m_NumMips; level < numMips; ++level)
+    {
+        size_t numLevelBytes = numBytesPerPixel * GetMipSize(m_Width, level) * GetMipSize(m_Height, level);
+        m_NumBytesInVram += numLevelBytes;
+        s_NumTextureVramUsed += numLevelBytes;
+    }
+
+    m_NumMips = numMips;
+}
+
 void Texture2D::SetStandardTextureOptions()
 {
     // Set texture wrapping and filtering options
@@ -245,66 +457,217 @@ void Texture2D::SetStandardTextureOptions()
     glTextureParameteri(m_RendererId, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 }
 
-static StbiImageUniquePtr ConvertRgbToRgbaImage(const uint8_t* rgbImage, const StbiImageData& imageData)
+StbiImageUniquePtr MakeImageUniquePtrFromMemory(const void* data, int length, StbiImageData& outImageData, int desiredNumComps)
+{
+    ASSERT(data);
+
+    uint8_t* imageData = stbi_load_from_memory(
+        reinterpret_cast<const uint8_t*>(data), length, &outImageData.Width,
+        &outImageData.Height, &outImageData.NumComps, desiredNumComps);
+
+    if (!imageData)
+    {
+        throw std::runtime_error(stbi_failure_reason());
+    }
+
+    return StbiImageUniquePtr(imageData);
+}
+
+static void FreeStbiImage(void* image)
+{
+    stbi_image_free(image);
+}
+
+ImageRgba LoadRgbaImageFromMemory(const void* data, int length)
+{
+    // decoder converts image to RGBA itself, so decoded buffer is adopted by image without copy
+    StbiImageData imageData;
+    StbiImageUniquePtr img = MakeImageUniquePtrFromMemory(data, length, imageData, STBI_rgb_alpha);
+
+    return ImageRgba{img.release(), imageData.Width, imageData.Height, &FreeStbiImage};
+}
+
+ImageRgba LoadRgbaImageFromFile(const std::filesystem::path& filePath, bool bFlipVertically)
+{
+    // flip flag of calling thread is used, so loading threads don't race with textures loaded on main thread
+    stbi_set_flip_vertically_on_load_thread(bFlipVertically ? 1 : 0);
+
+    StbiImageData imageData;
+    StbiImageUniquePtr img = LoadImageFromFilePath(filePath.string(), imageData, STBI_rgb_alpha);
+
+    return ImageRgba{img.release(), imageData.Width, imageData.Height, &FreeStbiImage};
+}
+
+Texture2DArray::Texture2DArray(const TextureSpecification& specification, int numMips) :
+    m_Width{specification.Width},
+    m_Height{specification.Height},
+    m_NumMips{std::max(numMips, 1)},
+    m_Format{specification.Format}
 {
-    ASSERT(rgbImage);
+    ASSERT(specification.Format != TextureFormat::Rgb);
 
-    const RgbColor* rgbColor = reinterpret_cast<const RgbColor*>(rgbImage);
-    size_t length = sizeof(RgbaColor) * imageData.GetNumPixels();
-    RgbaColor* imgData = reinterpret_cast<RgbaColor*>(STBI_MALLOC(length));
+    m_InternalDataFormat = ConvertTextureFormatToInternalFormat(m_Format);
+    m_DataFormat = ConvertTextureFormatToDataFormat(m_Format);
+    m_Name = "TextureArray" + std::to_string(m_Width) + "x" + std::to_string(m_Height);
 
-    if (imgData == nullptr)
+    for (int level = 0; level < m_NumMips; ++level)
     {
-        throw std::runtime_error("Cannot convert image to RGBA out of memory");
+        int mipWidth = GetMipSize(m_Width, level);
+        int mipHeight = GetMipSize(m_Height, level);
+
+        m_NumBytesPerLayer += IsCompressedTextureFormat(m_Format) ? GetCompressedImageSize(m_Format, mipWidth, mipHeight) :
+            4 * static_cast<size_t>(mipWidth) * mipHeight;
     }
 
-    for (int x = 0; x < imageData.Width; ++x)
+    Reserve(1);
+}
+
+Texture2DArray::~Texture2DArray()
+{
+    Texture2D::s_NumTextureVramUsed -= m_NumBytesPerLayer * m_Capacity;
+    glDeleteTextures(1, &m_RendererId);
+}
+
+int Texture2DArray::GetWidth() const
+{
+    return m_Width;
+}
+
+int Texture2DArray::GetHeight() const
+{
+    return m_Height;
+}
+
+void Texture2DArray::Bind(uint32_t textureUnit) const
+{
+    glBindTextureUnit(textureUnit, m_RendererId);
+}
+
+void Texture2DArray::Unbind(uint32_t textureUnit)
+{
+    glBindTextureUnit(textureUnit, 0);
+}
+
+bool Texture2DArray::IsMipmapped() const
+{
+    return m_NumMips > 1;
+}
+
+bool Texture2DArray::IsTranslucent() const
+{
+    return m_Format == TextureFormat::Rgba || m_Format == TextureFormat::Bc3;
+}
+
+void Texture2DArray::GenerateMipmaps()
+{
+    // mips of each layer are uploaded with it
+}
+
+TextureFormat Texture2DArray::GetTextureFormat() const
+{
+    return m_Format;
+}
+
+void Texture2DArray::SetFilteringType(FilteringType filteringType)
+{
+    m_FilteringType = filteringType;
+
+    GLenum minFilter = IsMipmapped() ? MipmapFilteringTypes[(size_t)filteringType] : FilteringTypes[(size_t)filteringType];
+    glTextureParameteri(m_RendererId, GL_TEXTURE_MIN_FILTER, minFilter);
+    glTextureParameteri(m_RendererId, GL_TEXTURE_MAG_FILTER, FilteringTypes[(size_t)filteringType]);
+}
+
+const char* Texture2DArray::GetName() const
+{
+    return m_Name.c_str();
+}
+
+int Texture2DArray::AddLayer(const ImageRgba& image)
+{
+    ERR_FAIL_EXPECTED_TRUE_V_MSG(m_Format == TextureFormat::Rgba, "Texture array stores compressed images", -1);
+    ERR_FAIL_EXPECTED_TRUE_V_MSG(image.GetWidth() == m_Width && image.GetHeight() == m_Height, "Image has different size than texture array", -1);
+
+    Reserve(m_NumLayers + 1);
+    int layer = m_NumLayers++;
+
+    auto uploadLevel = [this, layer](const ImageRgba& level, int mipLevel)
     {
-        for (int y = 0; y < imageData.Height; ++y)
-        {
-            int index = x + y * imageData.Width;
+        Renderer::UploadTexturePixels(TextureUploadRegion{m_RendererId, level.GetWidth(), level.GetHeight(), layer, m_DataFormat, 0, mipLevel},
+            std::span<const std::byte>{reinterpret_cast<const std::byte*>(level.GetRawImageData()), level.GetSizeInBytes()});
+    };
+
+    uploadLevel(image, 0);
+
+    if (m_NumMips > 1)
+    {
+        // glGenerateTextureMipmap would filter every layer again, so only mips of new layer are filtered
+        std::vector<ImageRgba> mips = GenerateMipChain(image, true);
 
-            const RgbColor& c = rgbColor[index];
-            imgData[index] = RgbaColor(c.Red, c.Green, c.Blue);
+        for (int level = 1; level < m_NumMips && level - 1 < static_cast<int>(mips.size()); ++level)
+        {
+            uploadLevel(mips[level - 1], level);
         }
     }
 
-    return StbiImageUniquePtr(reinterpret_cast<uint8_t*>(imgData));
+    return layer;
 }
 
-StbiImageUniquePtr MakeImageUniquePtrFromMemory(const void* data, int length, StbiImageData& outImageData)
+int Texture2DArray::AddLayer(const CompressedImage& image)
 {
-    ASSERT(data);
+    ERR_FAIL_EXPECTED_TRUE_V_MSG(image.Format == m_Format, "Image has different format than texture array", -1);
+    ERR_FAIL_EXPECTED_TRUE_V_MSG(image.Width == m_Width && image.Height == m_Height && image.GetNumMips() == m_NumMips,
+        "Image has different size than texture array", -1);
 
-    uint8_t* imageData = stbi_load_from_memory(
-        reinterpret_cast<const uint8_t*>(data), length, &outImageData.Width,
-        &outImageData.Height, &outImageData.NumComps, 0);
+    Reserve(m_NumLayers + 1);
+    int layer = m_NumLayers++;
 
-    if (!imageData)
+    for (int level = 0; level < m_NumMips; ++level)
     {
-        throw std::runtime_error(stbi_failure_reason());
+        Renderer::UploadTexturePixels(TextureUploadRegion{m_RendererId, GetMipSize(m_Width, level), GetMipSize(m_Height, level),
+            layer, m_DataFormat, m_InternalDataFormat, level}, image.MipLevels[level]);
     }
 
-    return StbiImageUniquePtr(imageData);
+    return layer;
 }
 
-ImageRgba LoadRgbaImageFromMemory(const void* data, int length)
+void Texture2DArray::Reserve(int numLayers)
 {
-    StbiImageData imageData;
-    StbiImageUniquePtr img = MakeImageUniquePtrFromMemory(data, length, imageData);
+    if (numLayers <= m_Capacity)
+    {
+        return;
+    }
+
+    int capacity = std::max(numLayers, 2 * m_Capacity);
+    uint32_t rendererId = 0;
 
-    if (imageData.IsRgb())
+    glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &rendererId);
+    glTextureStorage3D(rendererId, m_NumMips, m_InternalDataFormat, m_Width, m_Height, capacity);
+
+    glTextureParameteri(rendererId, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTextureParameteri(rendererId, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+    if (m_RendererId != 0)
     {
-        img = ConvertRgbToRgbaImage(img.get(), imageData);
+        // layers are copied on GPU, so images don't have to be kept in memory
+        for (int level = 0; level < m_NumMips; ++level)
+        {
+            glCopyImageSubData(m_RendererId, GL_TEXTURE_2D_ARRAY, level, 0, 0, 0, rendererId, GL_TEXTURE_2D_ARRAY, level, 0, 0, 0,
+                GetMipSize(m_Width, level), GetMipSize(m_Height, level), m_NumLayers);
+        }
+
+        glDeleteTextures(1, &m_RendererId);
     }
 
-    return ImageRgba{img.get(), imageData.Width, imageData.Height};
+    Texture2D::s_NumTextureVramUsed += m_NumBytesPerLayer * (capacity - m_Capacity);
+    m_RendererId = rendererId;
+    m_Capacity = capacity;
+
+    // new texture object has default parameters, so filtering chosen before growing is applied again
+    SetFilteringType(m_FilteringType);
 }
 
 CubeMap::CubeMap(std::span<const std::string> paths)
 {
-    // Flip the image vertically if needed
-    stbi_set_flip_vertically_on_load(0);
     glCreateTextures(GL_TEXTURE_CUBE_MAP, 1, &m_RendererId);
     glTextureParameteri(m_RendererId, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTextureParameteri(m_RendererId, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
@@ -312,57 +675,123 @@ CubeMap::CubeMap(std::span<const std::string> paths)
     glTextureParameteri(m_RendererId, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTextureParameteri(m_RendererId, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-    glBindTextureUnit(0, m_RendererId);
-
     m_Name += "CubeMap{";
 
     for (uint32_t i = 0; i < paths.size(); ++i)
     {
-        const std::string& path = paths[i];
-        
-        m_Name += path;
+        m_Name += paths[i];
 
         if (i != paths.size() - 1)
         {
             m_Name += ", ";
         }
+    }
 
-        StbiImageData imageData;
+    m_Name += "}";
 
-        StbiImageUniquePtr image = LoadImageFromFilePath(path, imageData);
+    ERR_FAIL_EXPECTED_TRUE_MSG(paths.size() == CubeMapTextureIndex::Count, "Cube map needs path for each of 6 faces");
 
-        GLenum internalDataFormat = imageData.GetInternalFormat();
-        GLenum dataFormat = imageData.GetDataFormat();
+    // faces are decoded on loading threads, so it overlaps with loading of other assets until cube map is bound first time
+    for (const std::string& path : paths)
+    {
+        std::shared_ptr<std::promise<ImageRgba>> decodedFace = std::make_shared<std::promise<ImageRgba>>();
+        m_FaceDecodes.emplace_back(decodedFace->get_future());
 
-        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i,
-            0, dataFormat, imageData.Width, imageData.Height,
-            0, dataFormat, GL_UNSIGNED_BYTE, image.get()
-        );
+        ResourceManager::GetLoadingThreadPool().Enqueue([path, decodedFace]()
+        {
+            try
+            {
+                decodedFace->set_value(LoadRgbaImageFromFile(path, false));
+            }
+            catch (...)
+            {
+                decodedFace->set_exception(std::current_exception());
+            }
+        });
+    }
+}
 
-        int numBytesUsed = imageData.NumComps * imageData.GetNumPixels();
-        Texture2D::s_NumTextureVramUsed += numBytesUsed;
+void CubeMap::FinishLoading() const
+{
+    if (m_NumVramBytes != 0)
+    {
+        return;
     }
 
-    m_Name += "}";
+    std::vector<ImageRgba> faces;
+    bool bValid = m_FaceDecodes.size() == CubeMapTextureIndex::Count;
+
+    // all faces are validated before storage is allocated, so cube map is never left partially uploaded
+    for (std::future<ImageRgba>& faceDecode : m_FaceDecodes)
+    {
+        try
+        {
+            faces.emplace_back(faceDecode.get());
+        }
+        catch (const std::exception& e)
+        {
+            ENG_LOG_ERROR("Failed to load face of {}: {}", m_Name, e.what());
+            bValid = false;
+        }
+    }
+
+    m_FaceDecodes.clear();
+
+    for (const ImageRgba& face : faces)
+    {
+        bValid = bValid && face.GetWidth() == faces[0].GetWidth() && face.GetHeight() == faces[0].GetHeight();
+    }
+
+    if (!bValid)
+    {
+        ENG_LOG_ERROR("Cube map {} needs 6 faces of the same size, it's filled with black", m_Name);
+        faces.clear();
+
+        for (int face = 0; face < CubeMapTextureIndex::Count; ++face)
+        {
+            ImageRgba& image = faces.emplace_back(1, 1);
+            std::memset(image.GetRawImageData(), 0, image.GetSizeInBytes());
+        }
+    }
+
+    m_Width = faces[0].GetWidth();
+    m_Height = faces[0].GetHeight();
+
+    glTextureStorage2D(m_RendererId, 1, GL_RGBA8, m_Width, m_Height);
+
+    for (int face = 0; face < CubeMapTextureIndex::Count; ++face)
+    {
+        const ImageRgba& image = faces[face];
+
+        Renderer::UploadTexturePixels(TextureUploadRegion{m_RendererId, m_Width, m_Height, face, GL_RGBA},
+            std::span<const std::byte>{reinterpret_cast<const std::byte*>(image.GetRawImageData()), image.GetSizeInBytes()});
+    }
+
+    m_NumVramBytes = 4 * static_cast<size_t>(m_Width) * m_Height * CubeMapTextureIndex::Count;
+    Texture2D::s_NumTextureVramUsed += m_NumVramBytes;
 }
 
 CubeMap::~CubeMap()
 {
+    Texture2D::s_NumTextureVramUsed -= m_NumVramBytes;
     glDeleteTextures(1, &m_RendererId);
 }
 
 int CubeMap::GetWidth() const
 {
-    return 0;
+    FinishLoading();
+    return m_Width;
 }
 
 int CubeMap::GetHeight() const
 {
-    return 0;
+    FinishLoading();
+    return m_Height;
 }
 
 void CubeMap::Bind(uint32_t textureUnit) const
 {
+    FinishLoading();
     glBindTextureUnit(textureUnit, m_RendererId);
 }
 
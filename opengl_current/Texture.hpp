@@ -6,6 +6,8 @@
 #include <glm/glm.hpp>
 
 #include <filesystem>
+#include <future>
+#include <memory>
 #include <span>
 
 #include "ImageRgba.hpp"
@@ -13,9 +15,16 @@
 enum class TextureFormat
 {
     Rgb,
-    Rgba
+    Rgba,
+
+    // block compressed formats, 4x4 pixels are stored in 8 (BC1) or 16 bytes
+    Bc1,
+    Bc3,
+    Bc5
 };
 
+struct CompressedImage;
+
 struct TextureSpecification
 {
     int Width;
@@ -58,6 +67,8 @@ public:
     Texture2D(const std::filesystem::path& filePath);
     Texture2D(const void* data, const TextureSpecification& specification);
     Texture2D(const ImageRgba& image);
+    // Top numDroppedMips levels of cooked mip chain aren't uploaded, the smallest level is always kept
+    Texture2D(const CompressedImage& image, int numDroppedMips = 0);
     Texture2D(const TextureSpecification& specification);
     virtual ~Texture2D();
 
@@ -79,6 +90,24 @@ public:
     virtual void SetFilteringType(FilteringType filteringType) override;
     virtual const char* GetName() const override;
 
+    // Exchanges GPU texture with other texture, so reloaded texture is seen by everything holding this one
+    void Swap(Texture2D& other);
+
+    int GetNumMips() const
+    {
+        return m_NumMips;
+    }
+
+    int GetNumDroppedMips() const
+    {
+        return m_NumDroppedMips;
+    }
+
+    size_t GetNumBytesInVram() const
+    {
+        return m_NumBytesInVram;
+    }
+
     static inline size_t s_NumTextureVramUsed = 0;
 
 private:
@@ -87,14 +116,95 @@ private:
     int m_Height;
     uint32_t m_DataFormat{0};
     uint32_t m_InternalDataFormat{0};
+    TextureFormat m_Format{TextureFormat::Rgb};
+    size_t m_NumBytesInVram{0};
+    int m_NumMips{1};
+    int m_NumDroppedMips{0};
+    FilteringType m_FilteringType{FilteringType::Linear};
     bool m_bHasMipmaps : 1{false};
+
+    // set at load when any pixel has alpha below 255, texture without pixels is translucent when format has alpha
+    bool m_bHasTranslucentPixels : 1{false};
     std::string m_LoadPath;
 
 private:
     void GenerateTexture2D(const void* data);
+    void GenerateCompressedTexture2D(const CompressedImage& image, int numDroppedMips);
+    void AllocateMipChain();
     void SetStandardTextureOptions();
 };
 
+// Number of layers after which texture array packer starts new array. OpenGL 4.3 guarantees at least 2048
+inline constexpr int MaxTextureArrayLayers = 256;
+
+// Texture where all layers have the same size, format and number of mips. Material binds array once and selects
+// layer by index, so meshes using different textures can be drawn with the same state
+class Texture2DArray : public ITexture
+{
+public:
+    Texture2DArray(const TextureSpecification& specification, int numMips);
+    virtual ~Texture2DArray();
+
+public:
+    virtual int GetWidth() const override;
+    virtual int GetHeight() const override;
+
+    virtual void Bind(uint32_t textureUnit) const override;
+    virtual void Unbind(uint32_t textureUnit) override;
+
+    virtual bool IsMipmapped() const override;
+    virtual bool IsTranslucent() const override;
+
+    virtual void GenerateMipmaps() override;
+
+    virtual uint32_t GetRendererId() const override;
+
+    virtual TextureFormat GetTextureFormat() const override;
+    virtual void SetFilteringType(FilteringType filteringType) override;
+    virtual const char* GetName() const override;
+
+    int GetNumLayers() const
+    {
+        return m_NumLayers;
+    }
+
+    int GetNumMips() const
+    {
+        return m_NumMips;
+    }
+
+    // Appends image as new layer and returns its index. Image must have size of array, its mips are generated here.
+    // Storage is doubled when array is full, existing layers are copied on GPU
+    int AddLayer(const ImageRgba& image);
+
+    // Compressed image must have size, format and number of mips of array
+    int AddLayer(const CompressedImage& image);
+
+private:
+    uint32_t m_RendererId{0};
+    int m_Width;
+    int m_Height;
+    int m_NumMips;
+    int m_NumLayers{0};
+    int m_Capacity{0};
+    TextureFormat m_Format;
+    uint32_t m_DataFormat{0};
+    uint32_t m_InternalDataFormat{0};
+    size_t m_NumBytesPerLayer{0};
+    FilteringType m_FilteringType{FilteringType::Linear};
+    std::string m_Name;
+
+private:
+    void Reserve(int numLayers);
+};
+
+// Texture packed in array, see ResourceManager::GetTextureArrayLayer
+struct TextureArrayLayer
+{
+    std::shared_ptr<Texture2DArray> Array;
+    int Layer{0};
+};
+
 struct CubeMapTextureIndex
 {
     enum Index
@@ -132,15 +242,34 @@ public:
 private:
     uint32_t m_RendererId;
     std::string m_Name;
+    mutable int m_Width{0};
+    mutable int m_Height{0};
+    mutable size_t m_NumVramBytes{0};
+
+    // faces decoded on loading threads, uploaded on first use
+    mutable std::vector<std::future<ImageRgba>> m_FaceDecodes;
+
+private:
+    // waits for decoded faces and uploads them, does nothing when they're already uploaded.
+    // When any face fails to load or faces differ in size, cube map is filled with black
+    void FinishLoading() const;
 };
 
 ImageRgba LoadRgbaImageFromMemory(const void* data, int length);
 
+// Decodes image file (by default flipped vertically like Texture2D does). Doesn't touch OpenGL, so it can be used on loading threads
+ImageRgba LoadRgbaImageFromFile(const std::filesystem::path& filePath, bool bFlipVertically = true);
+
 inline uint32_t Texture2D::GetRendererId() const
 {
     return m_RendererId;
 }
 
+inline uint32_t Texture2DArray::GetRendererId() const
+{
+    return m_RendererId;
+}
+
 inline uint32_t CubeMap::GetRendererId() const
 {
     return m_RendererId;
@@ -0,0 +1,499 @@
+#include "TextureCompression.hpp"
+#include "CookedMesh.hpp"
+#include "DerivedDataCache.hpp"
+#include "ErrorMacros.hpp"
+#include "Logging.hpp"
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#if TEXTURE_COMPRESSION_SSE
+#include <emmintrin.h>
+#endif
+
+constexpr int BlockSize = 4;
+constexpr int NumBlockPixels = BlockSize * BlockSize;
+
+// 4x4 pixels of image in RGBA order, row after row
+struct PixelBlock
+{
+    alignas(16) uint8_t Pixels[NumBlockPixels * 4];
+};
+
+static size_t GetBlockSizeInBytes(TextureFormat format)
+{
+    return format == TextureFormat::Bc1 ? 8 : 16;
+}
+
+static void LoadPixelBlock(const ImageRgba& image, int blockX, int blockY, PixelBlock& outBlock)
+{
+    const uint8_t* pixels = image.GetRawImageData();
+    int width = image.GetWidth();
+    int height = image.GetHeight();
+
+    for (int y = 0; y < BlockSize; ++y)
+    {
+        // blocks on edge of image that isn't multiple of 4 repeat last row and column
+        int sourceY = std::min(blockY * BlockSize + y, height - 1);
+
+        for (int x = 0; x < BlockSize; ++x)
+        {
+            int sourceX = std::min(blockX * BlockSize + x, width - 1);
+            std::memcpy(&outBlock.Pixels[(y * BlockSize + x) * 4], &pixels[(static_cast<size_t>(sourceY) * width + sourceX) * 4], 4);
+        }
+    }
+}
+
+static void ComputeBlockBounds(const PixelBlock& block, uint8_t outMin[4], uint8_t outMax[4])
+{
+#if TEXTURE_COMPRESSION_SSE
+    const __m128i* rows = reinterpret_cast<const __m128i*>(block.Pixels);
+    __m128i row0 = _mm_load_si128(&rows[0]);
+    __m128i row1 = _mm_load_si128(&rows[1]);
+    __m128i row2 = _mm_load_si128(&rows[2]);
+    __m128i row3 = _mm_load_si128(&rows[3]);
+
+    __m128i minPixels = _mm_min_epu8(_mm_min_epu8(row0, row1), _mm_min_epu8(row2, row3));
+    __m128i maxPixels = _mm_max_epu8(_mm_max_epu8(row0, row1), _mm_max_epu8(row2, row3));
+
+    // reduce 4 pixels left in register to single one
+    minPixels = _mm_min_epu8(minPixels, _mm_shuffle_epi32(minPixels, _MM_SHUFFLE(1, 0, 3, 2)));
+    minPixels = _mm_min_epu8(minPixels, _mm_shuffle_epi32(minPixels, _MM_SHUFFLE(2, 3, 0, 1)));
+    maxPixels = _mm_max_epu8(maxPixels, _mm_shuffle_epi32(maxPixels, _MM_SHUFFLE(1, 0, 3, 2)));
+    maxPixels = _mm_max_epu8(maxPixels, _mm_shuffle_epi32(maxPixels, _MM_SHUFFLE(2, 3, 0, 1)));
+
+    int32_t minPixel = _mm_cvtsi128_si32(minPixels);
+    int32_t maxPixel = _mm_cvtsi128_si32(maxPixels);
+    std::memcpy(outMin, &minPixel, 4);
+    std::memcpy(outMax, &maxPixel, 4);
+#else
+    for (int channel = 0; channel < 4; ++channel)
+    {
+        outMin[channel] = 255;
+        outMax[channel] = 0;
+
+        for (int i = 0; i < NumBlockPixels; ++i)
+        {
+            outMin[channel] = std::min(outMin[channel], block.Pixels[i * 4 + channel]);
+            outMax[channel] = std::max(outMax[channel], block.Pixels[i * 4 + channel]);
+        }
+    }
+#endif
+}
+
+// Computes dot product of (pixel - origin) and axis for each pixel of block
+static void ProjectPixels(const PixelBlock& block, const int origin[3], const int axis[3], int outDots[NumBlockPixels])
+{
+#if TEXTURE_COMPRESSION_SSE
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i originPair = _mm_setr_epi16(static_cast<short>(origin[0]), static_cast<short>(origin[1]), static_cast<short>(origin[2]), 0,
+        static_cast<short>(origin[0]), static_cast<short>(origin[1]), static_cast<short>(origin[2]), 0);
+    const __m128i axisPair = _mm_setr_epi16(static_cast<short>(axis[0]), static_cast<short>(axis[1]), static_cast<short>(axis[2]), 0,
+        static_cast<short>(axis[0]), static_cast<short>(axis[1]), static_cast<short>(axis[2]), 0);
+
+    for (int i = 0; i < NumBlockPixels; i += 4)
+    {
+        __m128i pixels = _mm_load_si128(reinterpret_cast<const __m128i*>(&block.Pixels[i * 4]));
+
+        // two pixels per register with 16 bit channels. Alpha is multiplied by 0, so it doesn't affect result
+        __m128i low = _mm_sub_epi16(_mm_unpacklo_epi8(pixels, zero), originPair);
+        __m128i high = _mm_sub_epi16(_mm_unpackhi_epi8(pixels, zero), originPair);
+
+        // each pixel gives 2 partial sums, r * x + g * y and b * z
+        __m128 lowSums = _mm_castsi128_ps(_mm_madd_epi16(low, axisPair));
+        __m128 highSums = _mm_castsi128_ps(_mm_madd_epi16(high, axisPair));
+
+        __m128i firstSums = _mm_castps_si128(_mm_shuffle_ps(lowSums, highSums, _MM_SHUFFLE(2, 0, 2, 0)));
+        __m128i secondSums = _mm_castps_si128(_mm_shuffle_ps(lowSums, highSums, _MM_SHUFFLE(3, 1, 3, 1)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&outDots[i]), _mm_add_epi32(firstSums, secondSums));
+    }
+#else
+    for (int i = 0; i < NumBlockPixels; ++i)
+    {
+        const uint8_t* pixel = &block.Pixels[i * 4];
+        outDots[i] = (pixel[0] - origin[0]) * axis[0] + (pixel[1] - origin[1]) * axis[1] + (pixel[2] - origin[2]) * axis[2];
+    }
+#endif
+}
+
+static uint16_t PackRgb565(const int color[3])
+{
+    int r = (color[0] * 31 + 127) / 255;
+    int g = (color[1] * 63 + 127) / 255;
+    int b = (color[2] * 31 + 127) / 255;
+
+    return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+}
+
+static void UnpackRgb565(uint16_t packedColor, int outColor[3])
+{
+    int r = (packedColor >> 11) & 31;
+    int g = (packedColor >> 5) & 63;
+    int b = packedColor & 31;
+
+    outColor[0] = (r << 3) | (r >> 2);
+    outColor[1] = (g << 2) | (g >> 4);
+    outColor[2] = (b << 3) | (b >> 2);
+}
+
+// Endpoints are picked on diagonal of bounding box along which colors vary. Direction of diagonal is taken
+// from covariance of red and blue with green
+static void SelectColorEndpoints(const PixelBlock& block, const uint8_t minColor[4], const uint8_t maxColor[4], int outStart[3], int outEnd[3])
+{
+    int center[3];
+    int covarianceRedGreen = 0;
+    int covarianceBlueGreen = 0;
+
+    for (int channel = 0; channel < 3; ++channel)
+    {
+        center[channel] = (minColor[channel] + maxColor[channel]) / 2;
+        outStart[channel] = maxColor[channel];
+        outEnd[channel] = minColor[channel];
+    }
+
+    for (int i = 0; i < NumBlockPixels; ++i)
+    {
+        const uint8_t* pixel = &block.Pixels[i * 4];
+        int green = pixel[1] - center[1];
+        covarianceRedGreen += (pixel[0] - center[0]) * green;
+        covarianceBlueGreen += (pixel[2] - center[2]) * green;
+    }
+
+    if (covarianceRedGreen < 0)
+    {
+        std::swap(outStart[0], outEnd[0]);
+    }
+
+    if (covarianceBlueGreen < 0)
+    {
+        std::swap(outStart[2], outEnd[2]);
+    }
+
+    // endpoints are moved slightly inside bounding box, so few outliers don't waste the palette
+    for (int channel = 0; channel < 3; ++channel)
+    {
+        int inset = (outStart[channel] - outEnd[channel]) / 16;
+        outStart[channel] -= inset;
+        outEnd[channel] += inset;
+    }
+}
+
+static void EncodeColorBlock(const PixelBlock& block, const uint8_t minColor[4], const uint8_t maxColor[4], uint8_t* outBlock)
+{
+    int start[3];
+    int end[3];
+    SelectColorEndpoints(block, minColor, maxColor, start, end);
+
+    uint16_t color0 = PackRgb565(start);
+    uint16_t color1 = PackRgb565(end);
+    uint32_t indices = 0;
+
+    // color0 > color1 selects mode with 4 colors in BC1
+    if (color0 < color1)
+    {
+        std::swap(color0, color1);
+    }
+
+    if (color0 != color1)
+    {
+        int endpoint0[3];
+        int endpoint1[3];
+        UnpackRgb565(color0, endpoint0);
+        UnpackRgb565(color1, endpoint1);
+
+        int axis[3] = {endpoint1[0] - endpoint0[0], endpoint1[1] - endpoint0[1], endpoint1[2] - endpoint0[2]};
+        int axisLengthSquared = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+
+        int dots[NumBlockPixels];
+        ProjectPixels(block, endpoint0, axis, dots);
+
+        // palette goes color0, 2/3 color0 + 1/3 color1, 1/3 color0 + 2/3 color1, color1
+        constexpr uint32_t StepToIndex[4] = {0, 2, 3, 1};
+
+        for (int i = 0; i < NumBlockPixels; ++i)
+        {
+            int step = std::clamp((dots[i] * 3 + axisLengthSquared / 2) / axisLengthSquared, 0, 3);
+            indices |= StepToIndex[step] << (2 * i);
+        }
+    }
+
+    std::memcpy(&outBlock[0], &color0, sizeof(color0));
+    std::memcpy(&outBlock[2], &color1, sizeof(color1));
+    std::memcpy(&outBlock[4], &indices, sizeof(indices));
+}
+
+// Encodes single channel of block as BC4 block with 8 interpolated values between min and max
+static void EncodeChannelBlock(const PixelBlock& block, int channel, uint8_t minValue, uint8_t maxValue, uint8_t* outBlock)
+{
+    outBlock[0] = maxValue;
+    outBlock[1] = minValue;
+    uint64_t indices = 0;
+
+    if (maxValue > minValue)
+    {
+        int range = maxValue - minValue;
+
+        for (int i = 0; i < NumBlockPixels; ++i)
+        {
+            // step 0 is max value and 7 is min value, interpolated values have indices 2-7
+            int step = ((maxValue - block.Pixels[i * 4 + channel]) * 7 + range / 2) / range;
+            uint64_t index = step == 0 ? 0 : (step == 7 ? 1 : step + 1);
+            indices |= index << (3 * i);
+        }
+    }
+
+    std::memcpy(&outBlock[2], &indices, 6);
+}
+
+static void EncodeBlock(TextureFormat format, const PixelBlock& block, uint8_t* outBlock)
+{
+    uint8_t minColor[4];
+    uint8_t maxColor[4];
+    ComputeBlockBounds(block, minColor, maxColor);
+
+    switch (format)
+    {
+    case TextureFormat::Bc1:
+        EncodeColorBlock(block, minColor, maxColor, outBlock);
+        break;
+    case TextureFormat::Bc3:
+        EncodeChannelBlock(block, 3, minColor[3], maxColor[3], outBlock);
+        EncodeColorBlock(block, minColor, maxColor, outBlock + 8);
+        break;
+    case TextureFormat::Bc5:
+        EncodeChannelBlock(block, 0, minColor[0], maxColor[0], outBlock);
+        EncodeChannelBlock(block, 1, minColor[1], maxColor[1], outBlock + 8);
+        break;
+    default:
+        break;
+    }
+}
+
+bool IsCompressedTextureFormat(TextureFormat format)
+{
+    return format == TextureFormat::Bc1 || format == TextureFormat::Bc3 || format == TextureFormat::Bc5;
+}
+
+size_t GetCompressedImageSize(TextureFormat format, int width, int height)
+{
+    size_t numBlocksX = (width + BlockSize - 1) / BlockSize;
+    size_t numBlocksY = (height + BlockSize - 1) / BlockSize;
+
+    return numBlocksX * numBlocksY * GetBlockSizeInBytes(format);
+}
+
+size_t CompressedImage::GetSizeInBytes() const
+{
+    size_t numBytes = 0;
+
+    for (std::span<const std::byte> mipLevel : MipLevels)
+    {
+        numBytes += mipLevel.size();
+    }
+
+    return numBytes;
+}
+
+// Block rows encoded by single task of thread pool
+constexpr int NumBlockRowsPerTask = 8;
+
+static void EncodeImageBlocks(const ImageRgba& image, TextureFormat format, uint8_t* blocks, ThreadPool* threadPool)
+{
+    int numBlocksX = (image.GetWidth() + BlockSize - 1) / BlockSize;
+    int numBlockRows = (image.GetHeight() + BlockSize - 1) / BlockSize;
+    size_t blockSizeInBytes = GetBlockSizeInBytes(format);
+
+    auto encodeRows = [&](int firstRow, int lastRow)
+    {
+        PixelBlock block;
+
+        for (int row = firstRow; row < lastRow; ++row)
+        {
+            for (int blockX = 0; blockX < numBlocksX; ++blockX)
+            {
+                LoadPixelBlock(image, blockX, row, block);
+                EncodeBlock(format, block, &blocks[(static_cast<size_t>(row) * numBlocksX + blockX) * blockSizeInBytes]);
+            }
+        }
+    };
+
+    if (threadPool == nullptr || numBlockRows <= NumBlockRowsPerTask)
+    {
+        encodeRows(0, numBlockRows);
+        return;
+    }
+
+    // block rows are independent, so they're shared with pool's threads instead of starting new ones
+    int numTasks = (numBlockRows + NumBlockRowsPerTask - 1) / NumBlockRowsPerTask;
+
+    threadPool->ParallelFor(numTasks, [&](int task)
+    {
+        int firstRow = task * NumBlockRowsPerTask;
+        encodeRows(firstRow, std::min(firstRow + NumBlockRowsPerTask, numBlockRows));
+    });
+}
+
+CompressedImage CompressImage(const ImageRgba& image, TextureFormat format, ThreadPool* threadPool)
+{
+    ASSERT(IsCompressedTextureFormat(format));
+
+    CompressedImage compressed;
+    compressed.Format = format;
+    compressed.Width = image.GetWidth();
+    compressed.Height = image.GetHeight();
+
+    if (image.GetWidth() <= 0 || image.GetHeight() <= 0)
+    {
+        return compressed;
+    }
+
+    std::vector<ImageRgba> mips = GenerateMipChain(image, format != TextureFormat::Bc5);
+    int numLevels = static_cast<int>(mips.size()) + 1;
+    std::vector<size_t> levelOffsets;
+    size_t numBytes = 0;
+
+    for (int level = 0; level < numLevels; ++level)
+    {
+        levelOffsets.push_back(numBytes);
+        numBytes += GetCompressedImageSize(format, GetMipSize(image.GetWidth(), level), GetMipSize(image.GetHeight(), level));
+    }
+
+    // all levels are stored in single allocation, so they're written to cache file at once
+    compressed.EncodedBlocks.resize(numBytes);
+
+    for (int level = 0; level < numLevels; ++level)
+    {
+        const ImageRgba& levelImage = level == 0 ? image : mips[level - 1];
+        std::byte* levelBlocks = compressed.EncodedBlocks.data() + levelOffsets[level];
+
+        EncodeImageBlocks(levelImage, format, reinterpret_cast<uint8_t*>(levelBlocks), threadPool);
+        compressed.MipLevels.emplace_back(levelBlocks, GetCompressedImageSize(format, levelImage.GetWidth(), levelImage.GetHeight()));
+    }
+
+    return compressed;
+}
+
+bool CompressedTextureHeader::IsValid() const
+{
+    return Magic == CompressedTextureMagic && Version == CompressedTextureVersion && IsCompressedTextureFormat(Format) &&
+        NumMips >= 1 && NumMips <= GetNumMipLevels(Width, Height);
+}
+
+static TextureFormat GetRequestedFormat(TextureCompression compression)
+{
+    switch (compression)
+    {
+    case TextureCompression::Bc3:
+        return TextureFormat::Bc3;
+    case TextureCompression::Bc5:
+        return TextureFormat::Bc5;
+    default:
+        return TextureFormat::Bc1;
+    }
+}
+
+static bool IsImageOpaque(const ImageRgba& image)
+{
+    const uint8_t* pixels = image.GetRawImageData();
+
+    for (size_t i = 3; i < image.GetSizeInBytes(); i += 4)
+    {
+        if (pixels[i] != 255)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool ReadCachedCompressedImage(const std::filesystem::path& filePath, const DerivedDataKey& key, CompressedImage& outImage)
+{
+    outImage.CachedFile = DerivedDataCache::Load(key);
+
+    if (!outImage.CachedFile.IsOpen())
+    {
+        return false;
+    }
+
+    BinaryReader reader{DerivedDataCache::GetPayload(outImage.CachedFile)};
+    CompressedTextureHeader header = reader.Read<CompressedTextureHeader>();
+
+    if (!header.IsValid())
+    {
+        ENG_LOG_INFO("Compressed texture of {} has different layout", filePath.string());
+        return false;
+    }
+
+    outImage.Format = header.Format;
+    outImage.Width = header.Width;
+    outImage.Height = header.Height;
+
+    for (int level = 0; level < header.NumMips; ++level)
+    {
+        std::span<const std::byte> levelBlocks = reader.ReadArray<std::byte>();
+        size_t expectedSize = GetCompressedImageSize(header.Format, GetMipSize(header.Width, level), GetMipSize(header.Height, level));
+
+        if (reader.HasFailed() || levelBlocks.size() != expectedSize)
+        {
+            ENG_LOG_WARNING("Compressed texture of {} is corrupted", filePath.string());
+            return false;
+        }
+
+        outImage.MipLevels.emplace_back(levelBlocks);
+    }
+
+    return true;
+}
+
+CompressedImage LoadCompressedImageFromFile(const std::filesystem::path& filePath, TextureCompression compression, ThreadPool* threadPool)
+{
+    ASSERT(compression != TextureCompression::None);
+
+    CompressedImage image;
+
+    // requested compression is part of key, so Auto and explicit formats don't share entries
+    std::optional<DerivedDataKey> key = DerivedDataCache::MakeKeyFromFile("CompressedTexture", CompressedTextureVersion,
+        static_cast<uint64_t>(compression), filePath);
+
+    // encoding is slow, so it's done only once and result is cached for next runs
+    if (key && ReadCachedCompressedImage(filePath, *key, image))
+    {
+        ENG_LOG_VERBOSE("Loaded compressed texture {}", filePath.string());
+        return image;
+    }
+
+    ImageRgba sourceImage = LoadRgbaImageFromFile(filePath);
+    TextureFormat format = GetRequestedFormat(compression);
+
+    if (compression == TextureCompression::Auto)
+    {
+        format = IsImageOpaque(sourceImage) ? TextureFormat::Bc1 : TextureFormat::Bc3;
+    }
+
+    image = CompressImage(sourceImage, format, threadPool);
+
+    if (!key)
+    {
+        return image;
+    }
+
+    CompressedTextureHeader header;
+    header.Format = format;
+    header.Width = image.Width;
+    header.Height = image.Height;
+    header.NumMips = image.GetNumMips();
+
+    BinaryWriter writer;
+    writer.Write(header);
+
+    for (std::span<const std::byte> mipLevel : image.MipLevels)
+    {
+        writer.WriteArray(mipLevel);
+    }
+
+    DerivedDataCache::Store(*key, writer.GetData());
+
+    return image;
+}
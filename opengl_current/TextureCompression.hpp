@@ -0,0 +1,83 @@
+#pragma once
+
+#include "Texture.hpp"
+#include "ImageRgba.hpp"
+#include "MappedFile.hpp"
+#include "MipChain.hpp"
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+#include <vector>
+
+// SSE2 is baseline on x64, so encoder uses it unless compiled for architecture without it
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TEXTURE_COMPRESSION_SSE 1
+#else
+#define TEXTURE_COMPRESSION_SSE 0
+#endif
+
+class ThreadPool;
+
+inline constexpr uint32_t CompressedTextureMagic = 0x58544342; // "BCTX"
+
+// Increase when encoder changes, so old cached textures are encoded again
+inline constexpr uint32_t CompressedTextureVersion = 3;
+
+// Compression requested for texture. Auto picks BC1 for opaque images and BC3 for images with alpha
+enum class TextureCompression
+{
+    None,
+    Auto,
+    Bc1,
+    Bc3,
+    Bc5
+};
+
+// Image with full mip chain encoded to 4x4 blocks. Levels point either to encoded data or to mapped cache file
+struct CompressedImage
+{
+    TextureFormat Format{TextureFormat::Bc1};
+
+    // size of level 0
+    int Width{0};
+    int Height{0};
+    std::vector<std::span<const std::byte>> MipLevels;
+
+    std::vector<std::byte> EncodedBlocks;
+    MappedFile CachedFile;
+
+    int GetNumMips() const
+    {
+        return static_cast<int>(MipLevels.size());
+    }
+
+    size_t GetSizeInBytes() const;
+};
+
+// Header at start of compressed texture stored in derived data cache. Stale data is detected by key of cache
+struct CompressedTextureHeader
+{
+    uint32_t Magic{CompressedTextureMagic};
+    uint32_t Version{CompressedTextureVersion};
+    TextureFormat Format{TextureFormat::Bc1};
+    int32_t Width{0};
+    int32_t Height{0};
+    int32_t NumMips{0};
+
+    bool IsValid() const;
+};
+
+bool IsCompressedTextureFormat(TextureFormat format);
+
+// Returns number of bytes taken by image of given size encoded to block format
+size_t GetCompressedImageSize(TextureFormat format, int width, int height);
+
+// Generates full mip chain of image and encodes it to BC1, BC3 or BC5 (red and green channels). Block rows
+// are split between calling thread and threads of pool, when it's given. BC5 is meant for normal maps,
+// so its mips are filtered linearly, others in sRGB
+CompressedImage CompressImage(const ImageRgba& image, TextureFormat format, ThreadPool* threadPool = nullptr);
+
+// Loads image encoded by previous run from derived data cache or decodes and encodes the source file and caches
+// result with all mips, so loading doesn't filter anything. Can be called from loading threads
+CompressedImage LoadCompressedImageFromFile(const std::filesystem::path& filePath, TextureCompression compression, ThreadPool* threadPool = nullptr);
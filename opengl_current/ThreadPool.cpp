@@ -0,0 +1,119 @@
+#include "ThreadPool.hpp"
+#include "Logging.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+ThreadPool::ThreadPool(int numThreads)
+{
+    m_Threads.reserve(numThreads);
+
+    for (int i = 0; i < numThreads; ++i)
+    {
+        m_Threads.emplace_back(&ThreadPool::RunWorker, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard lock{m_TasksMutex};
+        m_bStopping = true;
+    }
+
+    m_TaskQueued.notify_all();
+
+    for (std::thread& thread : m_Threads)
+    {
+        thread.join();
+    }
+}
+
+void ThreadPool::Enqueue(std::function<void()> task)
+{
+    {
+        std::lock_guard lock{m_TasksMutex};
+        m_Tasks.emplace(std::move(task));
+    }
+
+    m_TaskQueued.notify_one();
+}
+
+void ThreadPool::ParallelFor(int numItems, const std::function<void(int)>& body)
+{
+    // helpers may start after all items are done, so state they touch is shared, body is used only while items remain
+    struct ParallelForState
+    {
+        std::atomic<int> NextItem{0};
+        std::atomic<int> NumDoneItems{0};
+        int NumItems{0};
+        const std::function<void(int)>* Body{nullptr};
+        std::mutex Mutex;
+        std::condition_variable AllItemsDone;
+    };
+
+    if (numItems <= 0)
+    {
+        return;
+    }
+
+    std::shared_ptr<ParallelForState> state = std::make_shared<ParallelForState>();
+    state->NumItems = numItems;
+    state->Body = &body;
+
+    auto processItems = [](ParallelForState& sharedState)
+    {
+        for (int item = sharedState.NextItem++; item < sharedState.NumItems; item = sharedState.NextItem++)
+        {
+            (*sharedState.Body)(item);
+
+            if (++sharedState.NumDoneItems == sharedState.NumItems)
+            {
+                std::lock_guard lock{sharedState.Mutex};
+                sharedState.AllItemsDone.notify_all();
+            }
+        }
+    };
+
+    for (int i = 0; i < std::min(GetNumThreads(), numItems - 1); ++i)
+    {
+        Enqueue([state, processItems]() { processItems(*state); });
+    }
+
+    processItems(*state);
+
+    std::unique_lock lock{state->Mutex};
+    state->AllItemsDone.wait(lock, [&state]() { return state->NumDoneItems == state->NumItems; });
+}
+
+void ThreadPool::RunWorker()
+{
+    while (true)
+    {
+        std::function<void()> task;
+
+        {
+            std::unique_lock lock{m_TasksMutex};
+            m_TaskQueued.wait(lock, [this]() { return m_bStopping || !m_Tasks.empty(); });
+
+            if (m_bStopping)
+            {
+                return;
+            }
+
+            task = std::move(m_Tasks.front());
+            m_Tasks.pop();
+        }
+
+        // exception would terminate whole program, so it's only logged
+        try
+        {
+            task();
+        }
+        catch (const std::exception& e)
+        {
+            ENG_LOG_ERROR("Task of thread pool failed: {}", e.what());
+        }
+    }
+}
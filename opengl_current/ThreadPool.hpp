@@ -0,0 +1,41 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// Fixed number of worker threads running queued tasks in order they were queued.
+// Tasks that didn't start before pool is destroyed are dropped
+class ThreadPool
+{
+public:
+    ThreadPool(int numThreads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void Enqueue(std::function<void()> task);
+
+    // Calls body for each item in [0, numItems) and returns when all are done. Calling thread processes items too,
+    // so it can be called from task of the same pool without waiting for free worker. Body must not throw
+    void ParallelFor(int numItems, const std::function<void(int)>& body);
+
+    int GetNumThreads() const
+    {
+        return static_cast<int>(m_Threads.size());
+    }
+
+private:
+    std::vector<std::thread> m_Threads;
+    std::queue<std::function<void()>> m_Tasks;
+    std::mutex m_TasksMutex;
+    std::condition_variable m_TaskQueued;
+    bool m_bStopping{false};
+
+private:
+    void RunWorker();
+};
@@ -34,3 +34,8 @@ void UniformBuffer::Bind(int binding_id) const
 {
     glBindBufferBase(GL_UNIFORM_BUFFER, binding_id, m_RendererId);
 }
+
+void UniformBuffer::BindRange(int bindingId, int offset, int sizeBytes) const
+{
+    glBindBufferRange(GL_UNIFORM_BUFFER, bindingId, m_RendererId, offset, sizeBytes);
+}
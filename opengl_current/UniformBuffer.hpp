@@ -25,6 +25,9 @@ public:
 
     void Bind(int bindingId) const;
 
+    // Binds only part of buffer, offset must be multiple of GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+    void BindRange(int bindingId, int offset, int sizeBytes) const;
+
     static inline size_t s_NumBytesAllocated = 0;
 
 private:
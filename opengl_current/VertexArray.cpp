@@ -44,12 +44,12 @@ FORCE_INLINE static int GetLookupIndex(VertexAttribute attribute)
     return static_cast<int>(attribute.VertexType);
 }
 
-void VertexArray::AddVertexBuffer(const std::shared_ptr<VertexBuffer>& vertexBuffer, AttributesView attributes)
+void VertexArray::AddVertexBuffer(const std::shared_ptr<VertexBuffer>& vertexBuffer, AttributesView attributes, uint32_t divisor)
 {
     constexpr int MaxAttributes = static_cast<int>(PrimitiveVertexType::MaxPrimitiveVertexType);
 
-    // start index for new buffer
-    int attributeStartIndex = GetContainerSizeInt(m_VertexBuffers);
+    // attributes of new buffer follow attributes of previous buffers
+    int attributeStartIndex = GetContainerSizeInt(m_Attributes);
     int stride = 0;
 
     constexpr uintptr_t AttributeSizes[MaxAttributes] = {sizeof(int), sizeof(uint32_t), sizeof(float)};
@@ -91,6 +91,7 @@ void VertexArray::AddVertexBuffer(const std::shared_ptr<VertexBuffer>& vertexBuf
         ASSERT(size_index < MaxAttributes);
 
         offset += attribute.NumComponents * AttributeSizes[size_index];
+        glVertexAttribDivisor(attributeStartIndex, divisor);
         attributeStartIndex++;
     }
 
@@ -42,7 +42,8 @@ public:
     std::shared_ptr<VertexBuffer> GetVertexBufferAt(int index);
     std::shared_ptr<IndexBuffer> GetIndexBuffer();
 
-    void AddVertexBuffer(const std::shared_ptr<VertexBuffer>& vertexBuffer, AttributesView attributes);
+    // Attributes of buffer with divisor above 0 advance once per that many instances instead of once per vertex
+    void AddVertexBuffer(const std::shared_ptr<VertexBuffer>& vertexBuffer, AttributesView attributes, uint32_t divisor = 0);
     uint32_t GetOpenGlIdentifier() const;
 
     AttributesView GetAttributes() const;
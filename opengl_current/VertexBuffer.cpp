@@ -38,6 +38,12 @@ void VertexBuffer::Unbind() const
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
+void VertexBuffer::Orphan()
+{
+    glBindBuffer(GL_ARRAY_BUFFER, m_RendererId);
+    glBufferData(GL_ARRAY_BUFFER, m_BufferSize, nullptr, GL_DYNAMIC_DRAW);
+}
+
 void VertexBuffer::UpdateVertices(const void* buffer, int offset, int size)
 {
     glBindBuffer(GL_ARRAY_BUFFER, m_RendererId);
@@ -22,16 +22,20 @@ public:
     void UpdateVertices(const void* buffer, int offset, int size);
     void UpdateVertices(const void* buffer, int size);
 
+    // Gives buffer new storage, so following update doesn't wait until draws reading old contents finish.
+    // Used when whole dynamic buffer is written again each draw
+    void Orphan();
+
     template <typename T>
     void UpdateVertex(const T& vertex, int startIndex = 0)
     {
-        UpdateVertices(&vertex, sizeof(T), startIndex * sizeof(T));
+        UpdateVertices(&vertex, startIndex * sizeof(T), sizeof(T));
     }
 
     template <typename Container>
     void Update(const Container& vertices, int startIndex = 0)
     {
-        UpdateVertices(vertices.data(), GetContainerSizeInt(vertices) * sizeof(Container::value_type), startIndex * sizeof(Container::value_type));
+        UpdateVertices(vertices.data(), startIndex * sizeof(typename Container::value_type), GetContainerSizeInt(vertices) * sizeof(typename Container::value_type));
     }
 
     int GetVerticesSizeBytes() const;